@@ -6,6 +6,14 @@
 #include "Natrium/Graphics/ShaderModule.hpp"
 
 namespace Na {
+	struct ShaderCompileJob {
+		std::string_view path; // relative to the asset dir, or just a name if src is set
+		ShaderStageBits stage = ShaderStageBits::None;
+		std::string_view entry_point = "main";
+		std::string_view src = {}; // in-memory source, empty to read from path
+		std::vector<ShaderDefine> defines = {};
+	};
+
 	class AssetRegistry {
 	public:
 		AssetRegistry(const std::filesystem::path& asset_dir, const std::filesystem::path& shader_output_dir);
@@ -28,6 +36,10 @@ namespace Na {
 			return asset;
 		}
 
+		/// 
+		/// compiled binaries are cached in the shader output dir under the hash of their preprocessed source,
+		/// so unchanged shaders are never recompiled
+		/// 
 		ShaderModule create_shader_module_from_src(
 			const std::string_view& src_path,
 			ShaderStageBits stage,
@@ -41,13 +53,45 @@ namespace Na {
 			const std::string_view& entry_point = "main"
 		) const;
 
+		/// 
+		/// compiles src_path with the macros in defines, every define set is only compiled (or loaded from disk) once
+		/// and then kept in memory until free_shader_variants() (e.g. for hot reloading)
+		/// 
+		ShaderModule create_shader_variant(
+			const std::string_view& src_path,
+			ShaderStageBits stage,
+			const std::vector<ShaderDefine>& defines,
+			const std::string_view& entry_point = "main"
+		);
+
+		inline void free_shader_variants(void) { m_ShaderVariants.clear(); }
+
+		/// 
+		/// compiles the jobs on thread_count threads (0 = one per hardware thread) and returns their modules in order,
+		/// results are logged afterwards in job order and the first failed job throws
+		/// 
+		std::vector<ShaderModule> create_shader_modules(const ShaderCompileJob* jobs, u32 count, u32 thread_count = 0) const;
+
+		inline std::vector<ShaderModule> create_shader_modules(const std::initializer_list<ShaderCompileJob>& jobs, u32 thread_count = 0) const
+		{ return this->create_shader_modules(jobs.begin(), (u32)jobs.size(), thread_count); }
+
 		[[nodiscard]] inline std::filesystem::path& asset_dir(void) { return m_AssetDir; }
 		[[nodiscard]] inline const std::filesystem::path& asset_dir(void) const { return m_AssetDir; }
 		inline void set_asset_dir(const std::filesystem::path& asset_dir) { m_AssetDir = asset_dir; }
+	private:
+		ArrayVector<u32> _load_or_compile(
+			const ShaderString& src,
+			ShaderStageBits stage,
+			const std::string_view& entry_point,
+			ShaderCompileLog* log = nullptr
+		) const;
 	private:
 		std::unordered_map<std::string_view, AssetHandle<>> m_Assets;
 		std::filesystem::path m_AssetDir;
 		std::filesystem::path m_ShaderOutputDir;
+
+		// keyed by path, stage, entry point and the sorted define set
+		std::unordered_map<std::string, ArrayVector<u32>> m_ShaderVariants;
 	};
 } // namespace Na
 
@@ -9,6 +9,10 @@ namespace Na {
 		ImageAsset(void) = default;
 		inline ~ImageAsset(void) override { free(m_Data); }
 
+		/// 
+		/// keeps the channel count of the file (grey, grey + alpha, rgba) and 16 bit precision,
+		/// rgb images are expanded to rgba
+		/// 
 		static AssetHandle<ImageAsset> Load(const std::filesystem::path& path);
 
 		[[nodiscard]] inline void* data(void) const { return m_Data; }
@@ -17,11 +21,19 @@ namespace Na {
 		[[nodiscard]] inline int width(void) const { return m_Width; }
 		[[nodiscard]] inline int height(void) const { return m_Height; }
 
+		[[nodiscard]] inline u32 channels(void) const { return m_Channels; }
+		/// 
+		/// bytes per channel, either 1 or 2
+		/// 
+		[[nodiscard]] inline u32 channel_size(void) const { return m_ChannelSize; }
+		[[nodiscard]] inline u32 texel_size(void) const { return m_Channels * m_ChannelSize; }
+
 		[[nodiscard]] inline operator bool(void) const override { return m_Data; };
 	private:
 		void* m_Data;
 		u64 m_Size;
 		int m_Width, m_Height;
+		u32 m_Channels = 4, m_ChannelSize = 1;
 	};
 	using Image = ImageAsset;
 } // namespace Na
@@ -0,0 +1,62 @@
+#if !defined(NA_KTX2_ASSET_HPP)
+#define NA_KTX2_ASSET_HPP
+
+#include "Natrium/Assets/Asset.hpp"
+#include "Natrium/Core/MappedFile.hpp"
+
+namespace Na {
+	struct Ktx2Level {
+		u64 offset;
+		u64 size;
+	};
+
+	///
+	/// memory mapped KTX2 container, level data is handed out as is (no supercompression or transcoding),
+	/// cubemap faces are exposed as extra array layers
+	///
+	class Ktx2Asset : public Asset {
+	public:
+		Ktx2Asset(void) = default;
+		~Ktx2Asset(void) = default;
+
+		static AssetHandle<Ktx2Asset> Load(const std::filesystem::path& path);
+
+		[[nodiscard]] inline vk::Format format(void) const { return m_Format; }
+
+		[[nodiscard]] inline u32 width(void) const { return m_Width; }
+		[[nodiscard]] inline u32 height(void) const { return m_Height; }
+
+		[[nodiscard]] inline u32 layer_count(void) const { return m_LayerCount; }
+		[[nodiscard]] inline u32 level_count(void) const { return (u32)m_Levels.size(); }
+
+		///
+		/// the layers are groups of 6 faces
+		///
+		[[nodiscard]] inline bool is_cubemap(void) const { return m_Cubemap; }
+
+		///
+		/// a level count of 0 in the file means the mip chain is meant to be generated at load time
+		///
+		[[nodiscard]] inline bool wants_generated_mips(void) const { return m_GenerateMips; }
+
+		///
+		/// all layers of a level, tightly packed
+		///
+		[[nodiscard]] inline const Byte* level_data(u32 level) const { return m_File.data() + m_Levels[level].offset; }
+		[[nodiscard]] inline u64 level_size(u32 level) const { return m_Levels[level].size; }
+
+		[[nodiscard]] inline operator bool(void) const override { return m_File && !m_Levels.empty(); }
+	private:
+		MappedFile m_File;
+
+		vk::Format m_Format = vk::Format::eUndefined;
+		u32 m_Width = 0, m_Height = 0;
+		u32 m_LayerCount = 0;
+		bool m_GenerateMips = false;
+		bool m_Cubemap = false;
+
+		ArrayVector<Ktx2Level> m_Levels;
+	};
+} // namespace Na
+
+#endif // NA_KTX2_ASSET_HPP
\ No newline at end of file
@@ -8,26 +8,89 @@ namespace Na {
 		None = 0,
 		Vertex   = (u32)vk::ShaderStageFlagBits::eVertex,
 		Fragment = (u32)vk::ShaderStageFlagBits::eFragment,
+		Compute  = (u32)vk::ShaderStageFlagBits::eCompute,
 
 		All      = (u32)vk::ShaderStageFlagBits::eAll
 	};
 
+	struct ShaderDefine {
+		std::string name;
+		std::string value = {};
+
+		[[nodiscard]] inline bool operator<(const ShaderDefine& other) const { return name < other.name; }
+	};
+
+	/// 
+	/// compiler output collected instead of logged, so it can be reported later and from any thread
+	/// 
+	struct ShaderCompileLog {
+		std::string name;
+		std::string messages;
+		u64 warning_count = 0;
+		u64 error_count = 0;
+		bool success = true;
+		bool compiled = false; // false for cache hits
+
+		/// 
+		/// logs the result through g_Logger, throws if it failed
+		/// 
+		void report(void) const;
+	};
+
 	class ShaderString : public Asset {
 	public:
-		ShaderString(const std::string& data, const std::string& name) : m_Data(data), m_Name(name) {};
-		ShaderString(const std::string_view& data, const std::string_view& name) : m_Data(data), m_Name(name) {};
+		/// 
+		/// include_dir is where #include directives are resolved from
+		/// 
+		ShaderString(const std::string& data, const std::string& name, const std::filesystem::path& include_dir = {})
+		: m_Data(data), m_Name(name), m_IncludeDir(include_dir) {};
+		ShaderString(const std::string_view& data, const std::string_view& name, const std::filesystem::path& include_dir = {})
+		: m_Data(data), m_Name(name), m_IncludeDir(include_dir) {};
 		ShaderString(const std::filesystem::path& path);
 
 		static AssetHandle<ShaderString> Load(const std::filesystem::path& path) { return std::make_shared<ShaderString>(path);  }
 
-		[[nodiscard]] ArrayVector<u32> compile(const std::string_view& entry_point = "main") const;
+		/// 
+		/// stage ShaderStageBits::None infers the stage from #pragma shader_stage,
+		/// with a log nothing is logged or thrown and failures return an empty binary
+		/// 
+		[[nodiscard]] ArrayVector<u32> compile(
+			const std::string_view& entry_point = "main",
+			ShaderStageBits stage = ShaderStageBits::None,
+			ShaderCompileLog* log = nullptr
+		) const;
+
+		/// 
+		/// source with every #include and macro resolved, exactly what compile() sees
+		/// 
+		[[nodiscard]] std::string preprocess(ShaderStageBits stage = ShaderStageBits::None, ShaderCompileLog* log = nullptr) const;
+
+		/// 
+		/// hash of the preprocessed source, entry point, stage and compile options,
+		/// two shaders with the same hash compile to the same spir-v
+		/// 
+		[[nodiscard]] u64 content_hash(
+			const std::string_view& entry_point = "main",
+			ShaderStageBits stage = ShaderStageBits::None,
+			ShaderCompileLog* log = nullptr
+		) const;
+
+		/// 
+		/// defines a macro for every following preprocess/compile, as if by #define name value
+		/// 
+		inline ShaderString& define(const std::string_view& name, const std::string_view& value = {}) { m_Defines.emplace_back(std::string(name), std::string(value)); return *this; }
+		inline ShaderString& define(const ShaderDefine& define) { m_Defines.emplace_back(define); return *this; }
 
 		[[nodiscard]] inline const std::string& data(void) const { return m_Data; }
+		[[nodiscard]] inline const std::string& name(void) const { return m_Name; }
+		[[nodiscard]] inline const std::vector<ShaderDefine>& defines(void) const { return m_Defines; }
 
 		[[nodiscard]] inline operator bool(void) const override { return !m_Data.empty(); };
 	private:
 		std::string m_Data;
 		std::string m_Name;
+		std::filesystem::path m_IncludeDir;
+		std::vector<ShaderDefine> m_Defines;
 	};
 
 	class ShaderBinary : public Asset {
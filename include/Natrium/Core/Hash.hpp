@@ -0,0 +1,23 @@
+#if !defined(NA_HASH_HPP)
+#define NA_HASH_HPP
+
+#include "Natrium/Core.hpp"
+
+namespace Na {
+	inline constexpr u64 k_Fnv1aOffset = 0xcbf29ce484222325;
+
+	///
+	/// 64 bit fnv-1a, pass the previous result as hash to combine several pieces of data
+	///
+	[[nodiscard]] inline u64 Fnv1a(const void* data, u64 size, u64 hash = k_Fnv1aOffset)
+	{
+		for (u64 i = 0; i < size; i++)
+		{
+			hash ^= ((const Byte*)data)[i];
+			hash *= 0x100000001b3;
+		}
+		return hash;
+	}
+} // namespace Na
+
+#endif // NA_HASH_HPP
\ No newline at end of file
@@ -0,0 +1,39 @@
+#if !defined(NA_MAPPED_FILE_HPP)
+#define NA_MAPPED_FILE_HPP
+
+#include "Natrium/Core.hpp"
+
+namespace Na {
+	///
+	/// read only memory mapping of a whole file, pages are only read from disk once touched
+	///
+	class MappedFile {
+	public:
+		MappedFile(void) = default;
+		inline MappedFile(const std::filesystem::path& path) { this->map(path); }
+		inline ~MappedFile(void) { this->unmap(); }
+
+		MappedFile(const MappedFile& other) = delete;
+		MappedFile& operator=(const MappedFile& other) = delete;
+
+		MappedFile(MappedFile&& other);
+		MappedFile& operator=(MappedFile&& other);
+
+		void map(const std::filesystem::path& path);
+		void unmap(void);
+
+		[[nodiscard]] inline const Byte* data(void) const { return m_Data; }
+		[[nodiscard]] inline u64 size(void) const { return m_Size; }
+
+		[[nodiscard]] inline operator bool(void) const { return m_Data; }
+	private:
+		const Byte* m_Data = nullptr;
+		u64 m_Size = 0;
+	#if defined(NA_PLATFORM_WINDOWS)
+		void* m_File = nullptr;
+		void* m_Mapping = nullptr;
+	#endif // NA_PLATFORM_WINDOWS
+	};
+} // namespace Na
+
+#endif // NA_MAPPED_FILE_HPP
\ No newline at end of file
@@ -0,0 +1,48 @@
+#if !defined(NA_PARALLEL_FOR_HPP)
+#define NA_PARALLEL_FOR_HPP
+
+#include "Natrium/Core.hpp"
+
+#include <atomic>
+
+namespace Na {
+	[[nodiscard]] inline u32 HardwareThreadCount(void) { return std::max(std::thread::hardware_concurrency(), 1u); }
+
+	///
+	/// calls fn(i) for every i in [0, count) spread over thread_count threads (0 = one per hardware thread),
+	/// the calling thread takes part in the work and the call returns once every index has been processed
+	///
+	template<typename t_Fn>
+	void ParallelFor(u64 count, t_Fn&& fn, u32 thread_count = 0)
+	{
+		if (!thread_count)
+			thread_count = HardwareThreadCount();
+		thread_count = (u32)std::min<u64>(thread_count, count);
+
+		if (thread_count <= 1)
+		{
+			for (u64 i = 0; i < count; i++)
+				fn(i);
+			return;
+		}
+
+		std::atomic<u64> next_index = 0;
+		auto worker = [&](void)
+		{
+			for (u64 i = next_index++; i < count; i = next_index++)
+				fn(i);
+		};
+
+		std::vector<std::thread> threads;
+		threads.reserve(thread_count - 1);
+		for (u32 i = 0; i < thread_count - 1; i++)
+			threads.emplace_back(worker);
+
+		worker();
+
+		for (std::thread& thread : threads)
+			thread.join();
+	}
+} // namespace Na
+
+#endif // NA_PARALLEL_FOR_HPP
\ No newline at end of file
@@ -0,0 +1,39 @@
+#if !defined(NA_BINDLESS_TEXTURES_HPP)
+#define NA_BINDLESS_TEXTURES_HPP
+
+#include "Natrium/Graphics/Texture.hpp"
+#include "Natrium/Graphics/VkContext.hpp"
+
+namespace Na {
+	///
+	/// one large array of combined image samplers shared by every pipeline with PipelineState::bindless_textures
+	/// and every ComputePipeline whose shader samples it,
+	/// textures are registered once and picked in the shader by their index instead of binding each one,
+	/// needs VK_EXT_descriptor_indexing (VkContext::IsBindlessSupported)
+	///
+	/// glsl: layout(set = 1, binding = 0) uniform sampler2D u_Textures[];
+	///       texture(u_Textures[nonuniformEXT(index)], uv) with GL_EXT_nonuniform_qualifier
+	///
+	class BindlessTextures {
+	public:
+		static constexpr u32 k_Set = 1;
+
+		[[nodiscard]] static inline bool Supported(void) { return VkContext::IsBindlessSupported(); }
+
+		/// 
+		/// the texture has to stay alive until it's unregistered
+		/// 
+		[[nodiscard]] static u32 Register(const Texture& texture);
+
+		/// 
+		/// the index is handed out again only after the frames that could be sampling it have completed
+		/// 
+		static void Unregister(u32 index);
+
+		[[nodiscard]] static vk::DescriptorSetLayout GetLayout(void);
+		[[nodiscard]] static vk::DescriptorSet GetSet(void);
+		[[nodiscard]] static u32 GetCapacity(void);
+	};
+} // namespace Na
+
+#endif // NA_BINDLESS_TEXTURES_HPP
\ No newline at end of file
@@ -0,0 +1,43 @@
+#if !defined(NA_BLOCK_COMPRESSION_HPP)
+#define NA_BLOCK_COMPRESSION_HPP
+
+#include "Natrium/Core.hpp"
+
+namespace Na {
+	enum class BlockFormat : u8 {
+		None = 0,
+		BC1, // rgb, 1 bit alpha, 8 bytes per block
+		BC3, // rgba, 16 bytes per block
+		BC5, // rg, 16 bytes per block, meant for normal maps
+		BC7  // rgba, 16 bytes per block, highest quality
+	};
+
+	[[nodiscard]] vk::Format BlockFormatToVk(BlockFormat format, bool srgb);
+
+	[[nodiscard]] u32 BlockSize(BlockFormat format);
+
+	///
+	/// size in bytes of one 4x4 block for block compressed vulkan formats, 0 for everything else
+	///
+	[[nodiscard]] u32 BlockSize(vk::Format format);
+
+	[[nodiscard]] inline u64 BlockCount(u32 width, u32 height) { return (u64)((width + 3) / 4) * ((height + 3) / 4); }
+	[[nodiscard]] inline u64 CompressedSize(u32 width, u32 height, BlockFormat format) { return BlockCount(width, height) * BlockSize(format); }
+
+	[[nodiscard]] bool IsBlockFormatSupported(BlockFormat format, bool srgb);
+
+	///
+	/// encodes a tightly packed rgba8 image into dst (CompressedSize(width, height, format) bytes),
+	/// rows of blocks are spread over thread_count threads (0 = one per hardware thread)
+	///
+	void CompressBlocks(
+		const Byte* rgba,
+		u32 width,
+		u32 height,
+		BlockFormat format,
+		Byte* dst,
+		u32 thread_count = 0
+	);
+} // namespace Na
+
+#endif // NA_BLOCK_COMPRESSION_HPP
\ No newline at end of file
@@ -2,6 +2,8 @@
 #define NA_DEVICE_BUFFER
 
 #include "Natrium/Core.hpp"
+#include "Natrium/Graphics/DeviceAllocator.hpp"
+#include "Natrium/Graphics/Submission.hpp"
 
 namespace Na {
 	u32 FindMemoryType(u32 typeFilter, vk::MemoryPropertyFlags properties);
@@ -9,7 +11,7 @@ namespace Na {
 	public:
 		vk::Buffer buffer = nullptr;
 		vk::DeviceSize size = 0;
-		vk::DeviceMemory memory = nullptr;
+		DeviceAllocation memory;
 
 		DeviceBuffer(void) = default;
 		DeviceBuffer(
@@ -29,6 +31,22 @@ namespace Na {
 
 		void copy(const DeviceBuffer& other);
 
+		/// 
+		/// copies data in through the staging ring, for buffers that aren't host visible
+		/// 
+		void upload(const void* data, vk::DeviceSize data_size, vk::DeviceSize offset = 0);
+
+		/// 
+		/// same as upload but recorded on the transfer queue without waiting, the buffer mustn't be
+		/// read by the gpu before the token completes, submissions made after that see the data
+		/// 
+		[[nodiscard]] SubmissionToken upload_async(const void* data, vk::DeviceSize data_size, vk::DeviceSize offset = 0);
+
+		/// 
+		/// null unless the buffer was created host visible, stays valid until the buffer is destroyed
+		/// 
+		[[nodiscard]] inline Byte* mapped(void) const { return memory.mapped; }
+
 		[[nodiscard]] inline operator bool(void) const { return buffer && size && memory; }
 	};
 } // namespace Na
@@ -0,0 +1,71 @@
+#if !defined(NA_GEOMETRY_ARENA_HPP)
+#define NA_GEOMETRY_ARENA_HPP
+
+#include "Natrium/Graphics/Buffers/DeviceBuffer.hpp"
+
+namespace Na {
+	struct GeometryArenaState;
+
+	///
+	/// where a mesh lives inside its GeometryArena, drawn with Renderer::draw_geometry
+	///
+	struct GeometryRange {
+		i32 vertex_offset = 0; // added to every index, the mesh's indices start at 0
+		u32 vertex_count = 0;
+		u32 first_index = 0;
+		u32 index_count = 0;
+
+		[[nodiscard]] inline operator bool(void) const { return index_count; }
+	};
+
+	///
+	/// one large vertex buffer and one large index buffer that many meshes sub-allocate their ranges from,
+	/// a frame binds them once with Renderer::bind_geometry instead of a pair of buffers per draw,
+	/// every mesh in an arena shares its vertex layout
+	///
+	class GeometryArena {
+	public:
+		GeometryArena(void) = default;
+		GeometryArena(u32 vertex_stride, u32 vertex_capacity, u32 index_capacity);
+		void destroy(void);
+		inline ~GeometryArena(void) { this->destroy(); }
+
+		GeometryArena(const GeometryArena& other) = delete;
+		GeometryArena& operator=(const GeometryArena& other) = delete;
+
+		GeometryArena(GeometryArena&& other);
+		GeometryArena& operator=(GeometryArena&& other);
+
+		/// 
+		/// uploads through the staging ring, so it's recorded into an open CommandBatch,
+		/// throws if either buffer has no free range big enough left
+		/// 
+		[[nodiscard]] GeometryRange allocate(const void* vertices, u32 vertex_count, const u32* indices, u32 index_count);
+
+		/// 
+		/// the range is handed out again only after the frames that could be drawing it have completed
+		/// 
+		void free(const GeometryRange& range);
+
+		[[nodiscard]] inline u32 vertex_stride(void) const { return m_VertexStride; }
+		[[nodiscard]] inline u32 vertex_capacity(void) const { return m_VertexStride ? u32(m_VertexBuffer.size / m_VertexStride) : 0; }
+		[[nodiscard]] inline u32 index_capacity(void) const { return u32(m_IndexBuffer.size / sizeof(u32)); }
+
+		[[nodiscard]] u32 used_vertices(void) const;
+		[[nodiscard]] u32 used_indices(void) const;
+
+		[[nodiscard]] inline const DeviceBuffer& vertex_buffer(void) const { return m_VertexBuffer; }
+		[[nodiscard]] inline const DeviceBuffer& index_buffer(void) const { return m_IndexBuffer; }
+
+		[[nodiscard]] inline operator bool(void) const { return m_VertexBuffer; }
+	private:
+		DeviceBuffer m_VertexBuffer;
+		DeviceBuffer m_IndexBuffer;
+		u32 m_VertexStride = 0;
+
+		// shared with the deferred frees, which can outlive the arena
+		std::shared_ptr<GeometryArenaState> m_State;
+	};
+} // namespace Na
+
+#endif // NA_GEOMETRY_ARENA_HPP
\ No newline at end of file
@@ -0,0 +1,86 @@
+#if !defined(NA_INDIRECT_BUFFER_HPP)
+#define NA_INDIRECT_BUFFER_HPP
+
+#include "Natrium/Graphics/Buffers/DeviceBuffer.hpp"
+#include "Natrium/Graphics/Buffers/GeometryArena.hpp"
+#include "Natrium/Graphics/Renderer/RendererSettings.hpp"
+
+namespace Na {
+	class Renderer;
+
+	///
+	/// where an IndirectBuffer's commands are written
+	///
+	enum class IndirectBufferMode : u8 {
+		Host = 0, // pushed on the cpu into host visible memory
+		Device    // written by shaders into device local memory, the count is reset with clear
+	};
+
+	///
+	/// a region per frame in flight holding a draw count followed by indexed draw commands, filled on the cpu
+	/// with push or on the gpu by a shader writing the frame's region as a storage buffer,
+	/// drawn with Renderer::draw_indexed_indirect and Renderer::draw_indexed_indirect_count
+	///
+	/// glsl: layout(std430) buffer { uint count; uint pad[3]; DrawIndexedIndirectCommand commands[]; }
+	///
+	class IndirectBuffer {
+	public:
+		static constexpr u64 k_CommandsOffset = 16; // the count is padded so the commands keep std430 layout
+		static constexpr u64 k_CommandStride = sizeof(vk::DrawIndexedIndirectCommand);
+
+		IndirectBuffer(void) = default;
+		IndirectBuffer(u32 max_draws, const RendererSettings& renderer_settings, IndirectBufferMode mode = IndirectBufferMode::Host);
+		void destroy(void);
+		inline ~IndirectBuffer(void) { this->destroy(); }
+
+		IndirectBuffer(const IndirectBuffer& other) = delete;
+		IndirectBuffer& operator=(const IndirectBuffer& other) = delete;
+
+		IndirectBuffer(IndirectBuffer&& other);
+		IndirectBuffer& operator=(IndirectBuffer&& other);
+
+		/// 
+		/// appends to the current frame's commands and bumps its count, the first push of a new frame
+		/// starts the list over, returns the command's index, the first instance has to be 0
+		/// unless VkContext::IsDrawIndirectFirstInstanceSupported(), only for IndirectBufferMode::Host
+		/// 
+		u32 push(const Renderer& renderer, const vk::DrawIndexedIndirectCommand& command);
+
+		inline u32 push(const Renderer& renderer, const GeometryRange& range, u32 instance_count = 1, u32 first_instance = 0)
+		{ return this->push(renderer, vk::DrawIndexedIndirectCommand(range.index_count, instance_count, range.first_index, range.vertex_offset, first_instance)); }
+
+		/// 
+		/// zeroes the current frame's count for a shader that appends commands to the region,
+		/// the commands pushed so far this frame are dropped, device local buffers are cleared by
+		/// a fill recorded before the frame's first draw and visible to later dispatches
+		/// 
+		void clear(Renderer& renderer);
+
+		/// 
+		/// commands pushed during the renderer's current frame
+		/// 
+		[[nodiscard]] u32 draw_count(const Renderer& renderer) const;
+
+		[[nodiscard]] inline u64 frame_offset(u32 frame_index) const { return m_FrameStride * frame_index; }
+		[[nodiscard]] inline u64 frame_size(void) const { return k_CommandsOffset + k_CommandStride * m_MaxDraws; }
+		[[nodiscard]] inline u64 frame_stride(void) const { return m_FrameStride; }
+		[[nodiscard]] inline u32 max_draws(void) const { return m_MaxDraws; }
+		[[nodiscard]] inline IndirectBufferMode mode(void) const { return m_Mode; }
+
+		[[nodiscard]] inline operator bool(void) const { return m_Buffer; }
+
+		[[nodiscard]] inline const DeviceBuffer& buffer(void) const { return m_Buffer; }
+	private:
+		DeviceBuffer m_Buffer;
+
+		u64 m_FrameStride = 0;
+		u32 m_MaxDraws = 0;
+		IndirectBufferMode m_Mode = IndirectBufferMode::Host;
+
+		u32 m_Count = 0;
+		u64 m_FrameNumber = 0;
+		u32 m_FrameIndex = 0;
+	};
+} // namespace Na
+
+#endif // NA_INDIRECT_BUFFER_HPP
\ No newline at end of file
@@ -0,0 +1,81 @@
+#if !defined(NA_TRANSIENT_BUFFER_HPP)
+#define NA_TRANSIENT_BUFFER_HPP
+
+#include "Natrium/Graphics/Buffers/DeviceBuffer.hpp"
+#include "Natrium/Graphics/Pipeline.hpp"
+
+namespace Na {
+	class Renderer;
+
+	struct TransientAllocation {
+		u32 offset = 0; // dynamic offset into the whole buffer
+		Byte* data = nullptr;
+
+		[[nodiscard]] inline operator bool(void) const { return data; }
+	};
+
+	///
+	/// one persistently mapped buffer with a region per frame in flight, allocations are bumped off the
+	/// current frame's region and reused once that frame comes around again,
+	/// bound to a pipeline like a UniformBuffer and pointed at per draw with Renderer::set_transient_uniform
+	///
+	class TransientBuffer {
+	public:
+		TransientBuffer(void) = default;
+
+		/// 
+		/// range is the most a single allocation can hold, type has to be UniformBuffer or StorageBuffer
+		/// 
+		TransientBuffer(
+			u64 per_frame_capacity,
+			u64 range,
+			const RendererSettings& renderer_settings,
+			ShaderUniformType type = ShaderUniformType::UniformBuffer
+		);
+		void destroy(void);
+		inline ~TransientBuffer(void) { this->destroy(); }
+
+		TransientBuffer(const TransientBuffer& other) = delete;
+		TransientBuffer& operator=(const TransientBuffer& other) = delete;
+
+		TransientBuffer(TransientBuffer&& other);
+		TransientBuffer& operator=(TransientBuffer&& other);
+
+		/// 
+		/// the first allocation of a new frame starts over at the beginning of that frame's region
+		/// 
+		[[nodiscard]] TransientAllocation allocate(const Renderer& renderer, u64 size);
+
+		template<typename T>
+		[[nodiscard]] inline TransientAllocation push(const Renderer& renderer, const T& data)
+		{
+			TransientAllocation allocation = this->allocate(renderer, sizeof(T));
+			memcpy(allocation.data, &data, sizeof(T));
+			return allocation;
+		}
+
+		[[nodiscard]] inline u32 frame_offset(u32 frame_index) const { return u32(m_FrameStride * frame_index); }
+
+		[[nodiscard]] inline ShaderUniformType type(void) const { return m_Type; }
+		[[nodiscard]] inline u64 range(void) const { return m_Range; }
+		[[nodiscard]] inline u64 per_frame_capacity(void) const { return m_FrameStride; }
+		[[nodiscard]] inline u64 used(void) const { return m_Head; }
+
+		[[nodiscard]] inline operator bool(void) const { return m_Buffer; }
+
+		[[nodiscard]] inline const DeviceBuffer& buffer(void) const { return m_Buffer; }
+	private:
+		DeviceBuffer m_Buffer;
+		ShaderUniformType m_Type = ShaderUniformType::None;
+
+		u64 m_FrameStride = 0;
+		u64 m_Range = 0;
+		u64 m_Alignment = 0;
+
+		u64 m_Head = 0;
+		u64 m_FrameNumber = 0;
+		u32 m_FrameIndex = 0;
+	};
+} // namespace Na
+
+#endif // NA_TRANSIENT_BUFFER_HPP
\ No newline at end of file
@@ -0,0 +1,44 @@
+#if !defined(NA_COMMAND_BATCH_HPP)
+#define NA_COMMAND_BATCH_HPP
+
+#include "Natrium/Core.hpp"
+#include "Natrium/Graphics/Submission.hpp"
+
+namespace Na {
+	///
+	/// while a batch is open every single time command (buffer copies and uploads, image transitions,
+	/// copies and mipmap generation) is recorded into its command buffer instead of being submitted
+	/// and waited on one by one, nothing recorded into it has run before it's submitted
+	///
+	class CommandBatch {
+	public:
+		CommandBatch(void);
+
+		/// 
+		/// submits without waiting if submit hasn't been called
+		/// 
+		inline ~CommandBatch(void) { (void)this->submit(); }
+
+		CommandBatch(const CommandBatch& other) = delete;
+		CommandBatch& operator=(const CommandBatch& other) = delete;
+
+		/// 
+		/// closes the batch, an empty token if it was already submitted
+		/// 
+		SubmissionToken submit(void);
+
+		/// 
+		/// submits what has been recorded so far and keeps recording into a new command buffer,
+		/// also done by the staging ring when it's full of this batch's uploads
+		/// 
+		SubmissionToken flush(void);
+
+		[[nodiscard]] inline vk::CommandBuffer cmd_buffer(void) const { return m_CmdBuffer; }
+
+		[[nodiscard]] inline operator bool(void) const { return m_CmdBuffer; }
+	private:
+		vk::CommandBuffer m_CmdBuffer = nullptr;
+	};
+} // namespace Na
+
+#endif // NA_COMMAND_BATCH_HPP
\ No newline at end of file
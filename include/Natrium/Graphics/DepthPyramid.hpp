@@ -0,0 +1,66 @@
+#if !defined(NA_DEPTH_PYRAMID_HPP)
+#define NA_DEPTH_PYRAMID_HPP
+
+#include "Natrium/Graphics/Pipeline.hpp"
+
+namespace Na {
+	class Renderer;
+
+	///
+	/// mip chain of the previous frame's depth where every texel holds the farthest depth under it, level 0 is
+	/// the depth buffer's size rounded down to powers of two, kept in eGeneral for compute shaders to test against,
+	/// needs RendererSettings::keep_depth_for_culling
+	///
+	/// glsl: layout(binding = n) uniform sampler2D u_Pyramid; texelFetch(u_Pyramid, texel, level).r
+	///
+	class DepthPyramid {
+	public:
+		DepthPyramid(void) = default;
+		DepthPyramid(const RendererSettings& renderer_settings);
+		void destroy(void);
+		inline ~DepthPyramid(void) { this->destroy(); }
+
+		DepthPyramid(const DepthPyramid& other) = delete;
+		DepthPyramid& operator=(const DepthPyramid& other) = delete;
+
+		DepthPyramid(DepthPyramid&& other);
+		DepthPyramid& operator=(DepthPyramid&& other);
+
+		/// 
+		/// records the reduction before the frame's first draw, recreating the pyramid along with the depth buffer,
+		/// false if there's no previous depth to build from (see Renderer::acquire_previous_depth),
+		/// the content is meaningless until the next successful build then
+		/// 
+		bool build(Renderer& renderer);
+
+		/// 
+		/// the whole chain, read with texelFetch
+		/// 
+		[[nodiscard]] inline ImageUniform uniform(void) const { return { ShaderUniformType::Texture, m_View, m_Sampler, vk::ImageLayout::eGeneral }; }
+
+		[[nodiscard]] inline u32 width(void) const { return m_Image.width; }
+		[[nodiscard]] inline u32 height(void) const { return m_Image.height; }
+		[[nodiscard]] inline u32 mip_levels(void) const { return m_Image.mip_levels(); }
+
+		[[nodiscard]] inline const DeviceImage& img(void) const { return m_Image; }
+
+		[[nodiscard]] inline operator bool(void) const { return m_Reduce; }
+	private:
+		void _create_image(const RendererCore& renderer_core);
+		void _destroy_image(void);
+	private:
+		ComputePipeline m_Reduce;
+		ComputePipeline m_ReduceMultisampled; // level 0 of a multisampled depth buffer
+
+		DeviceImage m_Image;
+		vk::ImageView m_View;
+		ArrayVector<vk::ImageView> m_LevelViews;
+		vk::Sampler m_Sampler;
+
+		u64 m_DepthGeneration = 0;
+		u64 m_BuiltFrame = 0;
+		bool m_Built = false;
+	};
+} // namespace Na
+
+#endif // NA_DEPTH_PYRAMID_HPP
\ No newline at end of file
@@ -0,0 +1,60 @@
+#if !defined(NA_DESCRIPTOR_ALLOCATOR_HPP)
+#define NA_DESCRIPTOR_ALLOCATOR_HPP
+
+#include "Natrium/Graphics/Vulkan.hpp"
+
+namespace Na {
+	struct ShaderUniform;
+
+	///
+	/// hands out descriptor sets from a growing list of pools, each sized for a number of sets with the
+	/// descriptors of uniforms, a full pool is moved past and the next one is twice as big,
+	/// sets aren't freed one by one, reset() recycles every pool at once
+	///
+	class DescriptorAllocator {
+	public:
+		DescriptorAllocator(void) = default;
+		DescriptorAllocator(const ShaderUniform* uniforms, u32 uniform_count, u32 initial_set_count = 16);
+
+		inline DescriptorAllocator(const std::initializer_list<ShaderUniform>& uniforms, u32 initial_set_count = 16)
+		: DescriptorAllocator(uniforms.begin(), (u32)uniforms.size(), initial_set_count) {}
+
+		/// 
+		/// sizes_per_set are the descriptors of each type one set averages, types with a count of 0 are left out
+		/// 
+		DescriptorAllocator(const vk::DescriptorPoolSize* sizes_per_set, u32 size_count, u32 initial_set_count = 16);
+
+		void destroy(void);
+		inline ~DescriptorAllocator(void) { this->destroy(); }
+
+		DescriptorAllocator(const DescriptorAllocator& other) = delete;
+		DescriptorAllocator& operator=(const DescriptorAllocator& other) = delete;
+
+		DescriptorAllocator(DescriptorAllocator&& other);
+		DescriptorAllocator& operator=(DescriptorAllocator&& other);
+
+		/// 
+		/// layout can't need more of a descriptor type than the uniforms or sizes given to the constructor
+		/// 
+		[[nodiscard]] vk::DescriptorSet allocate(vk::DescriptorSetLayout layout);
+
+		/// 
+		/// every set allocated so far becomes invalid, the gpu mustn't be using any of them anymore
+		/// 
+		void reset(void);
+
+		[[nodiscard]] inline u32 pool_count(void) const { return (u32)m_Pools.size(); }
+
+		[[nodiscard]] inline operator bool(void) const { return m_SizesPerSet.size(); }
+	private:
+		vk::DescriptorPool _create_pool(u32 set_count);
+	private:
+		ArrayVector<vk::DescriptorPoolSize> m_SizesPerSet;
+
+		ArrayList<vk::DescriptorPool> m_Pools;
+		u32 m_CurrentPool = 0; // pools before it are full until the next reset
+		u32 m_NextSetCount = 0;
+	};
+} // namespace Na
+
+#endif // NA_DESCRIPTOR_ALLOCATOR_HPP
\ No newline at end of file
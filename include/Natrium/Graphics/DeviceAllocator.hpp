@@ -0,0 +1,80 @@
+#if !defined(NA_DEVICE_ALLOCATOR_HPP)
+#define NA_DEVICE_ALLOCATOR_HPP
+
+#include "Natrium/Core.hpp"
+
+#include <mutex>
+
+namespace Na {
+	struct DeviceMemoryBlock;
+
+	enum class DeviceAllocationKind : u8 {
+		Buffer = 0,
+		Image, // optimal tiling, kept in separate blocks from buffers so bufferImageGranularity never matters
+		Dedicated
+	};
+
+	struct DeviceAllocation {
+		vk::DeviceMemory memory = nullptr;
+		vk::DeviceSize offset = 0;
+		vk::DeviceSize size = 0;
+
+		Byte* mapped = nullptr; // host visible memory stays mapped for its whole lifetime
+
+		DeviceMemoryBlock* block = nullptr; // null for dedicated allocations
+		u32 node = 0;
+
+		[[nodiscard]] inline operator bool(void) const { return memory; }
+	};
+
+	struct DeviceAllocatorStats {
+		u32 block_count = 0;
+		u32 dedicated_count = 0;
+		u64 allocation_count = 0;
+
+		vk::DeviceSize block_bytes = 0; // reserved by blocks
+		vk::DeviceSize used_bytes = 0; // handed out from blocks
+		vk::DeviceSize dedicated_bytes = 0;
+	};
+
+	///
+	/// sub-allocates resources from large vk::DeviceMemory blocks per memory type with a two level
+	/// segregated fit (tlsf) allocator, requests bigger than half a block get their own allocation
+	///
+	class DeviceAllocator {
+	public:
+		DeviceAllocator(void) = default;
+		DeviceAllocator(vk::DeviceSize block_size);
+
+		void destroy(void);
+		inline ~DeviceAllocator(void) { this->destroy(); }
+
+		DeviceAllocator(const DeviceAllocator& other) = delete;
+		DeviceAllocator& operator=(const DeviceAllocator& other) = delete;
+
+		[[nodiscard]] DeviceAllocation allocate(
+			const vk::MemoryRequirements& requirements,
+			vk::MemoryPropertyFlags properties,
+			DeviceAllocationKind kind
+		);
+		void free(DeviceAllocation& allocation);
+
+		[[nodiscard]] DeviceAllocatorStats stats(void) const;
+
+		[[nodiscard]] inline vk::DeviceSize block_size(void) const { return m_BlockSize; }
+	private:
+		DeviceAllocation _allocate_dedicated(vk::DeviceSize size, u32 memory_type, bool host_visible);
+	private:
+		vk::DeviceSize m_BlockSize = 0;
+
+		// two pools per memory type, buffers and images
+		std::vector<std::vector<DeviceMemoryBlock*>> m_Pools;
+
+		u32 m_DedicatedCount = 0;
+		vk::DeviceSize m_DedicatedBytes = 0;
+
+		mutable std::mutex m_Mutex;
+	};
+} // namespace Na
+
+#endif // NA_DEVICE_ALLOCATOR_HPP
\ No newline at end of file
@@ -2,6 +2,8 @@
 #define NA_DEVICE_IMAGE_HPP
 
 #include "Natrium/Core.hpp"
+#include "Natrium/Graphics/DeviceAllocator.hpp"
+#include "Natrium/Graphics/Submission.hpp"
 
 namespace Na {
 	vk::Format FindSupportedFormat(
@@ -13,7 +15,7 @@ namespace Na {
 	class DeviceImage {
 	public:
 		vk::Image img = nullptr;
-		vk::DeviceMemory memory = nullptr;
+		DeviceAllocation memory;
 
 		union {
 			vk::Extent3D extent;
@@ -34,7 +36,9 @@ namespace Na {
 			vk::ImageUsageFlags usage,
 			vk::SharingMode sharing_mode,
 			vk::SampleCountFlagBits sample_count,
-			vk::MemoryPropertyFlags memory_properties
+			vk::MemoryPropertyFlags memory_properties,
+			u32 mip_levels = 1,
+			vk::ImageCreateFlags create_flags = {}
 		);
 		void destroy(void);
 
@@ -46,7 +50,7 @@ namespace Na {
 
 		void transition_layout(vk::ImageLayout old_layout, vk::ImageLayout new_layout);
 
-		void copy_from_buffer(vk::Buffer buffer, u32 starting_layer = 0, u32 layer_count = 1);
+		void copy_from_buffer(vk::Buffer buffer, u32 starting_layer = 0, u32 layer_count = 1, vk::DeviceSize buffer_offset = 0);
 
 		void copy_all_from_buffer(vk::Buffer buffer, u32 starting_layer = 0);
 
@@ -60,13 +64,43 @@ namespace Na {
 		/// 
 		inline void copy_from_buffers(const std::initializer_list<vk::Buffer> buffers, u32 starting_layer = 0) { this->copy_from_buffers(buffers.begin(), (u32)buffers.size(), starting_layer); }
 
-		[[nodiscard]] vk::ImageView create_img_view(void) const;
+		void copy_regions_from_buffer(vk::Buffer buffer, const vk::BufferImageCopy* regions, u32 region_count);
+
+		/// 
+		/// uploads an image that hasn't been used yet on the transfer queue without waiting,
+		/// it's left in shader read only layout once the token completes
+		/// 
+		[[nodiscard]] SubmissionToken copy_regions_from_buffer_async(vk::Buffer buffer, const vk::BufferImageCopy* regions, u32 region_count);
+
+		/// 
+		/// copies every mip level of every layer from a level-major buffer (see MipChainSize),
+		/// texel_size is ignored for block compressed formats
+		/// 
+		void copy_mips_from_buffer(vk::Buffer buffer, u32 texel_size, vk::DeviceSize buffer_offset = 0);
+
+		[[nodiscard]] bool supports_blit_mipmaps(void) const;
+
+		/// 
+		/// blits mip level 0 down the whole chain,
+		/// expects every level to be in eTransferDstOptimal and leaves them in eShaderReadOnlyOptimal
+		/// 
+		void generate_mipmaps(void);
+
+		[[nodiscard]] vk::ImageView create_img_view(const vk::ComponentMapping& components = {}) const;
 
 		[[nodiscard]] inline u32 layer_count(void) const { return this->subresource_range.layerCount; }
+		[[nodiscard]] inline u32 mip_levels(void) const { return this->subresource_range.levelCount; }
 		[[nodiscard]] inline operator bool(void) const { return format != vk::Format::eUndefined; }
 	};
 
-	vk::ImageView CreateImageView(vk::Image img, vk::ImageAspectFlags aspect_mask, vk::Format format, u32 layer_count = 1);
+	vk::ImageView CreateImageView(
+		vk::Image img,
+		vk::ImageAspectFlags aspect_mask,
+		vk::Format format,
+		u32 layer_count = 1,
+		u32 mip_levels = 1,
+		const vk::ComponentMapping& components = {}
+	);
 }
 
 #endif // NA_DEVICE_IMAGE_HPP
\ No newline at end of file
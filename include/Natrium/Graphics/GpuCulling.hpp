@@ -0,0 +1,85 @@
+#if !defined(NA_GPU_CULLING_HPP)
+#define NA_GPU_CULLING_HPP
+
+#include "Natrium/Graphics/DepthPyramid.hpp"
+#include "Natrium/Graphics/Buffers/UniformBuffer.hpp"
+#include "Natrium/Graphics/Buffers/StorageBuffer.hpp"
+#include "Natrium/Graphics/Buffers/IndirectBuffer.hpp"
+
+namespace Na {
+	///
+	/// one instance as the culling pass reads it from a StorageBuffer
+	///
+	/// glsl: struct { vec4 sphere; uint index_count; uint first_index; int vertex_offset; uint padding; }
+	///
+	struct CullInstance {
+		glm::vec4 sphere = {}; // world space center in xyz, radius in w
+		u32 index_count = 0;
+		u32 first_index = 0;
+		i32 vertex_offset = 0;
+		u32 padding = 0;
+
+		CullInstance(void) = default;
+		inline CullInstance(const glm::vec4& sphere, const GeometryRange& range)
+		: sphere(sphere), index_count(range.index_count), first_index(range.first_index), vertex_offset(range.vertex_offset) {}
+	};
+
+	///
+	/// frustum and occlusion culls instances on the gpu and writes a command per visible one to an IndirectBuffer,
+	/// with the instance's index as its first instance so vertex shaders can look up its data by gl_InstanceIndex,
+	/// occlusion is tested against a DepthPyramid of the previous frame's depth, so the cpu records the same few
+	/// commands no matter how many instances there are
+	///
+	/// the visible commands are compacted into a device local IndirectBuffer and drawn in one call with the count,
+	/// needs multiDrawIndirect, VK_KHR_draw_indirect_count, drawIndirectFirstInstance
+	/// (see VkContext::IsDrawIndirectFirstInstanceSupported) and RendererSettings::keep_depth_for_culling
+	///
+	class GpuCulling {
+	public:
+		GpuCulling(void) = default;
+		GpuCulling(u32 max_instances, const RendererSettings& renderer_settings);
+		void destroy(void);
+		inline ~GpuCulling(void) { this->destroy(); }
+
+		GpuCulling(const GpuCulling& other) = delete;
+		GpuCulling& operator=(const GpuCulling& other) = delete;
+
+		GpuCulling(GpuCulling&& other);
+		GpuCulling& operator=(GpuCulling&& other);
+
+		/// 
+		/// records the pass over the first instance_count CullInstances of the current frame's part of instances,
+		/// before the frame's first draw, view_projection has to match the default viewport's orientation,
+		/// objects revealed by fast camera motion show up a frame late since the depth is the previous frame's
+		/// 
+		void cull(Renderer& renderer, const StorageBuffer& instances, u32 instance_count, const glm::mat4& view_projection);
+
+		/// 
+		/// draws the instances this frame's cull left visible with the bound graphics pipeline and geometry
+		/// (see Renderer::bind_geometry)
+		/// 
+		void draw(Renderer& renderer) const;
+
+		inline void set_occlusion_enabled(bool enabled) { m_OcclusionEnabled = enabled; }
+		[[nodiscard]] inline bool occlusion_enabled(void) const { return m_OcclusionEnabled; }
+
+		[[nodiscard]] inline u32 max_instances(void) const { return m_Commands.max_draws(); }
+
+		[[nodiscard]] inline const IndirectBuffer& commands(void) const { return m_Commands; }
+		[[nodiscard]] inline const DepthPyramid& depth_pyramid(void) const { return m_DepthPyramid; }
+
+		[[nodiscard]] inline operator bool(void) const { return m_Pipeline; }
+	private:
+		ComputePipeline m_Pipeline;
+		DepthPyramid m_DepthPyramid;
+
+		UniformBuffer m_View;
+		IndirectBuffer m_Commands;
+
+		u32 m_InstanceCount = 0;
+		u64 m_CulledFrame = 0;
+		bool m_OcclusionEnabled = true;
+	};
+} // namespace Na
+
+#endif // NA_GPU_CULLING_HPP
\ No newline at end of file
@@ -0,0 +1,46 @@
+#if !defined(NA_MIP_CHAIN_HPP)
+#define NA_MIP_CHAIN_HPP
+
+#include "Natrium/Core.hpp"
+
+namespace Na {
+	[[nodiscard]] u32 MipLevelCount(u32 width, u32 height);
+
+	[[nodiscard]] inline u32 MipExtent(u32 base, u32 level) { return std::max(base >> level, 1u); }
+
+	///
+	/// size of a full mip chain where every level stores layer_count tightly packed layers
+	///
+	[[nodiscard]] u64 MipChainSize(u32 width, u32 height, u32 level_count, u32 layer_count, u32 texel_size);
+
+	///
+	/// 2x2 box filter from src into dst (dst is max(src_width / 2, 1) x max(src_height / 2, 1) texels),
+	/// channel_size is either 1 (u8) or 2 (u16), srgb only affects 8 bit images,
+	/// the last channel of 2 and 4 channel images is alpha and always averaged linearly
+	///
+	void DownsampleBox(
+		const Byte* src,
+		u32 src_width,
+		u32 src_height,
+		Byte* dst,
+		u32 channels,
+		u32 channel_size,
+		bool srgb
+	);
+
+	///
+	/// fills levels [1, level_count) of a level-major mip chain (see MipChainSize), level 0 has to already be filled
+	///
+	void GenerateMipChain(
+		Byte* chain,
+		u32 width,
+		u32 height,
+		u32 level_count,
+		u32 layer_count,
+		u32 channels,
+		u32 channel_size,
+		bool srgb
+	);
+} // namespace Na
+
+#endif // NA_MIP_CHAIN_HPP
\ No newline at end of file
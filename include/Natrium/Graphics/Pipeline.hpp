@@ -2,10 +2,17 @@
 #define NA_PIPELINE_HPP
 
 #include "Natrium/Graphics/Renderer/RendererCore.hpp"
+#include "Natrium/Graphics/DescriptorAllocator.hpp"
 #include "Natrium/Assets/ShaderAsset.hpp"
+#include "Natrium/Core/Hash.hpp"
 
 namespace Na {
+	class ShaderModule;
+	class TransientBuffer;
+	class IndirectBuffer;
+
 	using PipelineShaderInfos = std::initializer_list<vk::PipelineShaderStageCreateInfo>;
+	using PipelineShaderModules = std::initializer_list<std::reference_wrapper<const ShaderModule>>;
 
 	enum class ShaderAttributeType : u32 {
 		None  = (u32)vk::Format::eUndefined,
@@ -50,6 +57,7 @@ namespace Na {
 		UniformBuffer = (u32)vk::DescriptorType::eUniformBufferDynamic,
 		StorageBuffer = (u32)vk::DescriptorType::eStorageBufferDynamic,
 		Texture       = (u32)vk::DescriptorType::eCombinedImageSampler,
+		StorageImage  = (u32)vk::DescriptorType::eStorageImage,
 
 		UBO           = UniformBuffer,
 		SSBO          = StorageBuffer
@@ -62,6 +70,17 @@ namespace Na {
 	};
 	using ShaderUniformLayout = std::initializer_list<ShaderUniform>;
 
+	///
+	/// an image view bound without a Texture, like a render target or a single mip level,
+	/// read through sampler as a Texture or written as a StorageImage (layout has to be eGeneral then)
+	///
+	struct ImageUniform {
+		ShaderUniformType type = ShaderUniformType::Texture;
+		vk::ImageView view = nullptr;
+		vk::Sampler sampler = nullptr;
+		vk::ImageLayout layout = vk::ImageLayout::eShaderReadOnlyOptimal;
+	};
+
 	struct PushConstant {
 		ShaderStageBits shader_stage;
 		u32 size;
@@ -69,7 +88,210 @@ namespace Na {
 	};
 	using PushConstantLayout = std::initializer_list<PushConstant>;
 
-	class GraphicsPipeline {
+	enum class PrimitiveTopology : u32 {
+		PointList     = (u32)vk::PrimitiveTopology::ePointList,
+		LineList      = (u32)vk::PrimitiveTopology::eLineList,
+		LineStrip     = (u32)vk::PrimitiveTopology::eLineStrip,
+		TriangleList  = (u32)vk::PrimitiveTopology::eTriangleList,
+		TriangleStrip = (u32)vk::PrimitiveTopology::eTriangleStrip,
+		TriangleFan   = (u32)vk::PrimitiveTopology::eTriangleFan
+	};
+
+	enum class CullMode : u32 {
+		None         = (u32)vk::CullModeFlagBits::eNone,
+		Front        = (u32)vk::CullModeFlagBits::eFront,
+		Back         = (u32)vk::CullModeFlagBits::eBack,
+		FrontAndBack = (u32)vk::CullModeFlagBits::eFrontAndBack
+	};
+
+	enum class BlendMode : u32 {
+		Opaque = 0,
+		Alpha,   // src * src.a + dst * (1 - src.a)
+		Additive // src * src.a + dst
+	};
+
+	///
+	/// fixed function state, part of the pipeline cache key
+	///
+	struct PipelineState {
+		PrimitiveTopology topology = PrimitiveTopology::TriangleList;
+		CullMode cull_mode = CullMode::Back;
+		BlendMode blend_mode = BlendMode::Opaque;
+
+		bool depth_test = true;
+		bool depth_write = true;
+
+		// fraction of samples shaded individually under msaa, 0 shades once per pixel
+		float min_sample_shading = 0.2f;
+
+		// adds BindlessTextures' table as set 1, set automatically for shaders that declare it
+		bool bindless_textures = false;
+
+		///
+		/// orders opaque before blended, then groups by depth, cull and topology state
+		///
+		[[nodiscard]] inline u32 sort_key(void) const
+		{
+			return
+				((u32)blend_mode << 12) |
+				((u32)!depth_write << 11) |
+				((u32)!depth_test << 10) |
+				((u32)(min_sample_shading > 0.0f) << 9) |
+				((u32)cull_mode << 7) |
+				(u32)topology;
+		}
+	};
+
+	///
+	/// background pipelines are built by a worker thread, until ready() they can't be drawn with,
+	/// the shader modules they're made from have to stay alive until then
+	///
+	enum class PipelineCompileMode : u8 {
+		Immediate = 0,
+		Background
+	};
+
+	struct PipelineBuild;
+	union DescriptorData;
+
+	///
+	/// the descriptor and push constant side graphics and compute pipelines share: set 0's layout, the pipeline
+	/// layout, an allocator holding the pipeline's own set and the per frame dynamic offsets of its buffer uniforms
+	///
+	class PipelineBase {
+	public:
+		/// 
+		/// writes to the pipeline's own descriptor set
+		/// 
+		template<typename T>
+		inline void bind_uniform(u32 binding, const T& uniform) { this->_bind_uniform(m_DescriptorSet, binding, _uniform_ref(uniform)); }
+
+		/// 
+		/// writes to a set from allocate_descriptor_set, the dynamic offsets are shared by every set,
+		/// so sets have to bind buffers of the same size at the same binding
+		/// 
+		template<typename T>
+		inline void bind_uniform(vk::DescriptorSet set, u32 binding, const T& uniform) { this->_bind_uniform(set, binding, _uniform_ref(uniform)); }
+
+		/// 
+		/// binds the whole buffer with a range of buffer.range(), draws start out at the beginning of
+		/// the frame's region until Renderer::set_transient_uniform points them at an allocation
+		/// 
+		inline void bind_uniform(vk::DescriptorSet set, u32 binding, const TransientBuffer& buffer) { this->_bind_uniform(set, binding, _uniform_ref(buffer)); }
+		inline void bind_uniform(u32 binding, const TransientBuffer& buffer) { this->bind_uniform(m_DescriptorSet, binding, buffer); }
+
+		/// 
+		/// binds each frame's region as a storage buffer, for shaders that write the commands
+		/// 
+		inline void bind_uniform(vk::DescriptorSet set, u32 binding, const IndirectBuffer& buffer) { this->_bind_uniform(set, binding, _uniform_ref(buffer)); }
+		inline void bind_uniform(u32 binding, const IndirectBuffer& buffer) { this->bind_uniform(m_DescriptorSet, binding, buffer); }
+
+		/// 
+		/// writes the whole set in one call, one uniform per entry of the uniform layout in the same order
+		/// (binding order for pipelines made from reflection), through a descriptor update template on 1.1 devices
+		/// 
+		template<typename... T>
+		inline void bind_uniforms(vk::DescriptorSet set, const T&... uniforms)
+		{
+			static_assert(sizeof...(T), "bind_uniforms needs at least one uniform");
+			const UniformRef refs[] = { _uniform_ref(uniforms)... };
+			this->_bind_uniforms(set, refs, (u32)sizeof...(T));
+		}
+
+		template<typename... T>
+		inline void bind_uniforms(const T&... uniforms) { this->bind_uniforms(m_DescriptorSet, uniforms...); }
+
+		/// 
+		/// another set with the pipeline's layout, e.g. one per material, bound with Renderer::bind_descriptor_set
+		/// and destroyed along with the pipeline
+		/// 
+		[[nodiscard]] vk::DescriptorSet allocate_descriptor_set(void);
+
+		[[nodiscard]] inline vk::DescriptorSetLayout descriptor_layout(void) const { return m_DescriptorLayout; }
+		[[nodiscard]] inline vk::PipelineLayout layout(void) const { return m_Layout; }
+
+		[[nodiscard]] inline DescriptorAllocator& descriptor_allocator(void) { return m_DescriptorAllocator; }
+		[[nodiscard]] inline const DescriptorAllocator& descriptor_allocator(void) const { return m_DescriptorAllocator; }
+		[[nodiscard]] inline const vk::DescriptorSet& descriptor_set(void) const { return m_DescriptorSet; }
+
+		[[nodiscard]] inline ArrayList<u32>& dynamic_offsets(void) { return m_DynamicOffsets; }
+		[[nodiscard]] inline const ArrayList<u32>& dynamic_offsets(void) const { return m_DynamicOffsets; }
+		[[nodiscard]] inline u32 dynamic_offset_count(void) const { return m_DynamicOffsetCount; }
+		[[nodiscard]] inline u32 dynamic_offset_index(void) const { return m_DynamicOffsetIndex; }
+		inline void increment_dynamic_offset_index(void) { m_DynamicOffsetIndex++; }
+
+		/// 
+		/// index of binding's offset within a frame's dynamic offsets, dynamic_offset_count() if it has none
+		/// 
+		[[nodiscard]] u32 dynamic_offset_slot(u32 binding) const;
+	protected:
+		PipelineBase(void) = default;
+		~PipelineBase(void) = default;
+
+		PipelineBase(const PipelineBase& other) = delete;
+		PipelineBase& operator=(const PipelineBase& other) = delete;
+
+		/// 
+		/// moves without destroying what this held, derived classes destroy first
+		/// 
+		PipelineBase(PipelineBase&& other);
+		PipelineBase& operator=(PipelineBase&& other);
+
+		/// 
+		/// extra_set is appended to the layout as set 1, set 0 then exists even without uniforms
+		/// 
+		void _create_layout(
+			u32 max_frames_in_flight,
+			const ShaderUniform* uniforms,
+			u32 uniform_count,
+			const PushConstant* push_constants,
+			u32 push_constant_count,
+			vk::DescriptorSetLayout extra_set = nullptr
+		);
+		void _destroy_layout(void);
+	private:
+		struct UniformRef {
+			enum Kind : u8 {
+				Tagged = 0, // starts with its ShaderUniformType
+				Transient,
+				Indirect,
+				Image
+			};
+
+			const void* uniform;
+			Kind kind = Tagged;
+		};
+
+		template<typename T>
+		static inline UniformRef _uniform_ref(const T& uniform) { return { &uniform }; }
+		static inline UniformRef _uniform_ref(const TransientBuffer& buffer) { return { &buffer, UniformRef::Transient }; }
+		static inline UniformRef _uniform_ref(const IndirectBuffer& buffer) { return { &buffer, UniformRef::Indirect }; }
+		static inline UniformRef _uniform_ref(const ImageUniform& image) { return { &image, UniformRef::Image }; }
+
+		void _bind_uniform(vk::DescriptorSet set, u32 binding, UniformRef uniform);
+		void _bind_uniforms(vk::DescriptorSet set, const UniformRef* uniforms, u32 count);
+
+		/// 
+		/// fills data for binding and points the binding's dynamic offsets at each frame's part of a buffer
+		/// 
+		vk::DescriptorType _descriptor_data(u32 binding, UniformRef uniform, DescriptorData& data);
+	private:
+		vk::DescriptorSetLayout m_DescriptorLayout;
+		vk::PipelineLayout m_Layout;
+
+		DescriptorAllocator m_DescriptorAllocator; // empty without uniforms
+		vk::DescriptorSet m_DescriptorSet;
+
+		ArrayList<ShaderUniform> m_Uniforms; // layout order, the update template's entries follow it
+		vk::DescriptorUpdateTemplate m_UpdateTemplate;
+
+		ArrayList<u32> m_DynamicOffsets;
+		ArrayList<u32> m_DynamicBindings; // binding of each slot, in constructor order
+		u32 m_DynamicOffsetCount = 0;
+		u32 m_DynamicOffsetIndex = 0;
+	};
+
+	class GraphicsPipeline : public PipelineBase {
 	public:
 		GraphicsPipeline(void) = default;
 		GraphicsPipeline(
@@ -77,8 +299,22 @@ namespace Na {
 			const PipelineShaderInfos& handles = {},
 			const ShaderAttributeLayout& vertex_buffer_layout = {},
 			const ShaderUniformLayout& uniform_data_layout = {},
-			const PushConstantLayout& push_constant_layout = {}
+			const PushConstantLayout& push_constant_layout = {},
+			const PipelineState& state = {},
+			PipelineCompileMode compile_mode = PipelineCompileMode::Immediate
 		);
+
+		/// 
+		/// derives the vertex, uniform and push constant layouts from the modules' spir-v,
+		/// vertex attributes are read from one tightly packed buffer at binding 0 in location order
+		/// 
+		GraphicsPipeline(
+			RendererCore& renderer_core,
+			const PipelineShaderModules& modules,
+			const PipelineState& state = {},
+			PipelineCompileMode compile_mode = PipelineCompileMode::Immediate
+		);
+
 		void destroy(void);
 		inline ~GraphicsPipeline(void) { this->destroy(); }
 
@@ -89,41 +325,102 @@ namespace Na {
 		GraphicsPipeline& operator=(GraphicsPipeline&& other);
 
 		/// 
-		/// warning:
-		/// uniforms not being bound with the order specified via the constructor is undefined behaviour
+		/// null while a background build is still pending
 		/// 
-		template<typename T>
-		inline void bind_uniform(u32 binding, const T& uniform) { this->_bind_uniform(binding, &uniform); }
+		[[nodiscard]] vk::Pipeline pipeline(void) const;
+		[[nodiscard]] inline bool ready(void) const { return (bool)this->pipeline(); }
 
-		[[nodiscard]] inline vk::Pipeline pipeline(void) const { return m_Pipeline; }
+		/// 
+		/// builds the pipeline on the calling thread if no worker got to it yet, otherwise blocks until it's done,
+		/// rethrows the build's error
+		/// 
+		void wait(void) const;
 
-		[[nodiscard]] inline vk::DescriptorSetLayout descriptor_layout(void) const { return m_DescriptorLayout; }
-		[[nodiscard]] inline vk::PipelineLayout layout(void) const { return m_Layout; }
+		/// 
+		/// the background build threw, the error was logged and wait() rethrows it
+		/// 
+		[[nodiscard]] bool failed(void) const;
 
-		[[nodiscard]] inline vk::DescriptorPool descriptor_pool(void) const { return m_DescriptorPool; }
-		[[nodiscard]] inline const vk::DescriptorSet& descriptor_set(void) const { return m_DescriptorSet; }
+		[[nodiscard]] inline const PipelineState& state(void) const { return m_State; }
 
-		[[nodiscard]] inline ArrayList<u32>& dynamic_offsets(void) { return m_DynamicOffsets; }
-		[[nodiscard]] inline const ArrayList<u32>& dynamic_offsets(void) const { return m_DynamicOffsets; }
-		[[nodiscard]] inline u32 dynamic_offset_count(void) const { return m_DynamicOffsetCount; }
-		[[nodiscard]] inline u32 dynamic_offset_index(void) const { return m_DynamicOffsetIndex; }
-		inline void increment_dynamic_offset_index(void) { m_DynamicOffsetIndex++; }
+		/// 
+		/// fixed function state in the high bits, the pipeline layout in the low ones,
+		/// sorting draws by it keeps state and descriptor set changes to a minimum
+		/// 
+		[[nodiscard]] inline u64 sort_key(void) const
+		{
+			VkPipelineLayout layout = this->layout();
+			return ((u64)m_State.sort_key() << 32) | (u32)Fnv1a(&layout, sizeof(layout));
+		}
 
-		[[nodiscard]] inline operator bool(void) const { return m_Pipeline; }
+		[[nodiscard]] inline operator bool(void) const { return m_Pipeline || m_Build; }
 	private:
-		void _bind_uniform(u32 binding, const void* uniform);
+		void _create(
+			RendererCore& renderer_core,
+			const vk::PipelineShaderStageCreateInfo* shader_infos,
+			u32 shader_info_count,
+			const vk::PipelineVertexInputStateCreateInfo& vertex_input_info,
+			const ShaderUniform* uniforms,
+			u32 uniform_count,
+			const PushConstant* push_constants,
+			u32 push_constant_count,
+			PipelineCompileMode compile_mode
+		);
 	private:
 		vk::Pipeline m_Pipeline;
+		std::shared_ptr<PipelineBuild> m_Build;
+		PipelineState m_State;
+	};
 
-		vk::DescriptorSetLayout m_DescriptorLayout;
-		vk::PipelineLayout m_Layout;
+	///
+	/// recorded with Renderer::bind_pipeline and Renderer::dispatch before the frame's first draw,
+	/// the results are made visible to later work with Renderer::compute_barrier
+	///
+	class ComputePipeline : public PipelineBase {
+	public:
+		ComputePipeline(void) = default;
+		/// 
+		/// bindless_textures adds the BindlessTextures set like PipelineState::bindless_textures
+		/// 
+		ComputePipeline(
+			const RendererSettings& renderer_settings,
+			const vk::PipelineShaderStageCreateInfo& shader_info,
+			const ShaderUniformLayout& uniform_data_layout = {},
+			const PushConstantLayout& push_constant_layout = {},
+			bool bindless_textures = false
+		);
 
-		vk::DescriptorPool m_DescriptorPool;
-		vk::DescriptorSet m_DescriptorSet;
+		/// 
+		/// derives the uniform and push constant layouts and the use of bindless textures from the module's spir-v
+		/// 
+		ComputePipeline(const RendererSettings& renderer_settings, const ShaderModule& module);
 
-		ArrayList<u32> m_DynamicOffsets;
-		u32 m_DynamicOffsetCount = 0;
-		u32 m_DynamicOffsetIndex = 0;
+		void destroy(void);
+		inline ~ComputePipeline(void) { this->destroy(); }
+
+		ComputePipeline(const ComputePipeline& other) = delete;
+		ComputePipeline& operator=(const ComputePipeline& other) = delete;
+
+		ComputePipeline(ComputePipeline&& other);
+		ComputePipeline& operator=(ComputePipeline&& other);
+
+		[[nodiscard]] inline vk::Pipeline pipeline(void) const { return m_Pipeline; }
+		[[nodiscard]] inline bool bindless_textures(void) const { return m_BindlessTextures; }
+
+		[[nodiscard]] inline operator bool(void) const { return m_Pipeline; }
+	private:
+		void _create(
+			const RendererSettings& renderer_settings,
+			const vk::PipelineShaderStageCreateInfo& shader_info,
+			const ShaderUniform* uniforms,
+			u32 uniform_count,
+			const PushConstant* push_constants,
+			u32 push_constant_count,
+			bool bindless_textures
+		);
+	private:
+		vk::Pipeline m_Pipeline;
+		bool m_BindlessTextures = false;
 	};
 } // namespace Na
 
@@ -3,11 +3,15 @@
 
 #include "Natrium/Graphics/Renderer/RendererCore.hpp"
 #include "Natrium/Graphics/Pipeline.hpp"
+#include "Natrium/Graphics/DescriptorAllocator.hpp"
 
 #include "Natrium/Graphics/Buffers/VertexBuffer.hpp"
 #include "Natrium/Graphics/Buffers/IndexBuffer.hpp"
 #include "Natrium/Graphics/Buffers/UniformBuffer.hpp"
 #include "Natrium/Graphics/Buffers/StorageBuffer.hpp"
+#include "Natrium/Graphics/Buffers/TransientBuffer.hpp"
+#include "Natrium/Graphics/Buffers/GeometryArena.hpp"
+#include "Natrium/Graphics/Buffers/IndirectBuffer.hpp"
 
 namespace Na {
 	struct FrameData {
@@ -18,8 +22,33 @@ namespace Na {
 		vk::Semaphore     image_available_semaphore;
 		vk::Semaphore     render_finished_semaphore;
 		vk::Fence         in_flight_fence;
+
+		u64               serial = 0; // the frame's number for deferred destruction, 0 until submitted
+
+		DescriptorAllocator* descriptors = nullptr; // reset every time the frame begins
+	};
+
+	///
+	/// what bind_pipeline does with a pipeline whose background build hasn't finished yet
+	///
+	enum class PendingPipelineMode : u8 {
+		Wait = 0, // block until it's built
+		Skip,     // drop draws until the next bind
+		Fallback  // bind the fallback pipeline instead, skip if that isn't ready either
 	};
 
+	///
+	/// what reads a compute shader's output after Renderer::compute_barrier
+	///
+	enum class ComputeOutputUse : u8 {
+		Compute = 0, // a later dispatch
+		Indirect,    // draw and dispatch commands and counts
+		Vertex,      // vertex and index input
+		Shader       // uniforms, storage buffers and textures in graphics shaders
+	};
+
+	inline constexpr u32 k_MaxBoundDynamicOffsets = 16;
+
 	class Renderer {
 	public:
 		Renderer(void) = default;
@@ -32,11 +61,77 @@ namespace Na {
 		void end_frame(void);
 
 		void bind_pipeline(const GraphicsPipeline& pipeline);
-		void set_push_constant(const PushConstant& push_constant, const void* data, const GraphicsPipeline& pipeline);
+		void bind_pipeline(const ComputePipeline& pipeline);
+		void set_pending_pipeline_mode(PendingPipelineMode mode, const GraphicsPipeline* fallback = nullptr);
+		void set_push_constant(const PushConstant& push_constant, const void* data, const PipelineBase& pipeline);
+
+		/// 
+		/// points the bound pipeline's TransientBuffer at binding to allocation for the following draws
+		/// 
+		void set_transient_uniform(u32 binding, const TransientAllocation& allocation);
+
+		/// 
+		/// binds a set allocated for the bound pipeline in place of its own one, until the next bind_pipeline
+		/// 
+		void bind_descriptor_set(vk::DescriptorSet set);
+
+		/// 
+		/// a set with pipeline's layout that's only valid for the current frame, write it with
+		/// pipeline.bind_uniform(set, ...) and bind it with bind_descriptor_set,
+		/// the pools are sized by RendererSettings::frame_descriptors
+		/// 
+		[[nodiscard]] vk::DescriptorSet allocate_frame_descriptor_set(const PipelineBase& pipeline);
+
+		/// 
+		/// the render pass begins with the frame's first draw, dispatches and compute barriers
+		/// have to be recorded before it
+		/// 
+		void dispatch(u32 group_count_x, u32 group_count_y = 1, u32 group_count_z = 1);
+		void dispatch_indirect(const DeviceBuffer& buffer, vk::DeviceSize offset = 0);
+
+		/// 
+		/// makes what the dispatches so far wrote visible to the following work that uses it as use
+		/// 
+		void compute_barrier(const DeviceBuffer& buffer, ComputeOutputUse use, vk::DeviceSize offset = 0, vk::DeviceSize size = VK_WHOLE_SIZE);
+		void compute_barrier(const DeviceImage& image, vk::ImageLayout old_layout, vk::ImageLayout new_layout, ComputeOutputUse use = ComputeOutputUse::Shader);
+
+		/// 
+		/// fills size bytes of buffer with value on the gpu before the frame's first draw, e.g. to reset a count
+		/// a shader appends to, visible to the following work that uses it as use, offset and size are multiples of 4
+		/// 
+		void fill_buffer(const DeviceBuffer& buffer, vk::DeviceSize offset, vk::DeviceSize size, u32 value, ComputeOutputUse use);
+
+		/// 
+		/// makes the depth buffer the previous frame rendered readable by compute shaders in eShaderReadOnlyOptimal
+		/// until the render pass begins, false if there's none (the first frame or the swapchain was recreated since),
+		/// needs RendererSettings::keep_depth_for_culling
+		/// 
+		[[nodiscard]] bool acquire_previous_depth(void);
 
 		void draw_vertices(const VertexBuffer& vertex_buffer, u32 vertex_count, u32 instance_count = 1);
 		void draw_indexed(const VertexBuffer& vertex_buffer, const IndexBuffer& index_buffer, u32 instance_count = 1);
 
+		/// 
+		/// binds the arena's buffers for the following draw_geometry calls, does nothing if they already are
+		/// 
+		void bind_geometry(const GeometryArena& arena);
+		void draw_geometry(const GeometryRange& range, u32 instance_count = 1, u32 first_instance = 0);
+
+		/// 
+		/// draw_count commands of the current frame's region starting at first_draw, in one call if the device
+		/// has multi draw indirect, reads the bound vertex and index buffers like draw_geometry,
+		/// commands written on the gpu need a first instance of 0 unless VkContext::IsDrawIndirectFirstInstanceSupported()
+		/// 
+		void draw_indexed_indirect(const IndirectBuffer& buffer, u32 draw_count, u32 first_draw = 0);
+		inline void draw_indexed_indirect(const IndirectBuffer& buffer) { this->draw_indexed_indirect(buffer, buffer.draw_count(*this)); }
+
+		/// 
+		/// for commands written on the gpu, the count is read from the region and capped at max_draw_count,
+		/// without VK_KHR_draw_indirect_count every one of the max_draw_count commands is drawn,
+		/// so the writer has to zero the instance count of the ones past the count
+		/// 
+		void draw_indexed_indirect_count(const IndirectBuffer& buffer, u32 max_draw_count);
+
 		void set_descriptor_buffer(void* buffer, const void* data) const;
 
 		[[nodiscard]] inline const RendererSettings& settings(void) { return m_Core->settings(); }
@@ -49,6 +144,11 @@ namespace Na {
 
 		[[nodiscard]] inline u32 current_frame_index(void) const { return m_FrameIndex; }
 
+		/// 
+		/// counts every begun frame, unlike the frame index it never repeats
+		/// 
+		[[nodiscard]] inline u64 frame_number(void) const { return m_FrameNumber; }
+
 		[[nodiscard]] inline operator bool(void) const { return m_Core; }
 
 		Renderer(const Renderer& other) = delete;
@@ -59,6 +159,9 @@ namespace Na {
 	private:
 		void _create_command_objects(void);
 		void _create_sync_objects(void);
+
+		void _begin_render_pass(void);
+		void _bind_pipeline_set(const PipelineBase& pipeline, vk::PipelineBindPoint bind_point);
 	private:
 		RendererCore* m_Core = nullptr;
 
@@ -66,9 +169,29 @@ namespace Na {
 
 		ArrayVector<FrameData> m_Frames;
 		u32 m_FrameIndex = 0;
+		u64 m_FrameNumber = 0;
 
 		ArrayVector<vk::Fence> m_ImageInFlightFences;
 		u32 m_ImageIndex = 0;
+
+		PendingPipelineMode m_PendingPipelineMode = PendingPipelineMode::Wait;
+		const GraphicsPipeline* m_FallbackPipeline = nullptr;
+		bool m_SkipDraws = false;
+
+		const PipelineBase* m_BoundPipeline = nullptr;
+		vk::PipelineBindPoint m_BindPoint = vk::PipelineBindPoint::eGraphics;
+		vk::DescriptorSet m_BoundSet = nullptr;
+		std::array<u32, k_MaxBoundDynamicOffsets> m_BoundOffsets = {};
+
+		// binding 0 and the index buffer, redundant binds between draws are skipped
+		vk::Buffer m_BoundVertexBuffer = nullptr;
+		vk::Buffer m_BoundIndexBuffer = nullptr;
+
+		glm::vec4 m_ClearColor = Colors::k_Black;
+		bool m_InRenderPass = false;
+
+		u64 m_DepthGeneration = 0; // of the depth buffer the last submitted frame rendered to
+		bool m_DepthAcquired = false;
 	};
 } // namespace Na
 
@@ -32,6 +32,14 @@ namespace Na {
 
 		[[nodiscard]] inline vk::RenderPass render_pass(void) const { return m_RenderPass; }
 
+		[[nodiscard]] inline const DeviceImage& depth_image(void) const { return m_DepthImage; }
+		[[nodiscard]] inline vk::ImageView depth_image_view(void) const { return m_DepthImageView; }
+
+		/// 
+		/// bumped whenever the depth buffer is recreated along with the swapchain
+		/// 
+		[[nodiscard]] inline u64 depth_generation(void) const { return m_DepthGeneration; }
+
 		[[nodiscard]] inline QueueFamilyIndices queue_family_indices(void) const { return m_QueueIndices; }
 
 		[[nodiscard]] inline operator bool(void) const { return m_Window; }
@@ -79,6 +87,7 @@ namespace Na {
 
 		DeviceImage m_DepthImage;
 		vk::ImageView m_DepthImageView;
+		u64 m_DepthGeneration = 0;
 
 		vk::RenderPass m_RenderPass;
 		ArrayVector<vk::Framebuffer> m_Framebuffers;
@@ -4,6 +4,19 @@
 #include "Natrium/Core.hpp"
 
 namespace Na {
+	///
+	/// descriptors of each type per set in the per-frame descriptor pools (see Renderer::allocate_frame_descriptor_set),
+	/// the first pool holds set_count sets and every further one twice as many
+	///
+	struct FrameDescriptorSizes {
+		u32 set_count;
+
+		u32 uniform_buffers;
+		u32 storage_buffers;
+		u32 textures;
+		u32 storage_images;
+	};
+
 	struct RendererSettings {
 		u32 max_frames_in_flight;
 
@@ -12,6 +25,12 @@ namespace Na {
 
 		bool msaa_enabled;
 
+		// stores the depth buffer and makes it sampleable for the next frame's compute work
+		// (see Renderer::acquire_previous_depth), needed by DepthPyramid and GpuCulling
+		bool keep_depth_for_culling;
+
+		FrameDescriptorSizes frame_descriptors;
+
 		static RendererSettings Default(void);
 	};
 } // namespace Na
@@ -2,6 +2,7 @@
 #define NA_SHADER_MODULE_HPP
 
 #include "Natrium/Assets/ShaderAsset.hpp"
+#include "Natrium/Graphics/ShaderReflection.hpp"
 
 namespace Na {
 	class ShaderModule {
@@ -25,19 +26,55 @@ namespace Na {
 		ShaderModule(ShaderModule&& other);
 		ShaderModule& operator=(ShaderModule&& other);
 
-		[[nodiscard]] inline vk::PipelineShaderStageCreateInfo pipeline_shader_info(void) const { return vk::PipelineShaderStageCreateInfo({}, (vk::ShaderStageFlagBits)this->m_Stage, this->m_Module, this->m_EntryPoint.data()); }
+		/// 
+		/// sets the value of layout(constant_id = constant_id) for every pipeline created from this module afterwards,
+		/// bools are stored as vk::Bool32 like glsl expects
+		/// 
+		template<typename T> requires std::is_trivially_copyable_v<T>
+		inline ShaderModule& specialize(u32 constant_id, const T& value)
+		{
+			if constexpr (std::is_same_v<T, bool>)
+				return this->specialize(constant_id, (vk::Bool32)value);
+			else
+				return this->_specialize(constant_id, &value, sizeof(T));
+		}
+
+		/// 
+		/// the returned info points into this module, so it has to outlive pipeline creation
+		/// 
+		[[nodiscard]] inline vk::PipelineShaderStageCreateInfo pipeline_shader_info(void) const
+		{
+			return vk::PipelineShaderStageCreateInfo(
+				{},
+				(vk::ShaderStageFlagBits)this->m_Stage,
+				this->m_Module,
+				this->m_EntryPoint.data(),
+				m_SpecializationEntries.empty() ? nullptr : &m_SpecializationInfo
+			);
+		}
 
 		[[nodiscard]] inline vk::ShaderModule module(void) const { return m_Module; }
+		[[nodiscard]] inline const ShaderReflection& reflection(void) const { return m_Reflection; }
 		[[nodiscard]] inline ShaderStageBits stage(void) const { return m_Stage; }
 
 		[[nodiscard]] inline std::string_view& entry_point(void) { return m_EntryPoint; }
 		[[nodiscard]] inline const std::string_view& entry_point(void) const { return m_EntryPoint; }
 
 		[[nodiscard]] inline operator bool(void) const { return m_Module; };
+	private:
+		ShaderModule& _specialize(u32 constant_id, const void* data, u32 size);
 	private:
 		vk::ShaderModule m_Module;
 		ShaderStageBits m_Stage;
 		std::string_view m_EntryPoint;
+
+		// empty for modules wrapping an existing vk::ShaderModule
+		ShaderReflection m_Reflection;
+
+		// the vectors' storage survives moves, so m_SpecializationInfo never has to be fixed up
+		std::vector<vk::SpecializationMapEntry> m_SpecializationEntries;
+		std::vector<Byte> m_SpecializationData;
+		vk::SpecializationInfo m_SpecializationInfo;
 	};
 }
 
@@ -0,0 +1,37 @@
+#if !defined(NA_SHADER_REFLECTION_HPP)
+#define NA_SHADER_REFLECTION_HPP
+
+#include "Natrium/Graphics/Pipeline.hpp"
+
+namespace Na {
+	///
+	/// pipeline interface read from spir-v, everything the reflection couldn't map ends up in error
+	///
+	struct ShaderReflection {
+		ShaderStageBits stage = ShaderStageBits::None;
+
+		std::vector<ShaderAttribute> attributes; // vertex inputs sorted by location, vertex shaders only
+		std::vector<ShaderUniform> uniforms; // descriptor set 0 sorted by binding
+		std::vector<PushConstant> push_constants;
+
+		// declares BindlessTextures' table at set 1 binding 0
+		bool bindless_textures = false;
+
+		std::string error;
+
+		[[nodiscard]] inline bool valid(void) const { return error.empty(); }
+	};
+
+	[[nodiscard]] ShaderReflection ReflectShader(const u32* spv, u64 word_count, const std::string_view& entry_point = "main");
+
+	[[nodiscard]] inline ShaderReflection ReflectShader(const ShaderBinary& binary, const std::string_view& entry_point = "main")
+	{ return ReflectShader(binary.ptr(), binary.data().size(), entry_point); }
+
+	///
+	/// combines the stages of a pipeline, uniforms used by several stages get all of their stage bits
+	/// and the push constants are merged into one range visible to every stage that uses them
+	///
+	[[nodiscard]] ShaderReflection MergeReflections(const ShaderReflection* const* reflections, u32 count);
+} // namespace Na
+
+#endif // NA_SHADER_REFLECTION_HPP
\ No newline at end of file
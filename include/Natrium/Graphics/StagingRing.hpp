@@ -0,0 +1,63 @@
+#if !defined(NA_STAGING_RING_HPP)
+#define NA_STAGING_RING_HPP
+
+#include "Natrium/Graphics/Buffers/DeviceBuffer.hpp"
+#include "Natrium/Graphics/Submission.hpp"
+
+namespace Na {
+	struct StagingRegion {
+		vk::Buffer buffer = nullptr;
+		vk::DeviceSize offset = 0;
+		vk::DeviceSize size = 0;
+		Byte* data = nullptr;
+	};
+
+	///
+	/// persistently mapped upload memory, regions are handed out front to back and reused once
+	/// the submission that read them has completed
+	///
+	class StagingRing {
+	public:
+		StagingRing(void) = default;
+		StagingRing(vk::DeviceSize capacity);
+
+		void destroy(void);
+		inline ~StagingRing(void) { this->destroy(); }
+
+		StagingRing(const StagingRing& other) = delete;
+		StagingRing& operator=(const StagingRing& other) = delete;
+
+		/// 
+		/// waits for the oldest uploads to finish when the ring is full and grows it when size doesn't fit at all,
+		/// alignment has to be a power of two
+		/// 
+		[[nodiscard]] StagingRegion allocate(vk::DeviceSize size, vk::DeviceSize alignment = 16);
+
+		/// 
+		/// every region allocated since the last call is reused once the submission completes,
+		/// without new regions the submission guards the previous call's regions along with it
+		/// 
+		void track(SubmissionToken submission);
+
+		[[nodiscard]] inline vk::DeviceSize capacity(void) const { return m_Capacity; }
+	private:
+		void _retire(bool wait);
+		void _grow(vk::DeviceSize min_capacity);
+	private:
+		struct Submission {
+			SubmissionToken token;
+			u64 head;
+		};
+
+		DeviceBuffer m_Buffer;
+		vk::DeviceSize m_Capacity = 0;
+
+		// positions only ever grow, the offset into the buffer is position % capacity
+		u64 m_Head = 0;
+		u64 m_Tail = 0;
+
+		std::deque<Submission> m_Submissions;
+	};
+} // namespace Na
+
+#endif // NA_STAGING_RING_HPP
\ No newline at end of file
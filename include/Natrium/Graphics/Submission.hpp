@@ -0,0 +1,21 @@
+#if !defined(NA_SUBMISSION_HPP)
+#define NA_SUBMISSION_HPP
+
+#include "Natrium/Core.hpp"
+
+namespace Na {
+	///
+	/// completion token of a queue submission, stays valid after the submission's fence has been recycled,
+	/// a default constructed token counts as complete
+	///
+	struct SubmissionToken {
+		u64 id = 0;
+
+		[[nodiscard]] bool complete(void) const;
+		void wait(void) const;
+
+		[[nodiscard]] inline operator bool(void) const { return id; }
+	};
+} // namespace Na
+
+#endif // NA_SUBMISSION_HPP
\ No newline at end of file
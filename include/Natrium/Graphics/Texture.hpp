@@ -2,22 +2,60 @@
 #define NA_TEXTURE_HPP
 
 #include "Natrium/Assets/ImageAsset.hpp"
+#include "Natrium/Assets/Ktx2Asset.hpp"
 #include "Natrium/Graphics/DeviceImage.hpp"
+#include "Natrium/Graphics/BlockCompression.hpp"
 #include "Natrium/Graphics/Pipeline.hpp"
 
 namespace Na {
+	///
+	/// how an image's color channels are encoded, albedo and other color maps are Srgb,
+	/// normal maps, masks and other data are Linear, alpha is always linear
+	///
+	enum class ColorSpace : u8 {
+		Srgb = 0,
+		Linear
+	};
+
 	class Texture {
 	public:
 		const ShaderUniformType descriptor_type = ShaderUniformType::Texture;
 
 		Texture(void) = default;
-		Texture(AssetHandle<Image> img, const RendererSettings& renderer_settings)
-		: Texture(&img, 1, renderer_settings) {}
+		Texture(
+			AssetHandle<Image> img,
+			const RendererSettings& renderer_settings,
+			BlockFormat compression = BlockFormat::None,
+			ColorSpace color_space = ColorSpace::Srgb
+		)
+		: Texture(&img, 1, renderer_settings, compression, color_space) {}
+
+		/// 
+		/// compression other than BlockFormat::None encodes the whole mip chain on the cpu,
+		/// falls back to an uncompressed texture if the device doesn't support the block format,
+		/// BlockFormat::BC5 only holds data and is always Linear
+		/// 
+		Texture(
+			const AssetHandle<Image>* imgs,
+			u32 count,
+			const RendererSettings& renderer_settings,
+			BlockFormat compression = BlockFormat::None,
+			ColorSpace color_space = ColorSpace::Srgb
+		);
 
-		Texture(const AssetHandle<Image>* imgs, u32 count, const RendererSettings& renderer_settings);
+		Texture(
+			const std::initializer_list<AssetHandle<Image>>& imgs,
+			const RendererSettings& renderer_settings,
+			BlockFormat compression = BlockFormat::None,
+			ColorSpace color_space = ColorSpace::Srgb
+		)
+		: Texture(imgs.begin(), (u32)imgs.size(), renderer_settings, compression, color_space) {}
 
-		Texture(const std::initializer_list<AssetHandle<Image>>& imgs, const RendererSettings& renderer_settings)
-		: Texture(imgs.begin(), (u32)imgs.size(), renderer_settings) {}
+		/// 
+		/// uploads the levels straight from the mapped file without transcoding,
+		/// skip_levels drops the largest levels for lower memory budgets
+		/// 
+		Texture(AssetHandle<Ktx2Asset> ktx, const RendererSettings& renderer_settings, u32 skip_levels = 0);
 
 		inline ~Texture(void) { this->destroy(); }
 		void destroy(void);
@@ -35,6 +73,8 @@ namespace Na {
 		[[nodiscard]] inline u32 width(void) const { return m_Image.width; }
 		[[nodiscard]] inline u32 height(void) const { return m_Image.height; }
 		[[nodiscard]] inline u32 count(void) const { return m_Image.layer_count(); }
+		[[nodiscard]] inline u32 mip_levels(void) const { return m_Image.mip_levels(); }
+		[[nodiscard]] inline vk::Format format(void) const { return m_Image.format; }
 
 		[[nodiscard]] inline const DeviceImage& img(void) const { return m_Image; }
 		[[nodiscard]] inline vk::ImageView img_view(void) const { return m_ImageView; }
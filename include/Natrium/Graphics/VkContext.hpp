@@ -2,10 +2,14 @@
 #define NA_VK_CONTEXT_HPP
 
 #include "Natrium/Core.hpp"
+#include "Natrium/Graphics/DeviceAllocator.hpp"
+#include "Natrium/Graphics/Submission.hpp"
 
 namespace Na {
     inline constexpr bool k_ValidationLayersEnabled = k_BuildConfig != BuildConfig::Distribution;
 
+	class StagingRing;
+
 	struct SurfaceSupport {
 		vk::SurfaceCapabilitiesKHR capabilities;
 		Na::ArrayVector<vk::SurfaceFormatKHR> formats;
@@ -26,24 +30,104 @@ namespace Na {
 		VkContext(VkContext&& other);
 		VkContext& operator=(VkContext&& other);
 
-		static VkContext Initialize(void);
+		/// 
+		/// pipeline_cache_path is where the driver's pipeline cache is loaded from and saved to on shutdown,
+		/// an empty path keeps the cache in memory only
+		/// 
+		static VkContext Initialize(const std::filesystem::path& pipeline_cache_path = {});
 		static void Shutdown(void);
 
-		static inline void WaitForRemainingDeviceTasks(void) { s_Context->m_LogicalDevice.waitIdle(); }
-
+		/// 
+		/// writes the pipeline cache to disk, called by Shutdown
+		/// 
+		static void SavePipelineCache(void);
+
+		/// 
+		/// idles the device and runs every deferred destruction
+		/// 
+		static void WaitForRemainingDeviceTasks(void);
+
+		/// 
+		/// runs destroy once the frames in flight, the frame being recorded and every submission made so far
+		/// have completed, DeviceBuffer, DeviceImage, Texture and the pipelines are destroyed through this
+		/// 
+		static void DeferDestruction(std::function<void(void)> destroy);
+
+		/// 
+		/// hands out the open CommandBatch's command buffer if there is one
+		/// 
 		static vk::CommandBuffer BeginSingleTimeCommands(void);
+
+		/// 
+		/// submits and waits for just this submission, does nothing while a CommandBatch is open
+		/// 
 		static void EndSingleTimeCommands(vk::CommandBuffer cmd_buffer);
 
+		/// 
+		/// submits without waiting, the command buffer is freed once the token completes
+		/// 
+		static SubmissionToken SubmitSingleTimeCommands(vk::CommandBuffer cmd_buffer);
+
+		/// 
+		/// records for the transfer queue (the graphics queue on devices without a separate transfer family)
+		/// 
+		static vk::CommandBuffer BeginTransferCommands(void);
+
+		/// 
+		/// submits without waiting, the barriers describe the copies' destinations: their src side the transfer writes,
+		/// their dst side the graphics queue's use, ownership is released and acquired across the queue families
+		/// so anything submitted to the graphics queue afterwards sees the data, it only waits for the transfer
+		/// at the stages the dst accesses are made in
+		/// 
+		[[nodiscard]] static SubmissionToken EndTransferCommands(
+			vk::CommandBuffer cmd_buffer,
+			const vk::BufferMemoryBarrier* buffer_barriers,
+			u32 buffer_barrier_count,
+			const vk::ImageMemoryBarrier* image_barriers,
+			u32 image_barrier_count
+		);
+
 		[[nodiscard]] static inline vk::Instance               GetInstance(void)       { return s_Context->m_Instance; }
 		[[nodiscard]] static inline vk::DebugUtilsMessengerEXT GetDebugMessenger(void) { return s_Context->m_DebugMessenger; }
 		[[nodiscard]] static inline vk::PhysicalDevice         GetPhysicalDevice(void) { return s_Context->m_PhysicalDevice; }
 		[[nodiscard]] static inline vk::Device                 GetLogicalDevice(void)  { return s_Context->m_LogicalDevice; }
 
 		[[nodiscard]] static inline vk::Queue                  GetGraphicsQueue(void)  { return s_Context->m_GraphicsQueue; }
+		[[nodiscard]] static inline vk::Queue                  GetTransferQueue(void)  { return s_Context->m_TransferQueue; }
+		[[nodiscard]] static inline QueueFamilyIndices         GetQueueFamilyIndices(void) { return s_Context->m_QueueIndices; }
+
+		[[nodiscard]] static inline vk::PipelineCache          GetPipelineCache(void)  { return s_Context->m_PipelineCache; }
+		[[nodiscard]] static inline DeviceAllocator&           GetAllocator(void)      { return *s_Context->m_Allocator; }
+		[[nodiscard]] static inline StagingRing&               GetStagingRing(void)    { return *s_Context->m_StagingRing; }
 
 
 		[[nodiscard]] static inline vk::SampleCountFlagBits    GetMSAASamples(bool enabled = true) { return enabled ? s_Context->m_MSAASamples : vk::SampleCountFlagBits::e1; }
 
+		/// 
+		/// VK_API_VERSION of the picked device, the instance targets 1.1 but the device can be older
+		/// 
+		[[nodiscard]] static inline u32                        GetDeviceApiVersion(void) { return s_Context->m_DeviceApiVersion; }
+
+		/// 
+		/// whether the device was created with the descriptor indexing features BindlessTextures needs
+		/// 
+		[[nodiscard]] static inline bool                       IsBindlessSupported(void) { return s_Context->m_BindlessSupported; }
+
+		/// 
+		/// without it indirect draws are issued one command at a time
+		/// 
+		[[nodiscard]] static inline bool                       IsMultiDrawIndirectSupported(void) { return s_Context->m_MultiDrawIndirectSupported; }
+
+		/// 
+		/// without it the first instance of every indirect command has to be 0
+		/// 
+		[[nodiscard]] static inline bool                       IsDrawIndirectFirstInstanceSupported(void) { return s_Context->m_DrawIndirectFirstInstanceSupported; }
+
+		/// 
+		/// VK_KHR_draw_indirect_count's command, null if the device doesn't have the extension
+		/// 
+		[[nodiscard]] static inline PFN_vkCmdDrawIndexedIndirectCountKHR GetCmdDrawIndexedIndirectCount(void) { return s_Context->m_CmdDrawIndexedIndirectCount; }
+
 	private:
 		vk::Instance               m_Instance;
 		vk::DebugUtilsMessengerEXT m_DebugMessenger;
@@ -51,11 +135,23 @@ namespace Na {
 		vk::Device                 m_LogicalDevice;
 												    
 		vk::Queue                  m_GraphicsQueue;
+		vk::Queue                  m_TransferQueue;
+		QueueFamilyIndices         m_QueueIndices;
 
 		vk::CommandPool            m_SingleTimeCmdPool;
+		vk::CommandPool            m_TransferCmdPool;
+
+		vk::PipelineCache          m_PipelineCache;
+		DeviceAllocator*           m_Allocator = nullptr; // behind pointers, the context is moved bytewise
+		StagingRing*               m_StagingRing = nullptr;
 
 
 		vk::SampleCountFlagBits    m_MSAASamples = vk::SampleCountFlagBits::e1;
+		u32                        m_DeviceApiVersion = 0;
+		bool                       m_BindlessSupported = false;
+		bool                       m_MultiDrawIndirectSupported = false;
+		bool                       m_DrawIndirectFirstInstanceSupported = false;
+		PFN_vkCmdDrawIndexedIndirectCountKHR m_CmdDrawIndexedIndirectCount = nullptr;
 
 		static inline VkContext* s_Context = nullptr;
 	};
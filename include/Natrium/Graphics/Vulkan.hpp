@@ -11,7 +11,10 @@
 namespace Na {
 	struct QueueFamilyIndices {
 		u32 graphics = UINT32_MAX;
+		u32 transfer = UINT32_MAX; // same as graphics when the device has no separate transfer family
+
 		inline operator bool(void) const { return graphics != UINT32_MAX; }
+		[[nodiscard]] inline bool dedicated_transfer(void) const { return transfer != graphics; }
 
 		static QueueFamilyIndices Get(vk::PhysicalDevice device, vk::SurfaceKHR surface);
 	};
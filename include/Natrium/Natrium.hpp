@@ -15,12 +15,14 @@
 #include "./Assets/Asset.hpp"
 #include "./Assets/AssetRegistry.hpp"
 #include "./Assets/ImageAsset.hpp"
+#include "./Assets/Ktx2Asset.hpp"
 #include "./Assets/ShaderAsset.hpp"
 #include "./Assets/ModelAsset.hpp"
 
 #include "./Graphics/Renderer/RendererSettings.hpp"
 #include "./Graphics/Renderer/RendererCore.hpp"
 #include "./Graphics/Pipeline.hpp"
+#include "./Graphics/ShaderReflection.hpp"
 #include "./Graphics/Buffers/VertexBuffer.hpp"
 #include "./Graphics/Buffers/IndexBuffer.hpp"
 #include "./Graphics/Buffers/UniformBuffer.hpp"
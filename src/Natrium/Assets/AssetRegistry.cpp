@@ -1,6 +1,9 @@
 #include "Pch.hpp"
 #include "Natrium/Assets/AssetRegistry.hpp"
 
+#include "Natrium/Core/ParallelFor.hpp"
+#include "Natrium/Core/Logger.hpp"
+
 #if defined(NA_PLATFORM_WINDOWS)
 #define C_STR string().c_str
 #elif defined(NA_PLATFORM_LINUX)
@@ -23,6 +26,7 @@ namespace Na {
 	void AssetRegistry::destroy(void)
 	{
 		m_Assets.clear();
+		m_ShaderVariants.clear();
 		m_AssetDir.clear();
 		m_ShaderOutputDir.clear();
 	}
@@ -33,42 +37,160 @@ namespace Na {
 		const std::string_view& entry_point
 	) const
 	{
-		std::filesystem::path input_path = m_AssetDir / src_path;
-		std::filesystem::path output_path = m_ShaderOutputDir / input_path.filename().replace_extension(".spv");
+		return ShaderModule(
+			ShaderBinary(this->_load_or_compile(ShaderString(m_AssetDir / src_path), stage, entry_point)),
+			stage,
+			entry_point
+		);
+	}
+
+	ShaderModule AssetRegistry::create_shader_module_from_str(
+		const std::string_view& name,
+		const std::string_view& src,
+		ShaderStageBits stage,
+		const std::string_view& entry_point
+	) const
+	{
+		return ShaderModule(
+			ShaderBinary(this->_load_or_compile(ShaderString(src, name, m_AssetDir), stage, entry_point)),
+			stage,
+			entry_point
+		);
+	}
 
-		if (std::filesystem::exists(output_path) &&
-			std::filesystem::last_write_time(output_path)
-				> std::filesystem::last_write_time(input_path))
-			return ShaderModule(LoadSpv(output_path), stage, entry_point);
+	ShaderModule AssetRegistry::create_shader_variant(
+		const std::string_view& src_path,
+		ShaderStageBits stage,
+		const std::vector<ShaderDefine>& defines,
+		const std::string_view& entry_point
+	)
+	{
+		// the same set in a different order is the same variant
+		std::vector<ShaderDefine> sorted_defines(defines);
+		std::sort(sorted_defines.begin(), sorted_defines.end());
 
-		ShaderBinary shader_binary(ShaderString(m_AssetDir / src_path).compile());
+		std::string key = NA_FORMAT("{}|{}|{}", src_path, (u32)stage, entry_point);
+		for (const ShaderDefine& define : sorted_defines)
+			key += NA_FORMAT("|{}={}", define.name, define.value);
 
-		std::ofstream output_file(output_path, std::ios::binary);
-		NA_ASSERT(output_file, "Failed to open file {}", output_path.C_STR());
+		auto it = m_ShaderVariants.find(key);
+		if (it == m_ShaderVariants.end())
+		{
+			ShaderString src(m_AssetDir / src_path);
+			for (const ShaderDefine& define : sorted_defines)
+				src.define(define);
 
-		output_file.write((const char*)shader_binary.ptr(), shader_binary.size());
-		output_file.close();
+			it = m_ShaderVariants.emplace(std::move(key), this->_load_or_compile(src, stage, entry_point)).first;
+		}
 
-		return ShaderModule(shader_binary, stage, entry_point);
+		return ShaderModule(ShaderBinary(it->second), stage, entry_point);
 	}
 
-	ShaderModule AssetRegistry::create_shader_module_from_str(
-		const std::string_view& name,
-		const std::string_view& src,
+	std::vector<ShaderModule> AssetRegistry::create_shader_modules(
+		const ShaderCompileJob* jobs,
+		u32 count,
+		u32 thread_count
+	) const
+	{
+		std::vector<ArrayVector<u32>> binaries(count);
+		std::vector<ShaderCompileLog> logs(count);
+
+		// g_Logger isn't thread safe, so the workers only fill in their logs
+		ParallelFor(count, [&](u64 i)
+		{
+			const ShaderCompileJob& job = jobs[i];
+			logs[i].name = job.path;
+
+			try
+			{
+				ShaderString src = job.src.empty()
+					? ShaderString(m_AssetDir / job.path)
+					: ShaderString(job.src, job.path, m_AssetDir);
+				for (const ShaderDefine& define : job.defines)
+					src.define(define);
+
+				binaries[i] = this->_load_or_compile(src, job.stage, job.entry_point, &logs[i]);
+			} catch (const std::exception& e)
+			{
+				logs[i].success = false;
+				logs[i].messages += e.what();
+			}
+		}, thread_count);
+
+		for (const ShaderCompileLog& log : logs)
+			log.report();
+
+		std::vector<ShaderModule> modules;
+		modules.reserve(count);
+		for (u32 i = 0; i < count; i++)
+			modules.emplace_back(ShaderBinary(binaries[i]), jobs[i].stage, jobs[i].entry_point);
+		return modules;
+	}
+
+	ArrayVector<u32> AssetRegistry::_load_or_compile(
+		const ShaderString& src,
 		ShaderStageBits stage,
-		const std::string_view& entry_point
+		const std::string_view& entry_point,
+		ShaderCompileLog* log
 	) const
 	{
-		std::filesystem::path output_path = (m_ShaderOutputDir / name).replace_extension(".spv");
+		// keyed by content instead of mtime, so edited includes and in-memory sources hit the cache too
+		u64 hash = src.content_hash(entry_point, stage, log);
+		if (log && !log->success)
+			return ArrayVector<u32>();
+
+		std::filesystem::path output_path = m_ShaderOutputDir / NA_FORMAT("{:016x}.spv", hash);
+
+		if (std::filesystem::exists(output_path))
+			return LoadSpv(output_path);
 
-		ShaderBinary shader_binary(ShaderString(src, name).compile());
+		ArrayVector<u32> spv = src.compile(entry_point, stage, log);
+		if (spv.empty())
+			return spv;
 
-		std::ofstream output_file(output_path, std::ios::binary);
-		NA_ASSERT(output_file, "Failed to open file {}", output_path.C_STR());
+		// written under a temporary name first so a crash never leaves a truncated binary behind,
+		// the thread id keeps concurrent batch jobs for the same shader apart
+		std::filesystem::path temp_path = output_path;
+		temp_path += NA_FORMAT(".{}.tmp", std::hash<std::thread::id>()(std::this_thread::get_id()));
 
-		output_file.write((const char*)shader_binary.ptr(), shader_binary.size());
+		// a cache that can't be written only costs a recompile next time, workers report through their log
+		auto cache_failed = [&](const std::string& message)
+		{
+			if (log)
+			{
+				log->messages += message + '\n';
+				log->warning_count++;
+			} else
+			{
+				g_Logger.log(Warn, message);
+			}
+		};
+
+		std::ofstream output_file(temp_path, std::ios::binary);
+		if (!output_file)
+		{
+			cache_failed(NA_FORMAT("Failed to cache shader binary: Can't open {}!", temp_path.string()));
+			return spv;
+		}
+
+		output_file.write((const char*)spv.ptr(), spv.size() * sizeof(u32));
 		output_file.close();
 
-		return ShaderModule(shader_binary, stage, entry_point);
+		std::error_code error;
+		if (!output_file)
+		{
+			cache_failed(NA_FORMAT("Failed to cache shader binary: Can't write {}!", temp_path.string()));
+			std::filesystem::remove(temp_path, error);
+			return spv;
+		}
+
+		std::filesystem::rename(temp_path, output_path, error);
+		if (error)
+		{
+			cache_failed(NA_FORMAT("Failed to cache shader binary {}: {}", output_path.string(), error.message()));
+			std::filesystem::remove(temp_path, error);
+		}
+
+		return spv;
 	}
 } // namespace Na
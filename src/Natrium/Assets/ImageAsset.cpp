@@ -17,14 +17,34 @@ namespace Na {
 		AssetHandle<ImageAsset> img_asset = std::make_shared<ImageAsset>();
 
 		int channels;
-		img_asset->m_Data = (void*)stbi_load(
-			path.C_STR(),
-			&img_asset->m_Width,
-			&img_asset->m_Height,
-			&channels,
-			STBI_rgb_alpha
-		);
-		img_asset->m_Size = (u64)img_asset->m_Width * img_asset->m_Height * 4;
+		if (!stbi_info(path.C_STR(), &img_asset->m_Width, &img_asset->m_Height, &channels))
+		{
+			img_asset->m_Data = nullptr;
+			img_asset->m_Size = 0;
+			return img_asset;
+		}
+
+		// 3 channel formats are barely supported for sampling
+		img_asset->m_Channels = channels == STBI_rgb ? STBI_rgb_alpha : (u32)channels;
+		img_asset->m_ChannelSize = stbi_is_16_bit(path.C_STR()) ? 2 : 1;
+
+		if (img_asset->m_ChannelSize == 2)
+			img_asset->m_Data = (void*)stbi_load_16(
+				path.C_STR(),
+				&img_asset->m_Width,
+				&img_asset->m_Height,
+				&channels,
+				(int)img_asset->m_Channels
+			);
+		else
+			img_asset->m_Data = (void*)stbi_load(
+				path.C_STR(),
+				&img_asset->m_Width,
+				&img_asset->m_Height,
+				&channels,
+				(int)img_asset->m_Channels
+			);
+		img_asset->m_Size = (u64)img_asset->m_Width * img_asset->m_Height * img_asset->texel_size();
 
 		return img_asset;
 	}
@@ -0,0 +1,133 @@
+#include "Pch.hpp"
+#include "Natrium/Assets/Ktx2Asset.hpp"
+
+#include <bit>
+
+namespace Na {
+	static constexpr Byte k_Ktx2Identifier[12] = {
+		0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n'
+	};
+
+	struct Ktx2Header {
+		Byte identifier[12];
+
+		u32 vk_format;
+		u32 type_size;
+		u32 pixel_width;
+		u32 pixel_height;
+		u32 pixel_depth;
+		u32 layer_count;
+		u32 face_count;
+		u32 level_count;
+		u32 supercompression_scheme;
+
+		u32 dfd_byte_offset;
+		u32 dfd_byte_length;
+		u32 kvd_byte_offset;
+		u32 kvd_byte_length;
+		u64 sgd_byte_offset;
+		u64 sgd_byte_length;
+	};
+	static_assert(sizeof(Ktx2Header) == 80, "Ktx2Header has to match the on-disk layout!");
+
+	struct Ktx2LevelIndex {
+		u64 byte_offset;
+		u64 byte_length;
+		u64 uncompressed_byte_length;
+	};
+
+	// the start of the basic data format descriptor block, preceded by the descriptor's total size
+	struct Ktx2FormatDescriptor {
+		u32 total_size;
+		u32 vendor_and_type;
+		u16 version;
+		u16 block_size;
+		u8 color_model;
+		u8 color_primaries;
+		u8 transfer_function;
+		u8 flags;
+		u8 texel_block_dimension[4]; // minus 1
+		u8 bytes_plane[8];
+	};
+	static_assert(sizeof(Ktx2FormatDescriptor) == 32, "Ktx2FormatDescriptor has to match the on-disk layout!");
+
+	AssetHandle<Ktx2Asset> Ktx2Asset::Load(const std::filesystem::path& path)
+	{
+		AssetHandle<Ktx2Asset> asset = std::make_shared<Ktx2Asset>();
+		asset->m_File.map(path);
+
+		const MappedFile& file = asset->m_File;
+		NA_VERIFY(file.size() >= sizeof(Ktx2Header), "Failed to load {}: File is too small!", path.string());
+
+		Ktx2Header header;
+		memcpy(&header, file.data(), sizeof(Ktx2Header));
+
+		NA_VERIFY(!memcmp(header.identifier, k_Ktx2Identifier, sizeof(k_Ktx2Identifier)), "Failed to load {}: Not a KTX2 file!", path.string());
+		NA_VERIFY(header.supercompression_scheme == 0, "Failed to load {}: Supercompressed KTX2 files are not supported!", path.string());
+		NA_VERIFY(header.vk_format != VK_FORMAT_UNDEFINED, "Failed to load {}: Basis universal KTX2 files are not supported!", path.string());
+		NA_VERIFY(header.pixel_depth <= 1, "Failed to load {}: 3D textures are not supported!", path.string());
+		NA_VERIFY(header.pixel_width && header.pixel_height, "Failed to load {}: Invalid size!", path.string());
+
+		asset->m_Format = (vk::Format)header.vk_format;
+		asset->m_Width = header.pixel_width;
+		asset->m_Height = header.pixel_height;
+		asset->m_LayerCount = std::max(header.layer_count, 1u) * std::max(header.face_count, 1u);
+		asset->m_Cubemap = header.face_count == 6;
+		asset->m_GenerateMips = header.level_count == 0;
+
+		u32 level_count = std::max(header.level_count, 1u);
+		NA_VERIFY(
+			file.size() >= sizeof(Ktx2Header) + level_count * sizeof(Ktx2LevelIndex),
+			"Failed to load {}: Truncated level index!",
+				path.string()
+		);
+		NA_VERIFY(
+			level_count <= (u32)std::bit_width(std::max(header.pixel_width, header.pixel_height)),
+			"Failed to load {}: {} levels are more than a full mip chain!",
+				path.string(), level_count
+		);
+
+		// the descriptor knows the block size of every format, so levels are checked without a format table
+		NA_VERIFY(
+			header.dfd_byte_length >= sizeof(Ktx2FormatDescriptor) && (u64)header.dfd_byte_offset + header.dfd_byte_length <= file.size(),
+			"Failed to load {}: Missing data format descriptor!",
+				path.string()
+		);
+
+		Ktx2FormatDescriptor dfd;
+		memcpy(&dfd, file.data() + header.dfd_byte_offset, sizeof(Ktx2FormatDescriptor));
+
+		u32 block_width = dfd.texel_block_dimension[0] + 1u;
+		u32 block_height = dfd.texel_block_dimension[1] + 1u;
+		u32 block_size = dfd.bytes_plane[0];
+		NA_VERIFY(block_size, "Failed to load {}: Invalid data format descriptor!", path.string());
+
+		asset->m_Levels.resize(level_count);
+		for (u32 i = 0; i < level_count; i++)
+		{
+			Ktx2LevelIndex index;
+			memcpy(&index, file.data() + sizeof(Ktx2Header) + i * sizeof(Ktx2LevelIndex), sizeof(Ktx2LevelIndex));
+
+			NA_VERIFY(
+				index.byte_offset <= file.size() && index.byte_length <= file.size() - index.byte_offset,
+				"Failed to load {}: Level {} is out of bounds!",
+					path.string(), i
+			);
+
+			u64 level_width = std::max(header.pixel_width >> i, 1u);
+			u64 level_height = std::max(header.pixel_height >> i, 1u);
+			u64 expected_size = ((level_width + block_width - 1) / block_width)
+							  * ((level_height + block_height - 1) / block_height)
+							  * block_size * asset->m_LayerCount;
+			NA_VERIFY(
+				index.byte_length == expected_size,
+				"Failed to load {}: Level {} is {} bytes instead of {}!",
+					path.string(), i, index.byte_length, expected_size
+			);
+
+			asset->m_Levels[i] = { index.byte_offset, index.byte_length };
+		}
+
+		return asset;
+	}
+} // namespace Na
@@ -2,6 +2,7 @@
 #include "Natrium/Assets/ShaderAsset.hpp"
 
 #include "Natrium/Core/Logger.hpp"
+#include "Natrium/Core/Hash.hpp"
 #include "Natrium/Graphics/VkContext.hpp"
 
 #include <shaderc/shaderc.hpp>
@@ -36,7 +37,8 @@ namespace Na {
 	}
 
 	ShaderString::ShaderString(const std::filesystem::path& path)
-	: m_Name(path.filename().string())
+	: m_Name(path.filename().string()),
+	m_IncludeDir(path.parent_path())
 	{
 		std::ifstream shader_file(path, std::ios::ate | std::ios::binary);
 		NA_ASSERT(shader_file, "Failed to open file {}", path.C_STR());
@@ -48,61 +50,206 @@ namespace Na {
 		shader_file.close();
 	}
 
-	ArrayVector<u32> ShaderString::compile(const std::string_view& entry_point) const
+	// bump whenever the compile options change in a way the hash can't see
+	static constexpr u64 k_ShaderCacheVersion = 1;
+
+	class ShaderIncluder : public shaderc::CompileOptions::IncluderInterface {
+	public:
+		ShaderIncluder(const std::filesystem::path& include_dir) : m_IncludeDir(include_dir) {}
+
+		shaderc_include_result* GetInclude(
+			const char* requested_source,
+			shaderc_include_type type,
+			const char* requesting_source,
+			size_t include_depth
+		) override
+		{
+			// relative includes start from the including file, standard includes from the include dir
+			std::filesystem::path base = type == shaderc_include_type_relative && include_depth > 1
+				? std::filesystem::path(requesting_source).parent_path()
+				: m_IncludeDir;
+			std::filesystem::path path = base / requested_source;
+
+			IncludeResult* result = new IncludeResult;
+
+			std::ifstream file(path, std::ios::ate | std::ios::binary);
+			if (file)
+			{
+				result->name = path.string();
+				result->content.resize((u64)file.tellg());
+				file.seekg(0);
+				file.read(result->content.data(), result->content.size());
+			} else
+			{
+				// an empty name tells shaderc the include failed, the content is the error message
+				result->content = NA_FORMAT("Failed to open include file {}", path.string());
+			}
+
+			result->result.source_name = result->name.c_str();
+			result->result.source_name_length = result->name.size();
+			result->result.content = result->content.c_str();
+			result->result.content_length = result->content.size();
+			result->result.user_data = result;
+			return &result->result;
+		}
+
+		void ReleaseInclude(shaderc_include_result* data) override
+		{
+			delete (IncludeResult*)data->user_data;
+		}
+	private:
+		struct IncludeResult {
+			shaderc_include_result result;
+			std::string name, content;
+		};
+
+		std::filesystem::path m_IncludeDir;
+	};
+
+	static shaderc_shader_kind shaderKind(ShaderStageBits stage)
+	{
+		// the default kinds still let #pragma shader_stage take precedence
+		switch (stage)
+		{
+		case ShaderStageBits::Vertex: return shaderc_glsl_default_vertex_shader;
+		case ShaderStageBits::Fragment: return shaderc_glsl_default_fragment_shader;
+		case ShaderStageBits::Compute: return shaderc_glsl_default_compute_shader;
+		default: return shaderc_glsl_infer_from_source;
+		}
+	}
+
+	static shaderc::Compiler& persistentCompiler(void)
+	{
+		// expensive to construct, one per thread keeps batch compiles from sharing any state
+		thread_local shaderc::Compiler x_Compiler;
+		return x_Compiler;
+	}
+
+	static shaderc::CompileOptions compileOptions(const std::filesystem::path& include_dir, const std::vector<ShaderDefine>& defines)
 	{
-		shaderc::Compiler compiler;
 		shaderc::CompileOptions options;
 
+		// macros end up in the preprocessed source, so content_hash() already tells variants apart
+		for (const ShaderDefine& define : defines)
+			options.AddMacroDefinition(define.name, define.value);
+
 		if (k_BuildConfig != BuildConfig::Debug)
 			options.SetOptimizationLevel(shaderc_optimization_level_performance);
 
-		shaderc::SpvCompilationResult spv = compiler.CompileGlslToSpv(
-			m_Data.c_str(),
-			m_Data.size(),
-			shaderc_glsl_infer_from_source,
-			m_Name.data(),
-			entry_point.data(),
-			options
-		);
+		options.SetIncluder(std::make_unique<ShaderIncluder>(include_dir));
+		return options;
+	}
 
-		if (g_Logger.enabled())
+	void ShaderCompileLog::report(void) const
+	{
+		if (!this->success)
 		{
-			if (spv.GetCompilationStatus() == shaderc_compilation_status_success)
-			{
-				if (spv.GetNumWarnings())
-				{
-					g_Logger.fmt(
-						Na::Warn,
-						"Compiled {} with {} warnings!",
-							m_Name,
-							spv.GetNumWarnings()
-					);
-					g_Logger.log(Na::Warn, spv.GetErrorMessage());
-				} else
-				{
-					g_Logger.fmt(
-						Info,
-						"Compiled {} with 0 warnings!",
-							m_Name
-					);
-				}
-			} else
+			if (g_Logger.enabled())
 			{
 				g_Logger.fmt(
 					Na::Error,
 					"Failed to compile {} with {} errors and {} warnings!",
-						m_Name,
-						spv.GetNumErrors(),
-						spv.GetNumWarnings()
+						this->name,
+						this->error_count,
+						this->warning_count
 				);
-				g_Logger.log(Na::Error, spv.GetErrorMessage());
-				throw std::runtime_error("Failed to compile shader!");
+				g_Logger.log(Na::Error, this->messages);
 			}
+			throw std::runtime_error("Failed to compile shader!");
 		}
 
+		if (!this->compiled || !g_Logger.enabled())
+			return;
+
+		if (this->warning_count)
+		{
+			g_Logger.fmt(
+				Na::Warn,
+				"Compiled {} with {} warnings!",
+					this->name,
+					this->warning_count
+			);
+			g_Logger.log(Na::Warn, this->messages);
+		} else
+		{
+			g_Logger.fmt(
+				Info,
+				"Compiled {} with 0 warnings!",
+					this->name
+			);
+		}
+	}
+
+	template<typename t_Result>
+	static void recordResult(const t_Result& result, const std::string& name, ShaderCompileLog& log)
+	{
+		log.name = name;
+		log.messages += result.GetErrorMessage();
+		log.warning_count += result.GetNumWarnings();
+		log.error_count += result.GetNumErrors();
+		log.success = result.GetCompilationStatus() == shaderc_compilation_status_success;
+	}
+
+	ArrayVector<u32> ShaderString::compile(const std::string_view& entry_point, ShaderStageBits stage, ShaderCompileLog* log) const
+	{
+		shaderc::SpvCompilationResult spv = persistentCompiler().CompileGlslToSpv(
+			m_Data.c_str(),
+			m_Data.size(),
+			shaderKind(stage),
+			m_Name.c_str(),
+			std::string(entry_point).c_str(),
+			compileOptions(m_IncludeDir, m_Defines)
+		);
+
+		ShaderCompileLog local_log;
+		ShaderCompileLog& result_log = log ? *log : local_log;
+		recordResult(spv, m_Name, result_log);
+		result_log.compiled = true;
+
+		if (!log)
+			result_log.report();
+
+		if (!result_log.success)
+			return ArrayVector<u32>();
 		return ArrayVector<u32>(spv.begin(), spv.end());
 	}
 
+	std::string ShaderString::preprocess(ShaderStageBits stage, ShaderCompileLog* log) const
+	{
+		shaderc::PreprocessedSourceCompilationResult result = persistentCompiler().PreprocessGlsl(
+			m_Data.c_str(),
+			m_Data.size(),
+			shaderKind(stage),
+			m_Name.c_str(),
+			compileOptions(m_IncludeDir, m_Defines)
+		);
+
+		// warnings are reported once the source is actually compiled
+		if (result.GetCompilationStatus() != shaderc_compilation_status_success)
+		{
+			ShaderCompileLog local_log;
+			ShaderCompileLog& result_log = log ? *log : local_log;
+			recordResult(result, m_Name, result_log);
+
+			if (!log)
+				result_log.report();
+			return std::string();
+		}
+
+		return std::string(result.begin(), result.end());
+	}
+
+	u64 ShaderString::content_hash(const std::string_view& entry_point, ShaderStageBits stage, ShaderCompileLog* log) const
+	{
+		std::string preprocessed = this->preprocess(stage, log);
+
+		u64 hash = Fnv1a(preprocessed.data(), preprocessed.size());
+		hash = Fnv1a(entry_point.data(), entry_point.size(), hash);
+		hash = Fnv1a(&stage, sizeof(stage), hash);
+		hash = Fnv1a(&k_BuildConfig, sizeof(k_BuildConfig), hash);
+		return Fnv1a(&k_ShaderCacheVersion, sizeof(k_ShaderCacheVersion), hash);
+	}
+
 	AssetHandle<ShaderBinary> ShaderBinary::Load(const std::filesystem::path& path)
 	{
 		return std::make_shared<ShaderBinary>(LoadSpv(path));
@@ -63,7 +63,7 @@ namespace Na {
 		NA_ASSERT(result, "Failed to initialize glfw!");
 		glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
 
-		context.m_VkContext = VkContext::Initialize();
+		context.m_VkContext = VkContext::Initialize(context.m_ExecDir / "pipeline_cache.bin");
 
 		s_Context = &context;
 		return context;
@@ -0,0 +1,101 @@
+#include "Pch.hpp"
+#include "Natrium/Core/MappedFile.hpp"
+
+#if defined(NA_PLATFORM_WINDOWS)
+#include <Windows.h>
+#elif defined(NA_PLATFORM_LINUX)
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif // NA_PLATFORM
+
+namespace Na {
+	void MappedFile::map(const std::filesystem::path& path)
+	{
+		if (m_Data)
+			this->unmap();
+
+	#if defined(NA_PLATFORM_WINDOWS)
+		m_File = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+		NA_VERIFY(m_File != INVALID_HANDLE_VALUE, "Failed to open file {}", path.string());
+
+		LARGE_INTEGER size;
+		GetFileSizeEx((HANDLE)m_File, &size);
+		m_Size = (u64)size.QuadPart;
+
+		if (!m_Size)
+		{
+			CloseHandle((HANDLE)m_File);
+			m_File = nullptr;
+			return;
+		}
+
+		m_Mapping = CreateFileMappingW((HANDLE)m_File, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		NA_VERIFY(m_Mapping, "Failed to map file {}", path.string());
+
+		m_Data = (const Byte*)MapViewOfFile((HANDLE)m_Mapping, FILE_MAP_READ, 0, 0, 0);
+	#elif defined(NA_PLATFORM_LINUX)
+		int fd = open(path.c_str(), O_RDONLY);
+		NA_VERIFY(fd != -1, "Failed to open file {}", path.string());
+
+		struct stat info;
+		fstat(fd, &info);
+		m_Size = (u64)info.st_size;
+
+		if (!m_Size)
+		{
+			close(fd);
+			return;
+		}
+
+		void* data = mmap(nullptr, m_Size, PROT_READ, MAP_PRIVATE, fd, 0);
+		close(fd);
+
+		m_Data = data != MAP_FAILED ? (const Byte*)data : nullptr;
+	#endif // NA_PLATFORM
+
+		NA_VERIFY(m_Data, "Failed to map file {}", path.string());
+	}
+
+	void MappedFile::unmap(void)
+	{
+	#if defined(NA_PLATFORM_WINDOWS)
+		if (m_Data)
+			UnmapViewOfFile(m_Data);
+		if (m_Mapping)
+			CloseHandle((HANDLE)m_Mapping);
+		if (m_File)
+			CloseHandle((HANDLE)m_File);
+		m_Mapping = nullptr;
+		m_File = nullptr;
+	#elif defined(NA_PLATFORM_LINUX)
+		if (m_Data)
+			munmap((void*)m_Data, m_Size);
+	#endif // NA_PLATFORM
+
+		m_Data = nullptr;
+		m_Size = 0;
+	}
+
+	MappedFile::MappedFile(MappedFile&& other)
+	: m_Data(std::exchange(other.m_Data, nullptr)),
+	m_Size(std::exchange(other.m_Size, 0))
+	#if defined(NA_PLATFORM_WINDOWS)
+	, m_File(std::exchange(other.m_File, nullptr)),
+	m_Mapping(std::exchange(other.m_Mapping, nullptr))
+	#endif // NA_PLATFORM_WINDOWS
+	{}
+
+	MappedFile& MappedFile::operator=(MappedFile&& other)
+	{
+		this->unmap();
+		m_Data = std::exchange(other.m_Data, nullptr);
+		m_Size = std::exchange(other.m_Size, 0);
+	#if defined(NA_PLATFORM_WINDOWS)
+		m_File = std::exchange(other.m_File, nullptr);
+		m_Mapping = std::exchange(other.m_Mapping, nullptr);
+	#endif // NA_PLATFORM_WINDOWS
+		return *this;
+	}
+} // namespace Na
@@ -0,0 +1,178 @@
+#include "Pch.hpp"
+#include "Natrium/Graphics/BindlessTextures.hpp"
+
+#include "Internal.hpp"
+
+#include <mutex>
+
+namespace Na {
+	static constexpr u32 k_MaxBindlessTextures = 16384;
+	// pipeline layouts that include the table count their own sets' sampled images (set 0 textures, the depth
+	// pyramid) against the same limits, so that many are left for them
+	static constexpr u32 k_ReservedSampledImages = 64;
+
+	static vk::DescriptorSetLayout s_Layout = nullptr;
+	static vk::DescriptorPool s_Pool = nullptr;
+	static vk::DescriptorSet s_Set = nullptr;
+	static u32 s_Capacity = 0;
+
+	static u32 s_NextIndex = 0;
+	static std::vector<u32> s_FreeIndices;
+	static std::mutex s_Mutex;
+
+	static u32 queryCapacity(void)
+	{
+		vk::PhysicalDeviceDescriptorIndexingPropertiesEXT indexing_properties;
+		vk::PhysicalDeviceProperties2 properties;
+		properties.pNext = &indexing_properties;
+		VkContext::GetPhysicalDevice().getProperties2(&properties);
+
+		u32 limit = std::min({
+			indexing_properties.maxDescriptorSetUpdateAfterBindSampledImages,
+			indexing_properties.maxDescriptorSetUpdateAfterBindSamplers,
+			indexing_properties.maxPerStageDescriptorUpdateAfterBindSampledImages,
+			indexing_properties.maxPerStageDescriptorUpdateAfterBindSamplers
+		});
+		NA_VERIFY(limit > k_ReservedSampledImages, "Failed to create bindless texture table: Device only allows {} sampled images per stage!", limit);
+
+		return std::min(k_MaxBindlessTextures, limit - k_ReservedSampledImages);
+	}
+
+	// called with s_Mutex held
+	static void initialize(void)
+	{
+		if (s_Set)
+			return;
+
+		NA_VERIFY(VkContext::IsBindlessSupported(), "Failed to create bindless texture table: Descriptor indexing isn't supported by the device!");
+
+		vk::Device device = VkContext::GetLogicalDevice();
+		s_Capacity = queryCapacity();
+
+		vk::DescriptorSetLayoutBinding binding;
+		binding.binding = 0;
+		binding.descriptorType = vk::DescriptorType::eCombinedImageSampler;
+		binding.descriptorCount = s_Capacity;
+		binding.stageFlags = vk::ShaderStageFlagBits::eVertex | vk::ShaderStageFlagBits::eFragment | vk::ShaderStageFlagBits::eCompute;
+
+		// slots are written while frames using other slots are in flight, most are never written at all
+		vk::DescriptorBindingFlagsEXT binding_flags =
+			vk::DescriptorBindingFlagBitsEXT::eUpdateAfterBind |
+			vk::DescriptorBindingFlagBitsEXT::eUpdateUnusedWhilePending |
+			vk::DescriptorBindingFlagBitsEXT::ePartiallyBound;
+
+		vk::DescriptorSetLayoutBindingFlagsCreateInfoEXT binding_flags_info;
+		binding_flags_info.bindingCount = 1;
+		binding_flags_info.pBindingFlags = &binding_flags;
+
+		vk::DescriptorSetLayoutCreateInfo layout_info;
+		layout_info.pNext = &binding_flags_info;
+		layout_info.flags = vk::DescriptorSetLayoutCreateFlagBits::eUpdateAfterBindPoolEXT;
+		layout_info.bindingCount = 1;
+		layout_info.pBindings = &binding;
+
+		s_Layout = device.createDescriptorSetLayout(layout_info);
+
+		vk::DescriptorPoolSize pool_size(vk::DescriptorType::eCombinedImageSampler, s_Capacity);
+
+		vk::DescriptorPoolCreateInfo pool_info;
+		pool_info.flags = vk::DescriptorPoolCreateFlagBits::eUpdateAfterBindEXT;
+		pool_info.maxSets = 1;
+		pool_info.poolSizeCount = 1;
+		pool_info.pPoolSizes = &pool_size;
+
+		s_Pool = device.createDescriptorPool(pool_info);
+
+		vk::DescriptorSetAllocateInfo alloc_info;
+		alloc_info.descriptorPool = s_Pool;
+		alloc_info.descriptorSetCount = 1;
+		alloc_info.pSetLayouts = &s_Layout;
+
+		NA_VERIFY(device.allocateDescriptorSets(&alloc_info, &s_Set) == vk::Result::eSuccess, "Failed to allocate bindless texture set!");
+	}
+
+	u32 BindlessTextures::Register(const Texture& texture)
+	{
+		std::lock_guard lock(s_Mutex);
+		initialize();
+
+		u32 index;
+		if (!s_FreeIndices.empty())
+		{
+			index = s_FreeIndices.back();
+			s_FreeIndices.pop_back();
+		} else
+		{
+			NA_VERIFY(s_NextIndex < s_Capacity, "Failed to register bindless texture: All {} slots are in use!", s_Capacity);
+			index = s_NextIndex++;
+		}
+
+		vk::DescriptorImageInfo image_info;
+		image_info.imageLayout = vk::ImageLayout::eShaderReadOnlyOptimal;
+		image_info.imageView = texture.img_view();
+		image_info.sampler = texture.sampler();
+
+		vk::WriteDescriptorSet write;
+		write.dstSet = s_Set;
+		write.dstBinding = 0;
+		write.dstArrayElement = index;
+		write.descriptorCount = 1;
+		write.descriptorType = vk::DescriptorType::eCombinedImageSampler;
+		write.pImageInfo = &image_info;
+
+		VkContext::GetLogicalDevice().updateDescriptorSets(1, &write, 0, nullptr);
+		return index;
+	}
+
+	void BindlessTextures::Unregister(u32 index)
+	{
+		std::lock_guard lock(s_Mutex);
+		NA_ASSERT(index < s_NextIndex, "Failed to unregister bindless texture: Index {} was never registered!", index);
+
+		// the slot keeps its stale descriptor, partially bound lets it sit there unused
+		VkContext::DeferDestruction([index]() {
+			std::lock_guard lock(s_Mutex);
+			s_FreeIndices.emplace_back(index);
+		});
+	}
+
+	vk::DescriptorSetLayout BindlessTextures::GetLayout(void)
+	{
+		std::lock_guard lock(s_Mutex);
+		initialize();
+		return s_Layout;
+	}
+
+	vk::DescriptorSet BindlessTextures::GetSet(void)
+	{
+		std::lock_guard lock(s_Mutex);
+		initialize();
+		return s_Set;
+	}
+
+	u32 BindlessTextures::GetCapacity(void)
+	{
+		std::lock_guard lock(s_Mutex);
+		initialize();
+		return s_Capacity;
+	}
+
+	void Internal::ShutdownBindlessTextures(void)
+	{
+		std::lock_guard lock(s_Mutex);
+		if (!s_Set)
+			return;
+
+		vk::Device device = VkContext::GetLogicalDevice();
+		device.destroyDescriptorPool(s_Pool);
+		device.destroyDescriptorSetLayout(s_Layout);
+
+		s_Layout = nullptr;
+		s_Pool = nullptr;
+		s_Set = nullptr;
+		s_Capacity = 0;
+
+		s_NextIndex = 0;
+		s_FreeIndices.clear();
+	}
+} // namespace Na
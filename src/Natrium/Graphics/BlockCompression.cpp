@@ -0,0 +1,481 @@
+#include "Pch.hpp"
+#include "Natrium/Graphics/BlockCompression.hpp"
+
+#include "Natrium/Core/ParallelFor.hpp"
+#include "Natrium/Graphics/VkContext.hpp"
+
+namespace Na {
+	vk::Format BlockFormatToVk(BlockFormat format, bool srgb)
+	{
+		switch (format)
+		{
+		case BlockFormat::BC1: return srgb ? vk::Format::eBc1RgbaSrgbBlock : vk::Format::eBc1RgbaUnormBlock;
+		case BlockFormat::BC3: return srgb ? vk::Format::eBc3SrgbBlock : vk::Format::eBc3UnormBlock;
+		case BlockFormat::BC5: return vk::Format::eBc5UnormBlock;
+		case BlockFormat::BC7: return srgb ? vk::Format::eBc7SrgbBlock : vk::Format::eBc7UnormBlock;
+		}
+		return vk::Format::eUndefined;
+	}
+
+	u32 BlockSize(BlockFormat format)
+	{
+		switch (format)
+		{
+		case BlockFormat::BC1: return 8;
+		case BlockFormat::BC3: return 16;
+		case BlockFormat::BC5: return 16;
+		case BlockFormat::BC7: return 16;
+		}
+		return 0;
+	}
+
+	u32 BlockSize(vk::Format format)
+	{
+		switch (format)
+		{
+		case vk::Format::eBc1RgbUnormBlock:
+		case vk::Format::eBc1RgbSrgbBlock:
+		case vk::Format::eBc1RgbaUnormBlock:
+		case vk::Format::eBc1RgbaSrgbBlock:
+		case vk::Format::eBc4UnormBlock:
+		case vk::Format::eBc4SnormBlock:
+			return 8;
+		case vk::Format::eBc2UnormBlock:
+		case vk::Format::eBc2SrgbBlock:
+		case vk::Format::eBc3UnormBlock:
+		case vk::Format::eBc3SrgbBlock:
+		case vk::Format::eBc5UnormBlock:
+		case vk::Format::eBc5SnormBlock:
+		case vk::Format::eBc6HUfloatBlock:
+		case vk::Format::eBc6HSfloatBlock:
+		case vk::Format::eBc7UnormBlock:
+		case vk::Format::eBc7SrgbBlock:
+			return 16;
+		}
+		return 0;
+	}
+
+	bool IsBlockFormatSupported(BlockFormat format, bool srgb)
+	{
+		if (format == BlockFormat::None)
+			return false;
+
+		if (!VkContext::GetPhysicalDevice().getFeatures().textureCompressionBC)
+			return false;
+
+		return FindSupportedFormat(
+			{ BlockFormatToVk(format, srgb) },
+			vk::ImageTiling::eOptimal,
+			vk::FormatFeatureFlagBits::eSampledImage
+		) != vk::Format::eUndefined;
+	}
+
+	using Block = std::array<std::array<u8, 4>, 16>;
+
+	static void fetchBlock(const Byte* rgba, u32 width, u32 height, u32 block_x, u32 block_y, Block& block)
+	{
+		for (u32 y = 0; y < 4; y++)
+		{
+			u32 src_y = std::min(block_y * 4 + y, height - 1);
+			for (u32 x = 0; x < 4; x++)
+			{
+				u32 src_x = std::min(block_x * 4 + x, width - 1);
+				memcpy(block[y * 4 + x].data(), rgba + ((u64)src_y * width + src_x) * 4, 4);
+			}
+		}
+	}
+
+	///
+	/// principal axis of the selected pixels over the first t_Channels channels,
+	/// returns false if there are no selected pixels
+	///
+	template<u32 t_Channels>
+	static bool principalAxis(
+		const Block& block,
+		u32 mask,
+		std::array<float, t_Channels>& mean,
+		std::array<float, t_Channels>& axis
+	)
+	{
+		u32 count = 0;
+		mean.fill(0.0f);
+		for (u32 i = 0; i < 16; i++)
+			if (mask & NA_BIT(i))
+			{
+				for (u32 c = 0; c < t_Channels; c++)
+					mean[c] += block[i][c];
+				count++;
+			}
+
+		if (!count)
+			return false;
+
+		for (u32 c = 0; c < t_Channels; c++)
+			mean[c] /= (float)count;
+
+		std::array<float, t_Channels * t_Channels> covariance{};
+		for (u32 i = 0; i < 16; i++)
+			if (mask & NA_BIT(i))
+				for (u32 a = 0; a < t_Channels; a++)
+					for (u32 b = 0; b < t_Channels; b++)
+						covariance[a * t_Channels + b] += (block[i][a] - mean[a]) * (block[i][b] - mean[b]);
+
+		axis.fill(1.0f);
+		for (u32 iteration = 0; iteration < 8; iteration++)
+		{
+			std::array<float, t_Channels> next{};
+			for (u32 a = 0; a < t_Channels; a++)
+				for (u32 b = 0; b < t_Channels; b++)
+					next[a] += covariance[a * t_Channels + b] * axis[b];
+
+			float length = 0.0f;
+			for (u32 c = 0; c < t_Channels; c++)
+				length = std::max(length, fabsf(next[c]));
+
+			// flat block, any axis will do
+			if (length < 1e-6f)
+				break;
+
+			for (u32 c = 0; c < t_Channels; c++)
+				axis[c] = next[c] / length;
+		}
+
+		return true;
+	}
+
+	///
+	/// projects the selected pixels onto the principal axis and returns the extreme points
+	///
+	template<u32 t_Channels>
+	static void fitEndpoints(
+		const Block& block,
+		u32 mask,
+		std::array<float, t_Channels>& e0,
+		std::array<float, t_Channels>& e1
+	)
+	{
+		std::array<float, t_Channels> mean, axis;
+		if (!principalAxis<t_Channels>(block, mask, mean, axis))
+		{
+			e0.fill(0.0f);
+			e1.fill(0.0f);
+			return;
+		}
+
+		float axis_length_sq = 0.0f;
+		for (u32 c = 0; c < t_Channels; c++)
+			axis_length_sq += axis[c] * axis[c];
+
+		float min_t = 0.0f, max_t = 0.0f;
+		for (u32 i = 0; i < 16; i++)
+			if (mask & NA_BIT(i))
+			{
+				float t = 0.0f;
+				for (u32 c = 0; c < t_Channels; c++)
+					t += (block[i][c] - mean[c]) * axis[c];
+				t /= axis_length_sq;
+
+				min_t = std::min(min_t, t);
+				max_t = std::max(max_t, t);
+			}
+
+		for (u32 c = 0; c < t_Channels; c++)
+		{
+			e0[c] = std::clamp(mean[c] + axis[c] * max_t, 0.0f, 255.0f);
+			e1[c] = std::clamp(mean[c] + axis[c] * min_t, 0.0f, 255.0f);
+		}
+	}
+
+	static u16 packRgb565(const std::array<float, 3>& color)
+	{
+		u32 r = (u32)Round32(color[0] * 31.0f / 255.0f);
+		u32 g = (u32)Round32(color[1] * 63.0f / 255.0f);
+		u32 b = (u32)Round32(color[2] * 31.0f / 255.0f);
+		return (u16)((r << 11) | (g << 5) | b);
+	}
+
+	static std::array<i32, 3> unpackRgb565(u16 color)
+	{
+		i32 r = (color >> 11) & 31;
+		i32 g = (color >> 5) & 63;
+		i32 b = color & 31;
+		return { (r << 3) | (r >> 2), (g << 2) | (g >> 4), (b << 3) | (b >> 2) };
+	}
+
+	static void writeU16(Byte* dst, u16 value) { dst[0] = (Byte)value; dst[1] = (Byte)(value >> 8); }
+	static void writeU32(Byte* dst, u32 value) { writeU16(dst, (u16)value); writeU16(dst + 2, (u16)(value >> 16)); }
+
+	///
+	/// allow_alpha enables the 3 color mode where index 3 is transparent black,
+	/// BC2/BC3 color blocks must not use it
+	///
+	static void encodeBC1(const Block& block, Byte* dst, bool allow_alpha)
+	{
+		u32 opaque_mask = 0;
+		for (u32 i = 0; i < 16; i++)
+			if (!allow_alpha || block[i][3] >= 128)
+				opaque_mask |= NA_BIT(i);
+
+		bool has_transparency = opaque_mask != 0xFFFF;
+
+		std::array<float, 3> e0, e1;
+		fitEndpoints<3>(block, opaque_mask, e0, e1);
+
+		u16 c0 = packRgb565(e0);
+		u16 c1 = packRgb565(e1);
+
+		// 4 color mode needs c0 > c1, 3 color mode needs c0 <= c1
+		if ((!has_transparency && c0 < c1) || (has_transparency && c0 > c1))
+			std::swap(c0, c1);
+
+		std::array<std::array<i32, 3>, 4> palette;
+		palette[0] = unpackRgb565(c0);
+		palette[1] = unpackRgb565(c1);
+
+		u32 palette_size = 4;
+		if (c0 > c1)
+		{
+			for (u32 c = 0; c < 3; c++)
+			{
+				palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+				palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+			}
+		} else
+		{
+			// index 3 is reserved for transparent pixels
+			for (u32 c = 0; c < 3; c++)
+				palette[2][c] = (palette[0][c] + palette[1][c]) / 2;
+			palette_size = 3;
+		}
+
+		u32 indices = 0;
+		for (u32 i = 0; i < 16; i++)
+		{
+			u32 best_index = 3;
+			if (opaque_mask & NA_BIT(i))
+			{
+				i32 best_error = k_I32Max;
+				for (u32 p = 0; p < palette_size; p++)
+				{
+					i32 error = 0;
+					for (u32 c = 0; c < 3; c++)
+					{
+						i32 d = (i32)block[i][c] - palette[p][c];
+						error += d * d;
+					}
+					if (error < best_error)
+					{
+						best_error = error;
+						best_index = p;
+					}
+				}
+			}
+			indices |= best_index << (i * 2);
+		}
+
+		writeU16(dst, c0);
+		writeU16(dst + 2, c1);
+		writeU32(dst + 4, indices);
+	}
+
+	static void encodeBC4(const Block& block, u32 channel, Byte* dst)
+	{
+		u8 a0 = 0, a1 = 255;
+		for (u32 i = 0; i < 16; i++)
+		{
+			a0 = std::max(a0, block[i][channel]);
+			a1 = std::min(a1, block[i][channel]);
+		}
+
+		dst[0] = a0;
+		dst[1] = a1;
+
+		std::array<i32, 8> palette;
+		palette[0] = a0;
+		palette[1] = a1;
+		for (i32 p = 2; p < 8; p++)
+			palette[p] = ((8 - p) * a0 + (p - 1) * a1) / 7;
+
+		u64 indices = 0;
+		if (a0 != a1)
+		{
+			for (u32 i = 0; i < 16; i++)
+			{
+				u64 best_index = 0;
+				i32 best_error = k_I32Max;
+				for (u32 p = 0; p < 8; p++)
+				{
+					i32 error = abs((i32)block[i][channel] - palette[p]);
+					if (error < best_error)
+					{
+						best_error = error;
+						best_index = p;
+					}
+				}
+				indices |= best_index << (i * 3);
+			}
+		}
+
+		for (u32 i = 0; i < 6; i++)
+			dst[2 + i] = (Byte)(indices >> (i * 8));
+	}
+
+	class BitWriter {
+	public:
+		inline BitWriter(Byte* dst) : m_Dst(dst) { memset(dst, 0, 16); }
+
+		inline void write(u32 value, u32 bit_count)
+		{
+			for (u32 i = 0; i < bit_count; i++, m_Position++)
+				if (value & NA_BIT(i))
+					m_Dst[m_Position / 8] |= (Byte)(1u << (m_Position % 8));
+		}
+	private:
+		Byte* m_Dst;
+		u32 m_Position = 0;
+	};
+
+	static const std::array<i32, 16> x_BC7Weights4 = {
+		0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64
+	};
+
+	///
+	/// quantizes an endpoint to 7 bits per channel plus a shared p bit, picking the p bit with the lower error
+	///
+	static void quantizeBC7Endpoint(const std::array<float, 4>& endpoint, std::array<u32, 4>& quantized, u32& p_bit)
+	{
+		float best_error = std::numeric_limits<float>::max();
+		for (u32 p = 0; p < 2; p++)
+		{
+			std::array<u32, 4> candidate;
+			float error = 0.0f;
+			for (u32 c = 0; c < 4; c++)
+			{
+				candidate[c] = (u32)std::clamp(Round32((endpoint[c] - p) / 2.0f), 0, 127);
+				float d = endpoint[c] - (float)((candidate[c] << 1) | p);
+				error += d * d;
+			}
+
+			if (error < best_error)
+			{
+				best_error = error;
+				quantized = candidate;
+				p_bit = p;
+			}
+		}
+	}
+
+	// mode 6 only: a single subset with 7.7.7.7 + p bit endpoints and 4 bit indices
+	static void encodeBC7(const Block& block, Byte* dst)
+	{
+		std::array<float, 4> e0, e1;
+		fitEndpoints<4>(block, 0xFFFF, e0, e1);
+
+		std::array<std::array<u32, 4>, 2> endpoints;
+		std::array<u32, 2> p_bits;
+		quantizeBC7Endpoint(e0, endpoints[0], p_bits[0]);
+		quantizeBC7Endpoint(e1, endpoints[1], p_bits[1]);
+
+		std::array<std::array<i32, 4>, 2> unquantized;
+		for (u32 e = 0; e < 2; e++)
+			for (u32 c = 0; c < 4; c++)
+				unquantized[e][c] = (i32)((endpoints[e][c] << 1) | p_bits[e]);
+
+		std::array<std::array<i32, 4>, 16> palette;
+		for (u32 p = 0; p < 16; p++)
+			for (u32 c = 0; c < 4; c++)
+				palette[p][c] = ((64 - x_BC7Weights4[p]) * unquantized[0][c] + x_BC7Weights4[p] * unquantized[1][c] + 32) >> 6;
+
+		std::array<u32, 16> indices;
+		for (u32 i = 0; i < 16; i++)
+		{
+			i32 best_error = k_I32Max;
+			for (u32 p = 0; p < 16; p++)
+			{
+				i32 error = 0;
+				for (u32 c = 0; c < 4; c++)
+				{
+					i32 d = (i32)block[i][c] - palette[p][c];
+					error += d * d;
+				}
+				if (error < best_error)
+				{
+					best_error = error;
+					indices[i] = p;
+				}
+			}
+		}
+
+		// the anchor index is stored without its top bit
+		if (indices[0] & 8)
+		{
+			std::swap(endpoints[0], endpoints[1]);
+			std::swap(p_bits[0], p_bits[1]);
+			for (u32& index : indices)
+				index = 15 - index;
+		}
+
+		BitWriter writer(dst);
+		writer.write(1u << 6, 7); // mode 6
+
+		for (u32 c = 0; c < 4; c++)
+		{
+			writer.write(endpoints[0][c], 7);
+			writer.write(endpoints[1][c], 7);
+		}
+
+		writer.write(p_bits[0], 1);
+		writer.write(p_bits[1], 1);
+
+		writer.write(indices[0], 3);
+		for (u32 i = 1; i < 16; i++)
+			writer.write(indices[i], 4);
+	}
+
+	void CompressBlocks(
+		const Byte* rgba,
+		u32 width,
+		u32 height,
+		BlockFormat format,
+		Byte* dst,
+		u32 thread_count
+	)
+	{
+		NA_ASSERT(rgba && dst, "Failed to compress image: Invalid buffer!");
+		NA_ASSERT(format != BlockFormat::None, "Failed to compress image: Invalid block format!");
+
+		u32 blocks_x = (width + 3) / 4;
+		u32 blocks_y = (height + 3) / 4;
+		u32 block_size = BlockSize(format);
+
+		ParallelFor(blocks_y, [&](u64 block_y)
+		{
+			Block block;
+			Byte* row = dst + block_y * blocks_x * block_size;
+
+			for (u32 block_x = 0; block_x < blocks_x; block_x++)
+			{
+				fetchBlock(rgba, width, height, block_x, (u32)block_y, block);
+				Byte* out = row + block_x * block_size;
+
+				switch (format)
+				{
+				case BlockFormat::BC1:
+					encodeBC1(block, out, true);
+					break;
+				case BlockFormat::BC3:
+					encodeBC4(block, 3, out);
+					encodeBC1(block, out + 8, false);
+					break;
+				case BlockFormat::BC5:
+					encodeBC4(block, 0, out);
+					encodeBC4(block, 1, out + 8);
+					break;
+				case BlockFormat::BC7:
+					encodeBC7(block, out);
+					break;
+				}
+			}
+		}, thread_count);
+	}
+} // namespace Na
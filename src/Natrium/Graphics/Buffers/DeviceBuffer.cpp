@@ -2,6 +2,7 @@
 #include "Natrium/Graphics/Buffers/DeviceBuffer.hpp"
 
 #include "Natrium/Graphics/VkContext.hpp"
+#include "Natrium/Graphics/StagingRing.hpp"
 
 namespace Na {
 	u32 FindMemoryType(u32 typeFilter, vk::MemoryPropertyFlags properties)
@@ -30,24 +31,33 @@ namespace Na {
 		buffer_info.usage = usage;
 		buffer_info.sharingMode = sharing_mode;
 
+		// concurrent buffers are shared between the graphics and transfer families
+		QueueFamilyIndices indices = VkContext::GetQueueFamilyIndices();
+		u32 queue_families[] = { indices.graphics, indices.transfer };
+		if (sharing_mode == vk::SharingMode::eConcurrent)
+		{
+			buffer_info.queueFamilyIndexCount = 2;
+			buffer_info.pQueueFamilyIndices = queue_families;
+		}
+
 		this->buffer = logical_device.createBuffer(buffer_info);
 
 		vk::MemoryRequirements memory_requirements = logical_device.getBufferMemoryRequirements(this->buffer);
 
-		vk::MemoryAllocateInfo alloc_info;
-		alloc_info.allocationSize = memory_requirements.size;
-		alloc_info.memoryTypeIndex = FindMemoryType(memory_requirements.memoryTypeBits, properties);
-
-		this->memory = logical_device.allocateMemory(alloc_info);
-		logical_device.bindBufferMemory(this->buffer, this->memory, 0);
+		this->memory = VkContext::GetAllocator().allocate(memory_requirements, properties, DeviceAllocationKind::Buffer);
+		logical_device.bindBufferMemory(this->buffer, this->memory.memory, this->memory.offset);
 	}
 
 	void DeviceBuffer::destroy(void)
 	{
-		vk::Device logical_device = VkContext::GetLogicalDevice();
-
-		logical_device.destroyBuffer(this->buffer);
-		logical_device.freeMemory(this->memory);
+		if (this->buffer || this->memory)
+		{
+			VkContext::DeferDestruction([buffer = this->buffer, memory = this->memory](void) mutable
+			{
+				VkContext::GetLogicalDevice().destroyBuffer(buffer);
+				VkContext::GetAllocator().free(memory);
+			});
+		}
 
 		memset(this, 0, sizeof(DeviceBuffer));
 	}
@@ -66,10 +76,47 @@ namespace Na {
 		VkContext::EndSingleTimeCommands(cmd_buffer);
 	}
 
+	void DeviceBuffer::upload(const void* data, vk::DeviceSize data_size, vk::DeviceSize offset)
+	{
+		NA_ASSERT(offset + data_size <= this->size, "Failed to upload to DeviceBuffer: Data doesn't fit!");
+
+		StagingRegion region = VkContext::GetStagingRing().allocate(data_size);
+		memcpy(region.data, data, data_size);
+
+		vk::CommandBuffer cmd_buffer = VkContext::BeginSingleTimeCommands();
+
+		vk::BufferCopy copy_region(region.offset, offset, data_size);
+		cmd_buffer.copyBuffer(region.buffer, this->buffer, 1, &copy_region);
+
+		VkContext::EndSingleTimeCommands(cmd_buffer);
+	}
+
+	SubmissionToken DeviceBuffer::upload_async(const void* data, vk::DeviceSize data_size, vk::DeviceSize offset)
+	{
+		NA_ASSERT(offset + data_size <= this->size, "Failed to upload to DeviceBuffer: Data doesn't fit!");
+
+		StagingRegion region = VkContext::GetStagingRing().allocate(data_size);
+		memcpy(region.data, data, data_size);
+
+		vk::CommandBuffer cmd_buffer = VkContext::BeginTransferCommands();
+
+		vk::BufferCopy copy_region(region.offset, offset, data_size);
+		cmd_buffer.copyBuffer(region.buffer, this->buffer, 1, &copy_region);
+
+		vk::BufferMemoryBarrier barrier;
+		barrier.srcAccessMask = vk::AccessFlagBits::eTransferWrite;
+		barrier.dstAccessMask = vk::AccessFlagBits::eMemoryRead;
+		barrier.buffer = this->buffer;
+		barrier.offset = offset;
+		barrier.size = data_size;
+
+		return VkContext::EndTransferCommands(cmd_buffer, &barrier, 1, nullptr, 0);
+	}
+
 	DeviceBuffer::DeviceBuffer(DeviceBuffer&& other)
 	: buffer(std::exchange(other.buffer, nullptr)),
 	size(std::exchange(other.size, 0)),
-	memory(std::exchange(other.memory, nullptr))
+	memory(std::exchange(other.memory, {}))
 	{}
 
 	DeviceBuffer& DeviceBuffer::operator=(DeviceBuffer&& other)
@@ -77,7 +124,7 @@ namespace Na {
 		this->destroy();
 		this->buffer = std::exchange(other.buffer, nullptr);
 		this->size = std::exchange(other.size, 0);
-		this->memory = std::exchange(other.memory, nullptr);
+		this->memory = std::exchange(other.memory, {});
 		return *this;
 	}
 
@@ -0,0 +1,158 @@
+#include "Pch.hpp"
+#include "Natrium/Graphics/Buffers/GeometryArena.hpp"
+
+#include "Natrium/Graphics/VkContext.hpp"
+
+namespace Na {
+	struct ArenaRange {
+		u32 offset;
+		u32 count;
+	};
+
+	struct GeometryArenaState {
+		// sorted by offset, neighbours are merged when a range is returned
+		std::vector<ArenaRange> free_vertices;
+		std::vector<ArenaRange> free_indices;
+
+		u32 used_vertices = 0;
+		u32 used_indices = 0;
+	};
+
+	// first fit, UINT32_MAX if no free range is big enough
+	static u32 takeRange(std::vector<ArenaRange>& free_ranges, u32 count)
+	{
+		for (auto it = free_ranges.begin(); it != free_ranges.end(); it++)
+		{
+			if (it->count < count)
+				continue;
+
+			u32 offset = it->offset;
+			it->offset += count;
+			it->count -= count;
+			if (!it->count)
+				free_ranges.erase(it);
+			return offset;
+		}
+		return UINT32_MAX;
+	}
+
+	static void returnRange(std::vector<ArenaRange>& free_ranges, u32 offset, u32 count)
+	{
+		auto next = std::lower_bound(free_ranges.begin(), free_ranges.end(), offset,
+			[](const ArenaRange& range, u32 offset) { return range.offset < offset; });
+
+		bool merges_prev = next != free_ranges.begin() && std::prev(next)->offset + std::prev(next)->count == offset;
+		bool merges_next = next != free_ranges.end() && offset + count == next->offset;
+
+		if (merges_prev && merges_next)
+		{
+			std::prev(next)->count += count + next->count;
+			free_ranges.erase(next);
+		} else if (merges_prev)
+		{
+			std::prev(next)->count += count;
+		} else if (merges_next)
+		{
+			next->offset = offset;
+			next->count += count;
+		} else
+		{
+			free_ranges.insert(next, ArenaRange{ offset, count });
+		}
+	}
+
+	GeometryArena::GeometryArena(u32 vertex_stride, u32 vertex_capacity, u32 index_capacity)
+	: m_VertexBuffer(
+		(vk::DeviceSize)vertex_stride * vertex_capacity,
+		vk::BufferUsageFlagBits::eTransferDst | vk::BufferUsageFlagBits::eVertexBuffer,
+		vk::MemoryPropertyFlagBits::eDeviceLocal
+	),
+	m_IndexBuffer(
+		(vk::DeviceSize)sizeof(u32) * index_capacity,
+		vk::BufferUsageFlagBits::eTransferDst | vk::BufferUsageFlagBits::eIndexBuffer,
+		vk::MemoryPropertyFlagBits::eDeviceLocal
+	),
+	m_VertexStride(vertex_stride),
+	m_State(std::make_shared<GeometryArenaState>())
+	{
+		NA_ASSERT(vertex_stride && vertex_capacity && index_capacity, "Failed to create GeometryArena: Stride and capacities can't be 0!");
+
+		m_State->free_vertices.emplace_back(ArenaRange{ 0, vertex_capacity });
+		m_State->free_indices.emplace_back(ArenaRange{ 0, index_capacity });
+	}
+
+	void GeometryArena::destroy(void)
+	{
+		m_VertexBuffer.destroy();
+		m_IndexBuffer.destroy();
+		m_VertexStride = 0;
+		m_State.reset();
+	}
+
+	GeometryRange GeometryArena::allocate(const void* vertices, u32 vertex_count, const u32* indices, u32 index_count)
+	{
+		NA_ASSERT(m_State, "Failed to allocate from GeometryArena: Arena wasn't created!");
+		NA_ASSERT(vertex_count && index_count, "Failed to allocate from GeometryArena: Meshes need vertices and indices!");
+
+		u32 vertex_offset = takeRange(m_State->free_vertices, vertex_count);
+		NA_VERIFY(vertex_offset != UINT32_MAX, "Failed to allocate from GeometryArena: No room for {} vertices ({} of {} used)!", vertex_count, m_State->used_vertices, this->vertex_capacity());
+
+		u32 first_index = takeRange(m_State->free_indices, index_count);
+		if (first_index == UINT32_MAX)
+		{
+			returnRange(m_State->free_vertices, vertex_offset, vertex_count);
+			throw std::runtime_error(NA_FORMAT("Failed to allocate from GeometryArena: No room for {} indices ({} of {} used)!", index_count, m_State->used_indices, this->index_capacity()));
+		}
+
+		m_State->used_vertices += vertex_count;
+		m_State->used_indices += index_count;
+
+		m_VertexBuffer.upload(vertices, (vk::DeviceSize)m_VertexStride * vertex_count, (vk::DeviceSize)m_VertexStride * vertex_offset);
+		m_IndexBuffer.upload(indices, (vk::DeviceSize)sizeof(u32) * index_count, (vk::DeviceSize)sizeof(u32) * first_index);
+
+		return GeometryRange{ (i32)vertex_offset, vertex_count, first_index, index_count };
+	}
+
+	void GeometryArena::free(const GeometryRange& range)
+	{
+		if (!range || !m_State)
+			return;
+
+		VkContext::DeferDestruction([state = m_State, range](void)
+		{
+			returnRange(state->free_vertices, (u32)range.vertex_offset, range.vertex_count);
+			returnRange(state->free_indices, range.first_index, range.index_count);
+			state->used_vertices -= range.vertex_count;
+			state->used_indices -= range.index_count;
+		});
+	}
+
+	u32 GeometryArena::used_vertices(void) const
+	{
+		return m_State ? m_State->used_vertices : 0;
+	}
+
+	u32 GeometryArena::used_indices(void) const
+	{
+		return m_State ? m_State->used_indices : 0;
+	}
+
+	GeometryArena::GeometryArena(GeometryArena&& other)
+	: m_VertexBuffer(std::move(other.m_VertexBuffer)),
+	m_IndexBuffer(std::move(other.m_IndexBuffer)),
+	m_VertexStride(std::exchange(other.m_VertexStride, 0)),
+	m_State(std::move(other.m_State))
+	{}
+
+	GeometryArena& GeometryArena::operator=(GeometryArena&& other)
+	{
+		this->destroy();
+
+		m_VertexBuffer = std::move(other.m_VertexBuffer);
+		m_IndexBuffer = std::move(other.m_IndexBuffer);
+		m_VertexStride = std::exchange(other.m_VertexStride, 0);
+		m_State = std::move(other.m_State);
+
+		return *this;
+	}
+} // namespace Na
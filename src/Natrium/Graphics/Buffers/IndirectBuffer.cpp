@@ -0,0 +1,101 @@
+#include "Pch.hpp"
+#include "Natrium/Graphics/Buffers/IndirectBuffer.hpp"
+
+#include "Natrium/Graphics/VkContext.hpp"
+#include "Natrium/Graphics/Renderer/Renderer.hpp"
+
+namespace Na {
+	IndirectBuffer::IndirectBuffer(u32 max_draws, const RendererSettings& renderer_settings, IndirectBufferMode mode)
+	: m_MaxDraws(max_draws),
+	m_Mode(mode)
+	{
+		NA_ASSERT(max_draws, "Failed to create IndirectBuffer: Max draws can't be 0!");
+
+		// frames are bound as storage buffers by shaders that write the commands
+		vk::DeviceSize alignment = VkContext::GetPhysicalDevice().getProperties().limits.minStorageBufferOffsetAlignment;
+		m_FrameStride = (this->frame_size() + alignment - 1) & ~(alignment - 1);
+
+		m_Buffer = DeviceBuffer(
+			m_FrameStride * renderer_settings.max_frames_in_flight,
+			vk::BufferUsageFlagBits::eIndirectBuffer | vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eTransferDst,
+			mode == IndirectBufferMode::Host
+				? vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent
+				: vk::MemoryPropertyFlags(vk::MemoryPropertyFlagBits::eDeviceLocal)
+		);
+	}
+
+	void IndirectBuffer::destroy(void)
+	{
+		m_Buffer.destroy();
+		m_Count = 0;
+	}
+
+	u32 IndirectBuffer::push(const Renderer& renderer, const vk::DrawIndexedIndirectCommand& command)
+	{
+		NA_ASSERT(m_Mode == IndirectBufferMode::Host, "Failed to push indirect draw: The buffer is written by shaders!");
+
+		if (renderer.frame_number() != m_FrameNumber)
+		{
+			m_FrameNumber = renderer.frame_number();
+			m_FrameIndex = renderer.current_frame_index();
+			m_Count = 0;
+		}
+
+		NA_ASSERT(m_Count < m_MaxDraws, "Failed to push indirect draw: All {} commands of the frame are used!", m_MaxDraws);
+		NA_VERIFY(
+			!command.firstInstance || VkContext::IsDrawIndirectFirstInstanceSupported(),
+			"Failed to push indirect draw: The device doesn't support a first instance of {} in indirect commands!",
+				command.firstInstance
+		);
+
+		Byte* region = m_Buffer.mapped() + this->frame_offset(m_FrameIndex);
+		memcpy(region + k_CommandsOffset + k_CommandStride * m_Count, &command, sizeof(command));
+
+		m_Count++;
+		memcpy(region, &m_Count, sizeof(m_Count));
+
+		return m_Count - 1;
+	}
+
+	void IndirectBuffer::clear(Renderer& renderer)
+	{
+		m_FrameNumber = renderer.frame_number();
+		m_FrameIndex = renderer.current_frame_index();
+		m_Count = 0;
+
+		if (m_Mode == IndirectBufferMode::Host)
+			memcpy(m_Buffer.mapped() + this->frame_offset(m_FrameIndex), &m_Count, sizeof(m_Count));
+		else
+			renderer.fill_buffer(m_Buffer, this->frame_offset(m_FrameIndex), sizeof(m_Count), 0, ComputeOutputUse::Compute);
+	}
+
+	u32 IndirectBuffer::draw_count(const Renderer& renderer) const
+	{
+		return renderer.frame_number() == m_FrameNumber ? m_Count : 0;
+	}
+
+	IndirectBuffer::IndirectBuffer(IndirectBuffer&& other)
+	: m_Buffer(std::move(other.m_Buffer)),
+	m_FrameStride(other.m_FrameStride),
+	m_MaxDraws(other.m_MaxDraws),
+	m_Mode(other.m_Mode),
+	m_Count(std::exchange(other.m_Count, 0)),
+	m_FrameNumber(other.m_FrameNumber),
+	m_FrameIndex(other.m_FrameIndex)
+	{}
+
+	IndirectBuffer& IndirectBuffer::operator=(IndirectBuffer&& other)
+	{
+		this->destroy();
+
+		m_Buffer = std::move(other.m_Buffer);
+		m_FrameStride = other.m_FrameStride;
+		m_MaxDraws = other.m_MaxDraws;
+		m_Mode = other.m_Mode;
+		m_Count = std::exchange(other.m_Count, 0);
+		m_FrameNumber = other.m_FrameNumber;
+		m_FrameIndex = other.m_FrameIndex;
+
+		return *this;
+	}
+} // namespace Na
@@ -19,7 +19,7 @@ namespace Na {
 			vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent
 		);
 
-		m_Mapped = VkContext::GetLogicalDevice().mapMemory(m_Buffer.memory, 0, size);
+		m_Mapped = m_Buffer.mapped();
 	}
 
 	void StorageBuffer::destroy(void)
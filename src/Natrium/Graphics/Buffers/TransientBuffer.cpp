@@ -0,0 +1,88 @@
+#include "Pch.hpp"
+#include "Natrium/Graphics/Buffers/TransientBuffer.hpp"
+
+#include "Natrium/Graphics/VkContext.hpp"
+#include "Natrium/Graphics/Renderer/Renderer.hpp"
+
+namespace Na {
+	TransientBuffer::TransientBuffer(
+		u64 per_frame_capacity,
+		u64 range,
+		const RendererSettings& renderer_settings,
+		ShaderUniformType type
+	)
+	: m_Type(type), m_Range(range)
+	{
+		NA_ASSERT(
+			type == ShaderUniformType::UniformBuffer || type == ShaderUniformType::StorageBuffer,
+			"Failed to create TransientBuffer: Type has to be UniformBuffer or StorageBuffer!"
+		);
+		NA_ASSERT(range && range <= per_frame_capacity, "Failed to create TransientBuffer: Range has to fit in a frame!");
+
+		vk::PhysicalDeviceLimits limits = VkContext::GetPhysicalDevice().getProperties().limits;
+		bool uniform = type == ShaderUniformType::UniformBuffer;
+
+		m_Alignment = uniform ? limits.minUniformBufferOffsetAlignment : limits.minStorageBufferOffsetAlignment;
+		m_FrameStride = (per_frame_capacity + m_Alignment - 1) & ~(m_Alignment - 1);
+
+		// the descriptor range has to stay inside the buffer from the last frame's final offset as well
+		vk::DeviceSize size = m_FrameStride * renderer_settings.max_frames_in_flight + range;
+		NA_ASSERT(size <= UINT32_MAX, "Failed to create TransientBuffer: Dynamic offsets are 32 bit!");
+
+		m_Buffer = DeviceBuffer(
+			size,
+			uniform ? vk::BufferUsageFlagBits::eUniformBuffer : vk::BufferUsageFlagBits::eStorageBuffer,
+			vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent
+		);
+	}
+
+	void TransientBuffer::destroy(void)
+	{
+		m_Buffer.destroy();
+		m_Head = 0;
+	}
+
+	TransientAllocation TransientBuffer::allocate(const Renderer& renderer, u64 size)
+	{
+		NA_ASSERT(size <= m_Range, "Failed to allocate from TransientBuffer: {} bytes exceed the range of {}!", size, m_Range);
+
+		if (renderer.frame_number() != m_FrameNumber)
+		{
+			m_FrameNumber = renderer.frame_number();
+			m_FrameIndex = renderer.current_frame_index();
+			m_Head = 0;
+		}
+
+		u64 offset = (m_Head + m_Alignment - 1) & ~(m_Alignment - 1);
+		NA_VERIFY(offset + size <= m_FrameStride, "Failed to allocate from TransientBuffer: Frame region is full!");
+		m_Head = offset + size;
+
+		u64 position = m_FrameStride * m_FrameIndex + offset;
+		return TransientAllocation{ (u32)position, m_Buffer.mapped() + position };
+	}
+
+	TransientBuffer::TransientBuffer(TransientBuffer&& other)
+	: m_Buffer(std::move(other.m_Buffer)),
+	m_Type(other.m_Type),
+	m_FrameStride(other.m_FrameStride),
+	m_Range(other.m_Range),
+	m_Alignment(other.m_Alignment),
+	m_Head(std::exchange(other.m_Head, 0)),
+	m_FrameNumber(other.m_FrameNumber),
+	m_FrameIndex(other.m_FrameIndex)
+	{}
+
+	TransientBuffer& TransientBuffer::operator=(TransientBuffer&& other)
+	{
+		m_Buffer = std::move(other.m_Buffer);
+		m_Type = other.m_Type;
+		m_FrameStride = other.m_FrameStride;
+		m_Range = other.m_Range;
+		m_Alignment = other.m_Alignment;
+		m_Head = std::exchange(other.m_Head, 0);
+		m_FrameNumber = other.m_FrameNumber;
+		m_FrameIndex = other.m_FrameIndex;
+
+		return *this;
+	}
+} // namespace Na
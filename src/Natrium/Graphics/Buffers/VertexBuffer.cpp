@@ -23,21 +23,7 @@ namespace Na {
 
 	void VertexBuffer::set_data(const void* data)
 	{
-		vk::Device logical_device = VkContext::GetLogicalDevice();
-
-		DeviceBuffer stage_buffer(
-			m_Buffer.size,
-			vk::BufferUsageFlagBits::eTransferSrc,
-			vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent
-		);
-
-		void* memory = logical_device.mapMemory(stage_buffer.memory, 0, m_Buffer.size);
-		memcpy(memory, data, m_Buffer.size);
-		logical_device.unmapMemory(stage_buffer.memory);
-
-		m_Buffer.copy(stage_buffer);
-
-		stage_buffer.destroy();
+		m_Buffer.upload(data, m_Buffer.size);
 	}
 
 	VertexBuffer::VertexBuffer(VertexBuffer&& other)
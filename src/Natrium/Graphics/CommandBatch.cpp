@@ -0,0 +1,52 @@
+#include "Pch.hpp"
+#include "Natrium/Graphics/CommandBatch.hpp"
+
+#include "Natrium/Graphics/VkContext.hpp"
+
+#include "Internal.hpp"
+
+namespace Na {
+	static CommandBatch* s_OpenBatch = nullptr;
+
+	CommandBatch::CommandBatch(void)
+	{
+		NA_ASSERT(!s_OpenBatch, "Failed to open CommandBatch: Another batch is already open!");
+
+		m_CmdBuffer = VkContext::BeginSingleTimeCommands();
+		s_OpenBatch = this;
+	}
+
+	SubmissionToken CommandBatch::submit(void)
+	{
+		if (!m_CmdBuffer)
+			return {};
+
+		s_OpenBatch = nullptr;
+		return VkContext::SubmitSingleTimeCommands(std::exchange(m_CmdBuffer, nullptr));
+	}
+
+	SubmissionToken CommandBatch::flush(void)
+	{
+		NA_ASSERT(m_CmdBuffer, "Failed to flush CommandBatch: Batch was already submitted!");
+
+		SubmissionToken token = VkContext::SubmitSingleTimeCommands(m_CmdBuffer);
+		s_OpenBatch = nullptr;
+		m_CmdBuffer = VkContext::BeginSingleTimeCommands();
+		s_OpenBatch = this;
+		return token;
+	}
+
+	vk::CommandBuffer Internal::OpenBatchCmdBuffer(void)
+	{
+		return s_OpenBatch ? s_OpenBatch->cmd_buffer() : nullptr;
+	}
+
+	bool Internal::FlushOpenBatch(void)
+	{
+		if (!s_OpenBatch)
+			return false;
+
+		(void)s_OpenBatch->flush();
+		return true;
+	}
+} // namespace Na
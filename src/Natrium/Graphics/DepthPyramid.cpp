@@ -0,0 +1,249 @@
+#include "Pch.hpp"
+#include "Natrium/Graphics/DepthPyramid.hpp"
+
+#include "Natrium/Graphics/VkContext.hpp"
+#include "Natrium/Graphics/ShaderModule.hpp"
+#include "Natrium/Graphics/MipChain.hpp"
+#include "Natrium/Graphics/Renderer/Renderer.hpp"
+
+#include "Internal.hpp"
+
+#include <bit>
+
+namespace Na {
+	// every source texel a destination texel overlaps, 2x2 between levels and up to 3x3 from the depth buffer,
+	// whose size usually isn't a power of two
+	static constexpr std::string_view k_ReduceSource = R"(
+		#version 450
+
+		layout(local_size_x = 8, local_size_y = 8) in;
+
+		#if defined(NA_MULTISAMPLED)
+		layout(binding = 0) uniform sampler2DMS u_Source;
+		#else
+		layout(binding = 0) uniform sampler2D u_Source;
+		#endif
+
+		layout(binding = 1, r32f) uniform writeonly image2D u_Destination;
+
+		layout(push_constant) uniform Reduction {
+			ivec2 source_size;
+			ivec2 destination_size;
+			int source_level;
+		} u_Reduction;
+
+		void main()
+		{
+			ivec2 texel = ivec2(gl_GlobalInvocationID.xy);
+			if (any(greaterThanEqual(texel, u_Reduction.destination_size)))
+				return;
+
+			ivec2 begin = texel * u_Reduction.source_size / u_Reduction.destination_size;
+			ivec2 end = min(
+				((texel + 1) * u_Reduction.source_size + u_Reduction.destination_size - 1) / u_Reduction.destination_size,
+				u_Reduction.source_size
+			);
+
+			float depth = 0.0;
+			for (int y = begin.y; y < end.y; y++)
+				for (int x = begin.x; x < end.x; x++)
+				{
+		#if defined(NA_MULTISAMPLED)
+					for (int s = 0; s < textureSamples(u_Source); s++)
+						depth = max(depth, texelFetch(u_Source, ivec2(x, y), s).r);
+		#else
+					depth = max(depth, texelFetch(u_Source, ivec2(x, y), u_Reduction.source_level).r);
+		#endif
+				}
+
+			imageStore(u_Destination, texel, vec4(depth));
+		}
+	)";
+
+	struct ReduceConstants {
+		glm::ivec2 source_size;
+		glm::ivec2 destination_size;
+		i32 source_level;
+	};
+
+	static constexpr PushConstant k_ReducePushConstant = { ShaderStageBits::Compute, sizeof(ReduceConstants) };
+
+	static ComputePipeline createReducePipeline(const RendererSettings& renderer_settings, bool multisampled)
+	{
+		ShaderString source(k_ReduceSource, multisampled ? "DepthPyramid (multisampled)" : "DepthPyramid");
+		if (multisampled)
+			source.define("NA_MULTISAMPLED");
+
+		ShaderModule module(ShaderBinary(source.compile("main", ShaderStageBits::Compute)), ShaderStageBits::Compute);
+		return ComputePipeline(renderer_settings, module);
+	}
+
+	DepthPyramid::DepthPyramid(const RendererSettings& renderer_settings)
+	: m_Reduce(createReducePipeline(renderer_settings, false))
+	{
+		NA_VERIFY(renderer_settings.keep_depth_for_culling, "Failed to create DepthPyramid: RendererSettings::keep_depth_for_culling is off!");
+
+		if (renderer_settings.msaa_enabled && VkContext::GetMSAASamples(true) != vk::SampleCountFlagBits::e1)
+			m_ReduceMultisampled = createReducePipeline(renderer_settings, true);
+
+		// only read with texelFetch, so filtering and addressing never matter
+		m_Sampler = Internal::CreateSampler(vk::Filter::eNearest, vk::Filter::eNearest, false, 1.0f);
+	}
+
+	void DepthPyramid::destroy(void)
+	{
+		if (!m_Reduce)
+			return;
+
+		this->_destroy_image();
+
+		VkContext::DeferDestruction([sampler = m_Sampler](void)
+		{
+			VkContext::GetLogicalDevice().destroySampler(sampler);
+		});
+		m_Sampler = nullptr;
+
+		m_Reduce.destroy();
+		m_ReduceMultisampled.destroy();
+	}
+
+	void DepthPyramid::_create_image(const RendererCore& renderer_core)
+	{
+		u32 width = std::bit_floor(std::max(renderer_core.width(), 1u));
+		u32 height = std::bit_floor(std::max(renderer_core.height(), 1u));
+		u32 mip_levels = MipLevelCount(width, height);
+
+		m_Image = DeviceImage(
+			{ width, height, 1 },
+			1, // layer count
+			vk::ImageAspectFlagBits::eColor,
+			vk::Format::eR32Sfloat,
+			vk::ImageTiling::eOptimal,
+			vk::ImageUsageFlagBits::eSampled | vk::ImageUsageFlagBits::eStorage,
+			vk::SharingMode::eExclusive,
+			vk::SampleCountFlagBits::e1,
+			vk::MemoryPropertyFlagBits::eDeviceLocal,
+			mip_levels
+		);
+		m_View = CreateImageView(m_Image.img, vk::ImageAspectFlagBits::eColor, m_Image.format, 1, mip_levels);
+
+		// storage images are written one level at a time
+		vk::ImageViewCreateInfo create_info;
+		create_info.image = m_Image.img;
+		create_info.viewType = vk::ImageViewType::e2D;
+		create_info.format = m_Image.format;
+		create_info.subresourceRange = vk::ImageSubresourceRange(vk::ImageAspectFlagBits::eColor, 0, 1, 0, 1);
+
+		m_LevelViews.resize(mip_levels);
+		for (u32 i = 0; i < mip_levels; i++)
+		{
+			create_info.subresourceRange.baseMipLevel = i;
+			m_LevelViews[i] = VkContext::GetLogicalDevice().createImageView(create_info);
+		}
+
+		m_DepthGeneration = renderer_core.depth_generation();
+		m_Built = false;
+	}
+
+	void DepthPyramid::_destroy_image(void)
+	{
+		if (!m_Image)
+			return;
+
+		VkContext::DeferDestruction([view = m_View, level_views = std::move(m_LevelViews)](void)
+		{
+			vk::Device logical_device = VkContext::GetLogicalDevice();
+			logical_device.destroyImageView(view);
+			for (vk::ImageView level_view : level_views)
+				logical_device.destroyImageView(level_view);
+		});
+		m_View = nullptr;
+
+		m_Image.destroy();
+	}
+
+	bool DepthPyramid::build(Renderer& renderer)
+	{
+		if (renderer.frame_number() == m_BuiltFrame)
+			return m_Built;
+
+		const RendererCore& core = renderer.core();
+		if (!m_Image || m_DepthGeneration != core.depth_generation())
+		{
+			this->_destroy_image();
+			this->_create_image(core);
+		}
+
+		m_BuiltFrame = renderer.frame_number();
+
+		// every level is rewritten, the barrier only has to wait for the previous frame's readers
+		renderer.compute_barrier(m_Image, vk::ImageLayout::eUndefined, vk::ImageLayout::eGeneral, ComputeOutputUse::Compute);
+
+		m_Built = renderer.acquire_previous_depth();
+		if (!m_Built)
+			return false;
+
+		ImageUniform source = { ShaderUniformType::Texture, core.depth_image_view(), m_Sampler, vk::ImageLayout::eShaderReadOnlyOptimal };
+		glm::ivec2 source_size = glm::ivec2(core.width(), core.height());
+
+		ComputePipeline* bound = nullptr;
+		for (u32 i = 0; i < m_LevelViews.size(); i++)
+		{
+			ComputePipeline& pipeline = (i == 0 && m_ReduceMultisampled) ? m_ReduceMultisampled : m_Reduce;
+
+			ImageUniform destination = { ShaderUniformType::StorageImage, m_LevelViews[i], nullptr, vk::ImageLayout::eGeneral };
+			glm::ivec2 destination_size = glm::ivec2(MipExtent(m_Image.width, i), MipExtent(m_Image.height, i));
+
+			// written before binding the pipeline, the sets are only valid for this frame anyway
+			vk::DescriptorSet set = renderer.allocate_frame_descriptor_set(pipeline);
+			pipeline.bind_uniforms(set, source, destination);
+
+			if (bound != &pipeline)
+			{
+				renderer.bind_pipeline(pipeline);
+				bound = &pipeline;
+			}
+			renderer.bind_descriptor_set(set);
+
+			ReduceConstants constants = { source_size, destination_size, i ? (i32)i - 1 : 0 };
+			renderer.set_push_constant(k_ReducePushConstant, &constants, pipeline);
+
+			renderer.dispatch((destination_size.x + 7) / 8, (destination_size.y + 7) / 8);
+			renderer.compute_barrier(m_Image, vk::ImageLayout::eGeneral, vk::ImageLayout::eGeneral, ComputeOutputUse::Compute);
+
+			source = this->uniform();
+			source_size = destination_size;
+		}
+
+		return true;
+	}
+
+	DepthPyramid::DepthPyramid(DepthPyramid&& other)
+	: m_Reduce(std::move(other.m_Reduce)),
+	m_ReduceMultisampled(std::move(other.m_ReduceMultisampled)),
+	m_Image(std::move(other.m_Image)),
+	m_View(std::exchange(other.m_View, nullptr)),
+	m_LevelViews(std::move(other.m_LevelViews)),
+	m_Sampler(std::exchange(other.m_Sampler, nullptr)),
+	m_DepthGeneration(other.m_DepthGeneration),
+	m_BuiltFrame(other.m_BuiltFrame),
+	m_Built(other.m_Built)
+	{}
+
+	DepthPyramid& DepthPyramid::operator=(DepthPyramid&& other)
+	{
+		this->destroy();
+
+		m_Reduce = std::move(other.m_Reduce);
+		m_ReduceMultisampled = std::move(other.m_ReduceMultisampled);
+		m_Image = std::move(other.m_Image);
+		m_View = std::exchange(other.m_View, nullptr);
+		m_LevelViews = std::move(other.m_LevelViews);
+		m_Sampler = std::exchange(other.m_Sampler, nullptr);
+		m_DepthGeneration = other.m_DepthGeneration;
+		m_BuiltFrame = other.m_BuiltFrame;
+		m_Built = other.m_Built;
+
+		return *this;
+	}
+} // namespace Na
@@ -0,0 +1,124 @@
+#include "Pch.hpp"
+#include "Natrium/Graphics/DescriptorAllocator.hpp"
+
+#include "Natrium/Graphics/VkContext.hpp"
+#include "Natrium/Graphics/Pipeline.hpp"
+
+namespace Na {
+	static constexpr u32 k_MaxSetsPerPool = 4096;
+
+	DescriptorAllocator::DescriptorAllocator(const ShaderUniform* uniforms, u32 uniform_count, u32 initial_set_count)
+	: m_NextSetCount(std::clamp(initial_set_count, 1u, k_MaxSetsPerPool))
+	{
+		NA_ASSERT(uniform_count, "Failed to create DescriptorAllocator: No uniforms!");
+
+		// one pool size per descriptor type
+		for (u32 i = 0; i < uniform_count; i++)
+		{
+			vk::DescriptorType type = (vk::DescriptorType)uniforms[i].type;
+
+			auto it = std::find_if(m_SizesPerSet.begin(), m_SizesPerSet.end(),
+				[type](const vk::DescriptorPoolSize& size) { return size.type == type; });
+
+			if (it != m_SizesPerSet.end())
+				it->descriptorCount++;
+			else
+				m_SizesPerSet.emplace(type, 1);
+		}
+	}
+
+	DescriptorAllocator::DescriptorAllocator(const vk::DescriptorPoolSize* sizes_per_set, u32 size_count, u32 initial_set_count)
+	: m_NextSetCount(std::clamp(initial_set_count, 1u, k_MaxSetsPerPool))
+	{
+		for (u32 i = 0; i < size_count; i++)
+			if (sizes_per_set[i].descriptorCount)
+				m_SizesPerSet.emplace(sizes_per_set[i]);
+
+		NA_ASSERT(m_SizesPerSet.size(), "Failed to create DescriptorAllocator: No descriptors!");
+	}
+
+	void DescriptorAllocator::destroy(void)
+	{
+		// sets from these pools may still be in use by frames in flight
+		for (vk::DescriptorPool pool : m_Pools)
+			VkContext::DeferDestruction([pool](void) { VkContext::GetLogicalDevice().destroyDescriptorPool(pool); });
+
+		m_Pools.~ArrayList();
+		m_SizesPerSet.clear();
+		m_CurrentPool = 0;
+		m_NextSetCount = 0;
+	}
+
+	vk::DescriptorSet DescriptorAllocator::allocate(vk::DescriptorSetLayout layout)
+	{
+		NA_ASSERT(m_SizesPerSet.size(), "Failed to allocate descriptor set: DescriptorAllocator is empty!");
+
+		for (;; m_CurrentPool++)
+		{
+			bool new_pool = m_CurrentPool == m_Pools.size();
+			if (new_pool)
+			{
+				m_Pools.emplace(this->_create_pool(m_NextSetCount));
+				m_NextSetCount = std::min(m_NextSetCount * 2, k_MaxSetsPerPool);
+			}
+
+			vk::DescriptorSetAllocateInfo alloc_info;
+			alloc_info.descriptorPool = m_Pools[m_CurrentPool];
+			alloc_info.descriptorSetCount = 1;
+			alloc_info.pSetLayouts = &layout;
+
+			vk::DescriptorSet descriptor_set;
+			vk::Result result = VkContext::GetLogicalDevice().allocateDescriptorSets(&alloc_info, &descriptor_set);
+
+			if (result == vk::Result::eSuccess)
+				return descriptor_set;
+
+			// an empty pool running out means the layout needs descriptors the pools aren't sized for
+			if (new_pool || (result != vk::Result::eErrorOutOfPoolMemory && result != vk::Result::eErrorFragmentedPool))
+				throw std::runtime_error(NA_FORMAT("Failed to allocate descriptor set: {}!", vk::to_string(result)));
+		}
+	}
+
+	void DescriptorAllocator::reset(void)
+	{
+		vk::Device logical_device = VkContext::GetLogicalDevice();
+
+		for (u32 i = 0; i < m_Pools.size() && i <= m_CurrentPool; i++)
+			logical_device.resetDescriptorPool(m_Pools[i]);
+
+		m_CurrentPool = 0;
+	}
+
+	vk::DescriptorPool DescriptorAllocator::_create_pool(u32 set_count)
+	{
+		Na::ArrayVector<vk::DescriptorPoolSize> pool_sizes(m_SizesPerSet.begin(), m_SizesPerSet.end());
+		for (vk::DescriptorPoolSize& size : pool_sizes)
+			size.descriptorCount *= set_count;
+
+		vk::DescriptorPoolCreateInfo create_info;
+		create_info.poolSizeCount = (u32)pool_sizes.size();
+		create_info.pPoolSizes = pool_sizes.ptr();
+		create_info.maxSets = set_count;
+
+		return VkContext::GetLogicalDevice().createDescriptorPool(create_info);
+	}
+
+	DescriptorAllocator::DescriptorAllocator(DescriptorAllocator&& other)
+	: m_SizesPerSet(std::move(other.m_SizesPerSet)),
+	m_Pools(std::move(other.m_Pools)),
+	m_CurrentPool(std::exchange(other.m_CurrentPool, 0)),
+	m_NextSetCount(std::exchange(other.m_NextSetCount, 0))
+	{}
+
+	DescriptorAllocator& DescriptorAllocator::operator=(DescriptorAllocator&& other)
+	{
+		this->destroy();
+
+		m_SizesPerSet = std::move(other.m_SizesPerSet);
+		m_Pools = std::move(other.m_Pools);
+		m_CurrentPool = std::exchange(other.m_CurrentPool, 0);
+		m_NextSetCount = std::exchange(other.m_NextSetCount, 0);
+
+		return *this;
+	}
+} // namespace Na
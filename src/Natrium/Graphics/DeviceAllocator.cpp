@@ -0,0 +1,395 @@
+#include "Pch.hpp"
+#include "Natrium/Graphics/DeviceAllocator.hpp"
+
+#include "Natrium/Graphics/VkContext.hpp"
+#include "Natrium/Graphics/Buffers/DeviceBuffer.hpp"
+#include "Natrium/Core/Logger.hpp"
+
+#include <bit>
+
+namespace Na {
+	static constexpr u32 k_NullNode = ~0u;
+
+	static constexpr u32 k_SecondLevelLog2 = 4;
+	static constexpr u32 k_SecondLevelCount = 1 << k_SecondLevelLog2;
+	static constexpr u32 k_FirstLevelCount = 64 - k_SecondLevelLog2 + 1;
+
+	// free space smaller than this stays attached to the allocation in front of it
+	static constexpr vk::DeviceSize k_MinSplitSize = 64;
+
+	static vk::DeviceSize alignUp(vk::DeviceSize value, vk::DeviceSize alignment)
+	{
+		return (value + alignment - 1) & ~(alignment - 1);
+	}
+
+	///
+	/// first level is the power of two, second level splits it linearly into k_SecondLevelCount classes
+	///
+	static std::pair<u32, u32> sizeClass(vk::DeviceSize size)
+	{
+		if (size < k_SecondLevelCount)
+			return { 0, (u32)size };
+
+		u32 log2 = (u32)std::bit_width(size) - 1;
+		return { log2 - k_SecondLevelLog2 + 1, (u32)(size >> (log2 - k_SecondLevelLog2)) - k_SecondLevelCount };
+	}
+
+	struct DeviceMemoryBlock {
+		struct Node {
+			vk::DeviceSize offset;
+			vk::DeviceSize size;
+
+			u32 prev_physical = k_NullNode;
+			u32 next_physical = k_NullNode;
+			u32 prev_free = k_NullNode;
+			u32 next_free = k_NullNode;
+
+			bool free = false;
+		};
+
+		vk::DeviceMemory memory;
+		Byte* mapped = nullptr;
+		vk::DeviceSize size = 0;
+
+		vk::DeviceSize used_bytes = 0;
+		u32 allocation_count = 0;
+
+		std::vector<Node> nodes;
+		std::vector<u32> unused_nodes;
+
+		u64 first_level_bitmap = 0;
+		std::array<u32, k_FirstLevelCount> second_level_bitmaps{};
+		std::array<std::array<u32, k_SecondLevelCount>, k_FirstLevelCount> free_heads;
+
+		DeviceMemoryBlock(vk::DeviceMemory memory, Byte* mapped, vk::DeviceSize size)
+		: memory(memory), mapped(mapped), size(size)
+		{
+			for (auto& heads : free_heads)
+				heads.fill(k_NullNode);
+
+			nodes.push_back(Node{ 0, size });
+			this->insert_free(0);
+		}
+
+		u32 new_node(vk::DeviceSize offset, vk::DeviceSize node_size)
+		{
+			if (unused_nodes.empty())
+			{
+				nodes.push_back(Node{ offset, node_size });
+				return (u32)nodes.size() - 1;
+			}
+
+			u32 node = unused_nodes.back();
+			unused_nodes.pop_back();
+			nodes[node] = Node{ offset, node_size };
+			return node;
+		}
+
+		void insert_free(u32 node)
+		{
+			auto [fl, sl] = sizeClass(nodes[node].size);
+
+			nodes[node].free = true;
+			nodes[node].prev_free = k_NullNode;
+			nodes[node].next_free = free_heads[fl][sl];
+			if (free_heads[fl][sl] != k_NullNode)
+				nodes[free_heads[fl][sl]].prev_free = node;
+			free_heads[fl][sl] = node;
+
+			first_level_bitmap |= 1ull << fl;
+			second_level_bitmaps[fl] |= 1u << sl;
+		}
+
+		void remove_free(u32 node)
+		{
+			auto [fl, sl] = sizeClass(nodes[node].size);
+			Node& n = nodes[node];
+
+			if (n.prev_free != k_NullNode)
+				nodes[n.prev_free].next_free = n.next_free;
+			else
+				free_heads[fl][sl] = n.next_free;
+
+			if (n.next_free != k_NullNode)
+				nodes[n.next_free].prev_free = n.prev_free;
+
+			if (free_heads[fl][sl] == k_NullNode)
+			{
+				second_level_bitmaps[fl] &= ~(1u << sl);
+				if (!second_level_bitmaps[fl])
+					first_level_bitmap &= ~(1ull << fl);
+			}
+
+			n.free = false;
+		}
+
+		///
+		/// a free node at least min_size big, every node in the returned class is large enough
+		///
+		u32 find_free(vk::DeviceSize min_size) const
+		{
+			// rounding up to the next class boundary means any node in the class found fits
+			if (min_size >= k_SecondLevelCount)
+				min_size += (1ull << (std::bit_width(min_size) - 1 - k_SecondLevelLog2)) - 1;
+
+			auto [fl, sl] = sizeClass(min_size);
+			if (fl >= k_FirstLevelCount)
+				return k_NullNode;
+
+			u32 second_level = second_level_bitmaps[fl] & (~0u << sl);
+			if (!second_level)
+			{
+				u64 first_level = fl + 1 < 64 ? first_level_bitmap & (~0ull << (fl + 1)) : 0;
+				if (!first_level)
+					return k_NullNode;
+
+				fl = (u32)std::countr_zero(first_level);
+				second_level = second_level_bitmaps[fl];
+			}
+
+			return free_heads[fl][std::countr_zero(second_level)];
+		}
+
+		u32 allocate(vk::DeviceSize alloc_size, vk::DeviceSize alignment)
+		{
+			u32 node = this->find_free(alloc_size + alignment - 1);
+			if (node == k_NullNode)
+				return k_NullNode;
+
+			this->remove_free(node);
+
+			// the alignment padding in front becomes a free node of its own
+			vk::DeviceSize padding = alignUp(nodes[node].offset, alignment) - nodes[node].offset;
+			if (padding)
+			{
+				u32 front = this->new_node(nodes[node].offset, padding);
+				nodes[front].prev_physical = nodes[node].prev_physical;
+				nodes[front].next_physical = node;
+				if (nodes[front].prev_physical != k_NullNode)
+					nodes[nodes[front].prev_physical].next_physical = front;
+
+				nodes[node].prev_physical = front;
+				nodes[node].offset += padding;
+				nodes[node].size -= padding;
+				this->insert_free(front);
+			}
+
+			if (nodes[node].size - alloc_size >= k_MinSplitSize)
+			{
+				u32 back = this->new_node(nodes[node].offset + alloc_size, nodes[node].size - alloc_size);
+				nodes[back].prev_physical = node;
+				nodes[back].next_physical = nodes[node].next_physical;
+				if (nodes[back].next_physical != k_NullNode)
+					nodes[nodes[back].next_physical].prev_physical = back;
+
+				nodes[node].next_physical = back;
+				nodes[node].size = alloc_size;
+				this->insert_free(back);
+			}
+
+			used_bytes += nodes[node].size;
+			allocation_count++;
+			return node;
+		}
+
+		void free(u32 node)
+		{
+			used_bytes -= nodes[node].size;
+			allocation_count--;
+
+			// free neighbours are always merged, so at most one on each side has to be absorbed
+			u32 prev = nodes[node].prev_physical;
+			if (prev != k_NullNode && nodes[prev].free)
+			{
+				this->remove_free(prev);
+				nodes[node].offset = nodes[prev].offset;
+				nodes[node].size += nodes[prev].size;
+				nodes[node].prev_physical = nodes[prev].prev_physical;
+				if (nodes[node].prev_physical != k_NullNode)
+					nodes[nodes[node].prev_physical].next_physical = node;
+				unused_nodes.push_back(prev);
+			}
+
+			u32 next = nodes[node].next_physical;
+			if (next != k_NullNode && nodes[next].free)
+			{
+				this->remove_free(next);
+				nodes[node].size += nodes[next].size;
+				nodes[node].next_physical = nodes[next].next_physical;
+				if (nodes[node].next_physical != k_NullNode)
+					nodes[nodes[node].next_physical].prev_physical = node;
+				unused_nodes.push_back(next);
+			}
+
+			this->insert_free(node);
+		}
+	};
+
+	static bool isHostVisible(u32 memory_type)
+	{
+		static vk::PhysicalDeviceMemoryProperties x_MemoryProperties = VkContext::GetPhysicalDevice().getMemoryProperties();
+		return (bool)(x_MemoryProperties.memoryTypes[memory_type].propertyFlags & vk::MemoryPropertyFlagBits::eHostVisible);
+	}
+
+	DeviceAllocator::DeviceAllocator(vk::DeviceSize block_size)
+	: m_BlockSize(block_size)
+	{
+		m_Pools.resize(VK_MAX_MEMORY_TYPES * 2);
+	}
+
+	void DeviceAllocator::destroy(void)
+	{
+		if (m_Pools.empty())
+			return;
+
+		vk::Device logical_device = VkContext::GetLogicalDevice();
+
+		for (std::vector<DeviceMemoryBlock*>& pool : m_Pools)
+		{
+			for (DeviceMemoryBlock* block : pool)
+			{
+				if (block->allocation_count)
+					g_Logger.fmt(Warn, "DeviceAllocator destroyed with {} allocations still alive!", block->allocation_count);
+
+				logical_device.freeMemory(block->memory);
+				delete block;
+			}
+		}
+
+		m_Pools.clear();
+	}
+
+	DeviceAllocation DeviceAllocator::allocate(
+		const vk::MemoryRequirements& requirements,
+		vk::MemoryPropertyFlags properties,
+		DeviceAllocationKind kind
+	)
+	{
+		u32 memory_type = FindMemoryType(requirements.memoryTypeBits, properties);
+		bool host_visible = isHostVisible(memory_type);
+
+		std::scoped_lock lock(m_Mutex);
+
+		if (kind == DeviceAllocationKind::Dedicated || requirements.size > m_BlockSize / 2)
+			return this->_allocate_dedicated(requirements.size, memory_type, host_visible);
+
+		std::vector<DeviceMemoryBlock*>& pool = m_Pools[memory_type * 2 + (kind == DeviceAllocationKind::Image)];
+		vk::DeviceSize alignment = std::max<vk::DeviceSize>(requirements.alignment, 1);
+
+		DeviceAllocation allocation;
+		allocation.size = requirements.size;
+
+		for (DeviceMemoryBlock* block : pool)
+		{
+			u32 node = block->allocate(requirements.size, alignment);
+			if (node == k_NullNode)
+				continue;
+
+			allocation.memory = block->memory;
+			allocation.offset = block->nodes[node].offset;
+			allocation.mapped = block->mapped ? block->mapped + allocation.offset : nullptr;
+			allocation.block = block;
+			allocation.node = node;
+			return allocation;
+		}
+
+		vk::Device logical_device = VkContext::GetLogicalDevice();
+
+		vk::DeviceMemory memory = logical_device.allocateMemory(vk::MemoryAllocateInfo(m_BlockSize, memory_type));
+		Byte* mapped = host_visible ? (Byte*)logical_device.mapMemory(memory, 0, VK_WHOLE_SIZE) : nullptr;
+
+		DeviceMemoryBlock* block = pool.emplace_back(new DeviceMemoryBlock(memory, mapped, m_BlockSize));
+
+		u32 node = block->allocate(requirements.size, alignment);
+		NA_VERIFY(node != k_NullNode, "Failed to allocate device memory: Allocation doesn't fit a fresh block!");
+
+		allocation.memory = block->memory;
+		allocation.offset = block->nodes[node].offset;
+		allocation.mapped = block->mapped ? block->mapped + allocation.offset : nullptr;
+		allocation.block = block;
+		allocation.node = node;
+		return allocation;
+	}
+
+	DeviceAllocation DeviceAllocator::_allocate_dedicated(vk::DeviceSize size, u32 memory_type, bool host_visible)
+	{
+		vk::Device logical_device = VkContext::GetLogicalDevice();
+
+		DeviceAllocation allocation;
+		allocation.memory = logical_device.allocateMemory(vk::MemoryAllocateInfo(size, memory_type));
+		allocation.size = size;
+		if (host_visible)
+			allocation.mapped = (Byte*)logical_device.mapMemory(allocation.memory, 0, VK_WHOLE_SIZE);
+
+		m_DedicatedCount++;
+		m_DedicatedBytes += size;
+		return allocation;
+	}
+
+	void DeviceAllocator::free(DeviceAllocation& allocation)
+	{
+		if (!allocation)
+			return;
+
+		vk::Device logical_device = VkContext::GetLogicalDevice();
+
+		std::scoped_lock lock(m_Mutex);
+
+		if (!allocation.block)
+		{
+			logical_device.freeMemory(allocation.memory);
+			m_DedicatedCount--;
+			m_DedicatedBytes -= allocation.size;
+			allocation = {};
+			return;
+		}
+
+		DeviceMemoryBlock* block = allocation.block;
+		block->free(allocation.node);
+		allocation = {};
+
+		if (block->allocation_count)
+			return;
+
+		// one empty block per pool is kept around so a create/destroy loop doesn't hit the driver every time
+		for (std::vector<DeviceMemoryBlock*>& pool : m_Pools)
+		{
+			auto it = std::find(pool.begin(), pool.end(), block);
+			if (it == pool.end())
+				continue;
+
+			bool other_empty = std::any_of(pool.begin(), pool.end(),
+				[block](const DeviceMemoryBlock* other) { return other != block && !other->allocation_count; });
+			if (other_empty)
+			{
+				logical_device.freeMemory(block->memory);
+				delete block;
+				pool.erase(it);
+			}
+			return;
+		}
+	}
+
+	DeviceAllocatorStats DeviceAllocator::stats(void) const
+	{
+		std::scoped_lock lock(m_Mutex);
+
+		DeviceAllocatorStats stats;
+		stats.dedicated_count = m_DedicatedCount;
+		stats.dedicated_bytes = m_DedicatedBytes;
+		stats.allocation_count = m_DedicatedCount;
+
+		for (const std::vector<DeviceMemoryBlock*>& pool : m_Pools)
+		{
+			for (const DeviceMemoryBlock* block : pool)
+			{
+				stats.block_count++;
+				stats.block_bytes += block->size;
+				stats.used_bytes += block->used_bytes;
+				stats.allocation_count += block->allocation_count;
+			}
+		}
+
+		return stats;
+	}
+} // namespace Na
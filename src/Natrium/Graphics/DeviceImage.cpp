@@ -3,6 +3,8 @@
 
 #include "Natrium/Graphics/VkContext.hpp"
 #include "Natrium/Graphics/Buffers/DeviceBuffer.hpp"
+#include "Natrium/Graphics/MipChain.hpp"
+#include "Natrium/Graphics/BlockCompression.hpp"
 
 namespace Na {
 	vk::Format FindSupportedFormat(
@@ -34,23 +36,27 @@ namespace Na {
 		vk::ImageUsageFlags usage,
 		vk::SharingMode sharing_mode,
 		vk::SampleCountFlagBits sample_count,
-		vk::MemoryPropertyFlags memory_properties
+		vk::MemoryPropertyFlags memory_properties,
+		u32 mip_levels,
+		vk::ImageCreateFlags create_flags
 	)
 	: extent(extent),
 	format(format),
 	subresource_range(
 		aspect_mask,
 		0,
-		1,
+		mip_levels,
 		0,
 		layer_count
 	)
 	{
 		NA_ASSERT(layer_count > 0, "Failed to create DeviceImage: Invalid layer count!");
+		NA_ASSERT(mip_levels > 0 && mip_levels <= MipLevelCount(extent.width, extent.height), "Failed to create DeviceImage: Invalid mip level count!");
 
 		vk::Device logical_device = VkContext::GetLogicalDevice();
 
 		vk::ImageCreateInfo create_info;
+		create_info.flags = create_flags;
 
 		if (extent.depth == 1)
 			create_info.imageType = vk::ImageType::e2D;
@@ -60,7 +66,7 @@ namespace Na {
 			throw std::runtime_error("Failed to create DeviceImage: Invalid depth!");
 
 		create_info.extent = extent;
-		create_info.mipLevels = 1;
+		create_info.mipLevels = mip_levels;
 		create_info.arrayLayers = layer_count;
 
 		create_info.format = format;
@@ -77,26 +83,32 @@ namespace Na {
 
 		vk::MemoryRequirements memory_requirements = logical_device.getImageMemoryRequirements(this->img);
 
-		vk::MemoryAllocateInfo alloc_info;
-		alloc_info.allocationSize = memory_requirements.size;
-		alloc_info.memoryTypeIndex = FindMemoryType(
-			memory_requirements.memoryTypeBits,
-			memory_properties
+		// attachments are recreated with the swapchain and often large, so they don't fragment the shared blocks
+		bool dedicated = (bool)(usage & (
+			vk::ImageUsageFlagBits::eColorAttachment |
+			vk::ImageUsageFlagBits::eDepthStencilAttachment |
+			vk::ImageUsageFlagBits::eTransientAttachment
+		));
+
+		this->memory = VkContext::GetAllocator().allocate(
+			memory_requirements,
+			memory_properties,
+			dedicated ? DeviceAllocationKind::Dedicated : DeviceAllocationKind::Image
 		);
-
-		this->memory = logical_device.allocateMemory(alloc_info);
-		logical_device.bindImageMemory(this->img, this->memory, 0);
+		logical_device.bindImageMemory(this->img, this->memory.memory, this->memory.offset);
 	}
 
 	void DeviceImage::destroy(void)
 	{
-		vk::Device logical_device = VkContext::GetLogicalDevice();
-
-		if (this->img)
-			logical_device.destroyImage(this->img);
-
-		if (this->memory)
-			logical_device.freeMemory(this->memory);
+		if (this->img || this->memory)
+		{
+			VkContext::DeferDestruction([img = this->img, memory = this->memory](void) mutable
+			{
+				if (img)
+					VkContext::GetLogicalDevice().destroyImage(img);
+				VkContext::GetAllocator().free(memory);
+			});
+		}
 
 		memset(this, 0, sizeof(DeviceImage));
 	}
@@ -155,10 +167,10 @@ namespace Na {
 		VkContext::EndSingleTimeCommands(cmd_buffer);
 	}
 
-	void DeviceImage::copy_from_buffer(vk::Buffer buffer, u32 starting_layer, u32 layer_count)
+	void DeviceImage::copy_from_buffer(vk::Buffer buffer, u32 starting_layer, u32 layer_count, vk::DeviceSize buffer_offset)
 	{
 		vk::BufferImageCopy region;
-		region.bufferOffset = 0;
+		region.bufferOffset = buffer_offset;
 		region.bufferRowLength = 0;
 		region.bufferImageHeight = 0;
 
@@ -241,6 +253,174 @@ namespace Na {
 	}
 	*/
 
+	void DeviceImage::copy_mips_from_buffer(vk::Buffer buffer, u32 texel_size, vk::DeviceSize buffer_offset)
+	{
+		Na::ArrayVector<vk::BufferImageCopy> regions(this->mip_levels());
+		u32 block_size = BlockSize(this->format);
+
+		u64 offset = buffer_offset;
+		for (u32 level = 0; level < regions.size(); level++)
+		{
+			u32 level_width = MipExtent(this->width, level);
+			u32 level_height = MipExtent(this->height, level);
+
+			regions[level].bufferOffset = offset;
+			regions[level].imageSubresource = vk::ImageSubresourceLayers(
+				this->subresource_range.aspectMask,
+				level,
+				0, // base layer
+				this->layer_count()
+			);
+			regions[level].imageExtent = vk::Extent3D(level_width, level_height, 1);
+
+			u64 layer_size = block_size
+				? BlockCount(level_width, level_height) * block_size
+				: (u64)level_width * level_height * texel_size;
+			offset += layer_size * this->layer_count();
+		}
+
+		this->copy_regions_from_buffer(buffer, regions.ptr(), (u32)regions.size());
+	}
+
+	void DeviceImage::copy_regions_from_buffer(vk::Buffer buffer, const vk::BufferImageCopy* regions, u32 region_count)
+	{
+		vk::CommandBuffer cmd_buffer = VkContext::BeginSingleTimeCommands();
+
+		cmd_buffer.copyBufferToImage(
+			buffer, // src
+			this->img, // dest
+			vk::ImageLayout::eTransferDstOptimal,
+			region_count, regions
+		);
+
+		VkContext::EndSingleTimeCommands(cmd_buffer);
+	}
+
+	SubmissionToken DeviceImage::copy_regions_from_buffer_async(vk::Buffer buffer, const vk::BufferImageCopy* regions, u32 region_count)
+	{
+		vk::CommandBuffer cmd_buffer = VkContext::BeginTransferCommands();
+
+		vk::ImageMemoryBarrier barrier;
+		barrier.oldLayout = vk::ImageLayout::eUndefined;
+		barrier.newLayout = vk::ImageLayout::eTransferDstOptimal;
+		barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.image = this->img;
+		barrier.subresourceRange = this->subresource_range;
+		barrier.srcAccessMask = {};
+		barrier.dstAccessMask = vk::AccessFlagBits::eTransferWrite;
+
+		cmd_buffer.pipelineBarrier(
+			vk::PipelineStageFlagBits::eTopOfPipe,
+			vk::PipelineStageFlagBits::eTransfer,
+			{}, 0, nullptr, 0, nullptr, 1, &barrier
+		);
+
+		cmd_buffer.copyBufferToImage(
+			buffer, // src
+			this->img, // dest
+			vk::ImageLayout::eTransferDstOptimal,
+			region_count, regions
+		);
+
+		// handed over to the graphics queue along with the layout change
+		barrier.oldLayout = vk::ImageLayout::eTransferDstOptimal;
+		barrier.newLayout = vk::ImageLayout::eShaderReadOnlyOptimal;
+		barrier.srcAccessMask = vk::AccessFlagBits::eTransferWrite;
+		barrier.dstAccessMask = vk::AccessFlagBits::eShaderRead;
+
+		return VkContext::EndTransferCommands(cmd_buffer, nullptr, 0, &barrier, 1);
+	}
+
+	bool DeviceImage::supports_blit_mipmaps(void) const
+	{
+		vk::FormatProperties properties = VkContext::GetPhysicalDevice().getFormatProperties(this->format);
+
+		vk::FormatFeatureFlags required_features =
+			vk::FormatFeatureFlagBits::eBlitSrc |
+			vk::FormatFeatureFlagBits::eBlitDst |
+			vk::FormatFeatureFlagBits::eSampledImageFilterLinear;
+
+		return (properties.optimalTilingFeatures & required_features) == required_features;
+	}
+
+	void DeviceImage::generate_mipmaps(void)
+	{
+		NA_ASSERT(this->supports_blit_mipmaps(), "Failed to generate mipmaps: Format does not support linear blitting!");
+
+		vk::ImageMemoryBarrier barrier;
+		barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.image = this->img;
+		barrier.subresourceRange = this->subresource_range;
+		barrier.subresourceRange.levelCount = 1;
+
+		vk::CommandBuffer cmd_buffer = VkContext::BeginSingleTimeCommands();
+
+		for (u32 level = 1; level < this->mip_levels(); level++)
+		{
+			barrier.subresourceRange.baseMipLevel = level - 1;
+			barrier.oldLayout = vk::ImageLayout::eTransferDstOptimal;
+			barrier.newLayout = vk::ImageLayout::eTransferSrcOptimal;
+			barrier.srcAccessMask = vk::AccessFlagBits::eTransferWrite;
+			barrier.dstAccessMask = vk::AccessFlagBits::eTransferRead;
+
+			cmd_buffer.pipelineBarrier(
+				vk::PipelineStageFlagBits::eTransfer,
+				vk::PipelineStageFlagBits::eTransfer,
+				{}, // dependency flags
+				0, nullptr, // memory barriers
+				0, nullptr, // buffer memory barriers
+				1, &barrier // image memory barriers
+			);
+
+			vk::ImageBlit blit;
+			blit.srcOffsets[1] = vk::Offset3D((i32)MipExtent(this->width, level - 1), (i32)MipExtent(this->height, level - 1), 1);
+			blit.srcSubresource = vk::ImageSubresourceLayers(this->subresource_range.aspectMask, level - 1, 0, this->layer_count());
+			blit.dstOffsets[1] = vk::Offset3D((i32)MipExtent(this->width, level), (i32)MipExtent(this->height, level), 1);
+			blit.dstSubresource = vk::ImageSubresourceLayers(this->subresource_range.aspectMask, level, 0, this->layer_count());
+
+			cmd_buffer.blitImage(
+				this->img, vk::ImageLayout::eTransferSrcOptimal,
+				this->img, vk::ImageLayout::eTransferDstOptimal,
+				1, &blit,
+				vk::Filter::eLinear
+			);
+
+			barrier.oldLayout = vk::ImageLayout::eTransferSrcOptimal;
+			barrier.newLayout = vk::ImageLayout::eShaderReadOnlyOptimal;
+			barrier.srcAccessMask = vk::AccessFlagBits::eTransferRead;
+			barrier.dstAccessMask = vk::AccessFlagBits::eShaderRead;
+
+			cmd_buffer.pipelineBarrier(
+				vk::PipelineStageFlagBits::eTransfer,
+				vk::PipelineStageFlagBits::eFragmentShader,
+				{}, // dependency flags
+				0, nullptr, // memory barriers
+				0, nullptr, // buffer memory barriers
+				1, &barrier // image memory barriers
+			);
+		}
+
+		// the last level was only ever written to
+		barrier.subresourceRange.baseMipLevel = this->mip_levels() - 1;
+		barrier.oldLayout = vk::ImageLayout::eTransferDstOptimal;
+		barrier.newLayout = vk::ImageLayout::eShaderReadOnlyOptimal;
+		barrier.srcAccessMask = vk::AccessFlagBits::eTransferWrite;
+		barrier.dstAccessMask = vk::AccessFlagBits::eShaderRead;
+
+		cmd_buffer.pipelineBarrier(
+			vk::PipelineStageFlagBits::eTransfer,
+			vk::PipelineStageFlagBits::eFragmentShader,
+			{}, // dependency flags
+			0, nullptr, // memory barriers
+			0, nullptr, // buffer memory barriers
+			1, &barrier // image memory barriers
+		);
+
+		VkContext::EndSingleTimeCommands(cmd_buffer);
+	}
+
 	void DeviceImage::copy_from_buffers(const vk::Buffer* buffers, u32 buffer_count, u32 starting_layer)
 	{
 		vk::CommandBuffer cmd_buffer = VkContext::BeginSingleTimeCommands();
@@ -275,7 +455,7 @@ namespace Na {
 
 	DeviceImage::DeviceImage(DeviceImage&& other)
 	: img(std::exchange(other.img, nullptr)),
-	memory(std::exchange(other.memory, nullptr)),
+	memory(std::exchange(other.memory, {})),
 	extent(other.extent),
 	format(other.format),
 	subresource_range(other.subresource_range)
@@ -285,20 +465,22 @@ namespace Na {
 	{
 		this->destroy();
 		this->img = std::exchange(other.img, nullptr);
-		this->memory = std::exchange(other.memory, nullptr);
+		this->memory = std::exchange(other.memory, {});
 		this->extent = other.extent;
 		this->format = other.format;
 		this->subresource_range = other.subresource_range;
 		return *this;
 	}
 
-	vk::ImageView DeviceImage::create_img_view(void) const
+	vk::ImageView DeviceImage::create_img_view(const vk::ComponentMapping& components) const
 	{
 		return CreateImageView(
 			this->img,
 			this->subresource_range.aspectMask,
 			this->format,
-			this->layer_count()
+			this->layer_count(),
+			this->mip_levels(),
+			components
 		);
 	}
 
@@ -306,7 +488,9 @@ namespace Na {
 		vk::Image img,
 		vk::ImageAspectFlags aspect_mask,
 		vk::Format format,
-		u32 layer_count
+		u32 layer_count,
+		u32 mip_levels,
+		const vk::ComponentMapping& components
 	)
 	{
 		vk::ImageViewCreateInfo create_info;
@@ -320,11 +504,12 @@ namespace Na {
 			throw std::runtime_error("Failed to create Image View: Invalid layer count!");
 
 		create_info.format = format;
+		create_info.components = components;
 
 		create_info.subresourceRange.aspectMask = aspect_mask;
 
 		create_info.subresourceRange.baseMipLevel = 0;
-		create_info.subresourceRange.levelCount = 1;
+		create_info.subresourceRange.levelCount = mip_levels;
 
 		create_info.subresourceRange.baseArrayLayer = 0;
 		create_info.subresourceRange.layerCount = layer_count;
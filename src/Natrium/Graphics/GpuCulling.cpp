@@ -0,0 +1,275 @@
+#include "Pch.hpp"
+#include "Natrium/Graphics/GpuCulling.hpp"
+
+#include "Natrium/Graphics/VkContext.hpp"
+#include "Natrium/Graphics/ShaderModule.hpp"
+#include "Natrium/Graphics/Renderer/Renderer.hpp"
+
+namespace Na {
+	// the screen rectangle of the sphere's bounding box is tested against the pyramid level where it
+	// covers at most 2x2 texels, anything crossing the near plane is kept
+	static constexpr std::string_view k_CullSource = R"(
+		#version 450
+
+		layout(local_size_x = 64) in;
+
+		layout(binding = 0) uniform View {
+			mat4 view_projection;
+			vec4 planes[6];
+		} u_View;
+
+		struct Instance {
+			vec4 sphere;
+			uint index_count;
+			uint first_index;
+			int vertex_offset;
+			uint padding;
+		};
+
+		layout(std430, binding = 1) readonly buffer Instances {
+			Instance instances[];
+		} u_Instances;
+
+		struct DrawCommand {
+			uint index_count;
+			uint instance_count;
+			uint first_index;
+			int vertex_offset;
+			uint first_instance;
+		};
+
+		layout(std430, binding = 2) buffer Commands {
+			uint count;
+			uint padding[3];
+			DrawCommand commands[];
+		} u_Commands;
+
+		layout(binding = 3) uniform sampler2D u_Pyramid;
+
+		layout(push_constant) uniform Cull {
+			uint instance_count;
+			uint flags;
+			uint pyramid_levels;
+			uint padding;
+			vec2 pyramid_size;
+		} u_Cull;
+
+		const uint k_Occlusion = 1;
+
+		bool occluded(vec3 center, float radius)
+		{
+			vec2 ndc_min = vec2(1.0e9), ndc_max = vec2(-1.0e9);
+			float nearest = 1.0;
+			for (int i = 0; i < 8; i++)
+			{
+				vec3 corner = center + radius * vec3(
+					(i & 1) != 0 ? 1.0 : -1.0,
+					(i & 2) != 0 ? 1.0 : -1.0,
+					(i & 4) != 0 ? 1.0 : -1.0
+				);
+
+				vec4 clip = u_View.view_projection * vec4(corner, 1.0);
+				if (clip.w <= 0.0)
+					return false;
+
+				vec3 ndc = clip.xyz / clip.w;
+				ndc_min = min(ndc_min, ndc.xy);
+				ndc_max = max(ndc_max, ndc.xy);
+				nearest = min(nearest, ndc.z);
+			}
+
+			if (nearest <= 0.0)
+				return false;
+
+			// the viewport is flipped, ndc y = 1 is the top row
+			vec2 uv_min = clamp(vec2(ndc_min.x, -ndc_max.y) * 0.5 + 0.5, 0.0, 1.0);
+			vec2 uv_max = clamp(vec2(ndc_max.x, -ndc_min.y) * 0.5 + 0.5, 0.0, 1.0);
+
+			vec2 extent = (uv_max - uv_min) * u_Cull.pyramid_size;
+			int level = min(int(ceil(log2(max(max(extent.x, extent.y), 1.0)))), int(u_Cull.pyramid_levels) - 1);
+
+			ivec2 level_size = max(ivec2(u_Cull.pyramid_size) >> level, ivec2(1));
+			ivec2 begin = clamp(ivec2(uv_min * vec2(level_size)), ivec2(0), level_size - 1);
+			ivec2 end = clamp(ivec2(uv_max * vec2(level_size)), ivec2(0), level_size - 1);
+
+			float farthest = 0.0;
+			for (int y = begin.y; y <= end.y; y++)
+				for (int x = begin.x; x <= end.x; x++)
+					farthest = max(farthest, texelFetch(u_Pyramid, ivec2(x, y), level).r);
+
+			return nearest > farthest;
+		}
+
+		void main()
+		{
+			uint index = gl_GlobalInvocationID.x;
+			if (index >= u_Cull.instance_count)
+				return;
+
+			Instance instance = u_Instances.instances[index];
+
+			bool visible = true;
+			for (int i = 0; i < 6; i++)
+				visible = visible && dot(u_View.planes[i].xyz, instance.sphere.xyz) + u_View.planes[i].w >= -instance.sphere.w;
+
+			if (visible && (u_Cull.flags & k_Occlusion) != 0)
+				visible = !occluded(instance.sphere.xyz, instance.sphere.w);
+
+			if (!visible)
+				return;
+
+			u_Commands.commands[atomicAdd(u_Commands.count, 1u)] = DrawCommand(
+				instance.index_count,
+				1u, // instance count
+				instance.first_index,
+				instance.vertex_offset,
+				index // first instance
+			);
+		}
+	)";
+
+	struct CullView {
+		glm::mat4 view_projection;
+		std::array<glm::vec4, 6> planes;
+	};
+
+	struct CullConstants {
+		u32 instance_count;
+		u32 flags;
+		u32 pyramid_levels;
+		u32 padding;
+		glm::vec2 pyramid_size;
+	};
+
+	static constexpr PushConstant k_CullPushConstant = { ShaderStageBits::Compute, sizeof(CullConstants) };
+
+	static constexpr u32 k_CullOcclusion = 1;
+
+	static constexpr u32 k_CullGroupSize = 64;
+
+	// left, right, bottom, top, near and far, normalized so sphere distances can be compared with the radius
+	static std::array<glm::vec4, 6> frustumPlanes(const glm::mat4& view_projection)
+	{
+		glm::mat4 rows = glm::transpose(view_projection);
+
+		std::array<glm::vec4, 6> planes = {
+			rows[3] + rows[0],
+			rows[3] - rows[0],
+			rows[3] + rows[1],
+			rows[3] - rows[1],
+			rows[2], // depth is 0 to 1
+			rows[3] - rows[2]
+		};
+		for (glm::vec4& plane : planes)
+			plane /= glm::length(glm::vec3(plane));
+
+		return planes;
+	}
+
+	GpuCulling::GpuCulling(u32 max_instances, const RendererSettings& renderer_settings)
+	: m_DepthPyramid(renderer_settings),
+	m_View(sizeof(CullView), renderer_settings),
+	m_Commands(max_instances, renderer_settings, IndirectBufferMode::Device)
+	{
+		// instances are only told apart by their first instance
+		NA_VERIFY(
+			VkContext::IsDrawIndirectFirstInstanceSupported(),
+			"Failed to create GpuCulling: The device doesn't support drawIndirectFirstInstance!"
+		);
+		// the visible commands are drawn in one call with the count the shader wrote
+		NA_VERIFY(
+			VkContext::IsMultiDrawIndirectSupported() && VkContext::GetCmdDrawIndexedIndirectCount(),
+			"Failed to create GpuCulling: The device doesn't support multiDrawIndirect and VK_KHR_draw_indirect_count!"
+		);
+
+		ShaderString source(k_CullSource, "GpuCulling");
+		ShaderModule module(ShaderBinary(source.compile("main", ShaderStageBits::Compute)), ShaderStageBits::Compute);
+		m_Pipeline = ComputePipeline(renderer_settings, module);
+	}
+
+	void GpuCulling::destroy(void)
+	{
+		m_Pipeline.destroy();
+		m_DepthPyramid.destroy();
+		m_View.destroy();
+		m_Commands.destroy();
+		m_InstanceCount = 0;
+	}
+
+	void GpuCulling::cull(Renderer& renderer, const StorageBuffer& instances, u32 instance_count, const glm::mat4& view_projection)
+	{
+		NA_ASSERT(instance_count <= m_Commands.max_draws(), "Failed to cull: {} instances are past the {} the culling pass was made for!", instance_count, m_Commands.max_draws());
+		NA_ASSERT(instance_count * sizeof(CullInstance) <= instances.per_frame_size(), "Failed to cull: {} instances don't fit into the instance buffer!", instance_count);
+
+		m_InstanceCount = instance_count;
+		m_CulledFrame = renderer.frame_number();
+
+		bool occlusion = m_DepthPyramid.build(renderer) && m_OcclusionEnabled;
+
+		u32 flags = occlusion ? k_CullOcclusion : 0;
+
+		// the shader appends after the fill
+		m_Commands.clear(renderer);
+
+		CullView view = { view_projection, frustumPlanes(view_projection) };
+		renderer.set_descriptor_buffer(&m_View, &view);
+
+		vk::DescriptorSet set = renderer.allocate_frame_descriptor_set(m_Pipeline);
+		m_Pipeline.bind_uniforms(set, m_View, instances, m_Commands, m_DepthPyramid.uniform());
+
+		renderer.bind_pipeline(m_Pipeline);
+		renderer.bind_descriptor_set(set);
+
+		CullConstants constants = {
+			instance_count,
+			flags,
+			m_DepthPyramid.mip_levels(),
+			0, // padding
+			glm::vec2(m_DepthPyramid.width(), m_DepthPyramid.height())
+		};
+		renderer.set_push_constant(k_CullPushConstant, &constants, m_Pipeline);
+
+		if (instance_count)
+			renderer.dispatch((instance_count + k_CullGroupSize - 1) / k_CullGroupSize);
+
+		renderer.compute_barrier(
+			m_Commands.buffer(),
+			ComputeOutputUse::Indirect,
+			m_Commands.frame_offset(renderer.current_frame_index()),
+			m_Commands.frame_size()
+		);
+	}
+
+	void GpuCulling::draw(Renderer& renderer) const
+	{
+		if (renderer.frame_number() != m_CulledFrame)
+			return;
+
+		renderer.draw_indexed_indirect_count(m_Commands, m_InstanceCount);
+	}
+
+	GpuCulling::GpuCulling(GpuCulling&& other)
+	: m_Pipeline(std::move(other.m_Pipeline)),
+	m_DepthPyramid(std::move(other.m_DepthPyramid)),
+	m_View(std::move(other.m_View)),
+	m_Commands(std::move(other.m_Commands)),
+	m_InstanceCount(std::exchange(other.m_InstanceCount, 0)),
+	m_CulledFrame(other.m_CulledFrame),
+	m_OcclusionEnabled(other.m_OcclusionEnabled)
+	{}
+
+	GpuCulling& GpuCulling::operator=(GpuCulling&& other)
+	{
+		this->destroy();
+
+		m_Pipeline = std::move(other.m_Pipeline);
+		m_DepthPyramid = std::move(other.m_DepthPyramid);
+		m_View = std::move(other.m_View);
+		m_Commands = std::move(other.m_Commands);
+		m_InstanceCount = std::exchange(other.m_InstanceCount, 0);
+		m_CulledFrame = other.m_CulledFrame;
+		m_OcclusionEnabled = other.m_OcclusionEnabled;
+
+		return *this;
+	}
+} // namespace Na
@@ -0,0 +1,334 @@
+#include "Pch.hpp"
+#include "Internal.hpp"
+
+#include "Natrium/Graphics/VkContext.hpp"
+
+#include <mutex>
+
+namespace Na {
+	template<typename t_Handle>
+	struct HandleCache {
+		struct Entry {
+			t_Handle handle;
+			u32 ref_count;
+		};
+
+		std::mutex mutex;
+		std::unordered_map<std::string, Entry> entries;
+		std::unordered_map<typename t_Handle::CType, std::string> keys;
+
+		///
+		/// the handle is created outside the lock so a slow pipeline compile on a worker thread doesn't stall
+		/// every other acquire, if two threads race on the same key the loser destroys its copy
+		///
+		template<typename t_Create, typename t_Destroy>
+		t_Handle acquire(std::string&& key, t_Create&& create, t_Destroy&& destroy)
+		{
+			{
+				std::scoped_lock lock(mutex);
+
+				auto it = entries.find(key);
+				if (it != entries.end())
+				{
+					it->second.ref_count++;
+					return it->second.handle;
+				}
+			}
+
+			t_Handle handle = create();
+
+			std::scoped_lock lock(mutex);
+
+			auto it = entries.find(key);
+			if (it != entries.end())
+			{
+				destroy(handle);
+				it->second.ref_count++;
+				return it->second.handle;
+			}
+
+			keys[(typename t_Handle::CType)handle] = key;
+			entries.emplace(std::move(key), Entry{ handle, 1 });
+			return handle;
+		}
+
+		///
+		/// returns the handle once its last reference is gone and it has to be destroyed, null otherwise
+		///
+		t_Handle release(t_Handle handle)
+		{
+			if (!handle)
+				return nullptr;
+
+			std::scoped_lock lock(mutex);
+
+			auto key_it = keys.find((typename t_Handle::CType)handle);
+			NA_ASSERT(key_it != keys.end(), "Failed to release handle: Handle isn't cached!");
+
+			auto it = entries.find(key_it->second);
+			if (--it->second.ref_count)
+				return nullptr;
+
+			entries.erase(it);
+			keys.erase(key_it);
+			return handle;
+		}
+	};
+
+	static HandleCache<vk::DescriptorSetLayout> s_DescriptorSetLayouts;
+	static HandleCache<vk::PipelineLayout> s_PipelineLayouts;
+	static HandleCache<vk::Pipeline> s_GraphicsPipelines;
+	static HandleCache<vk::Pipeline> s_ComputePipelines;
+
+	static std::mutex s_ShaderModuleMutex;
+	static std::unordered_map<VkShaderModule, std::string> s_ShaderModuleCode;
+	static u64 s_UniquePipelineCount = 0;
+
+	template<typename T>
+	static void appendKey(std::string& key, const T& value)
+	{
+		key.append((const char*)&value, sizeof(T));
+	}
+
+	static void appendKey(std::string& key, const void* data, u64 size)
+	{
+		appendKey(key, size);
+		key.append((const char*)data, size);
+	}
+
+	vk::DescriptorSetLayout Internal::AcquireDescriptorSetLayout(const vk::DescriptorSetLayoutBinding* bindings, u32 binding_count)
+	{
+		// the binding order doesn't matter to vulkan, so it doesn't get to split the cache either
+		Na::ArrayVector<vk::DescriptorSetLayoutBinding> sorted(bindings, binding_count);
+		std::sort(sorted.begin(), sorted.end(),
+			[](const vk::DescriptorSetLayoutBinding& a, const vk::DescriptorSetLayoutBinding& b) { return a.binding < b.binding; });
+
+		std::string key;
+		for (const vk::DescriptorSetLayoutBinding& binding : sorted)
+		{
+			NA_ASSERT(!binding.pImmutableSamplers, "Failed to acquire descriptor set layout: Immutable samplers aren't supported!");
+			appendKey(key, binding.binding);
+			appendKey(key, binding.descriptorType);
+			appendKey(key, binding.descriptorCount);
+			appendKey(key, (u32)binding.stageFlags);
+		}
+
+		return s_DescriptorSetLayouts.acquire(std::move(key), [&](void)
+		{
+			vk::DescriptorSetLayoutCreateInfo create_info;
+			create_info.bindingCount = binding_count;
+			create_info.pBindings = bindings;
+
+			return VkContext::GetLogicalDevice().createDescriptorSetLayout(create_info);
+		}, [](vk::DescriptorSetLayout layout) { VkContext::GetLogicalDevice().destroyDescriptorSetLayout(layout); });
+	}
+
+	void Internal::ReleaseDescriptorSetLayout(vk::DescriptorSetLayout layout)
+	{
+		VkContext::GetLogicalDevice().destroyDescriptorSetLayout(s_DescriptorSetLayouts.release(layout));
+	}
+
+	vk::PipelineLayout Internal::AcquirePipelineLayout(
+		const vk::DescriptorSetLayout* set_layouts,
+		u32 set_layout_count,
+		const vk::PushConstantRange* push_constant_ranges,
+		u32 push_constant_range_count
+	)
+	{
+		// set layouts are deduplicated already, so their handles identify them
+		std::string key;
+		appendKey(key, set_layout_count);
+		for (u32 i = 0; i < set_layout_count; i++)
+			appendKey(key, (VkDescriptorSetLayout)set_layouts[i]);
+		for (u32 i = 0; i < push_constant_range_count; i++)
+		{
+			appendKey(key, (u32)push_constant_ranges[i].stageFlags);
+			appendKey(key, push_constant_ranges[i].offset);
+			appendKey(key, push_constant_ranges[i].size);
+		}
+
+		return s_PipelineLayouts.acquire(std::move(key), [&](void)
+		{
+			return VkContext::GetLogicalDevice().createPipelineLayout(
+				vk::PipelineLayoutCreateInfo(
+					{}, // flags
+					set_layout_count, set_layouts,
+					push_constant_range_count, push_constant_ranges
+				)
+			);
+		}, [](vk::PipelineLayout layout) { VkContext::GetLogicalDevice().destroyPipelineLayout(layout); });
+	}
+
+	void Internal::ReleasePipelineLayout(vk::PipelineLayout layout)
+	{
+		VkContext::GetLogicalDevice().destroyPipelineLayout(s_PipelineLayouts.release(layout));
+	}
+
+	void Internal::RegisterShaderModule(vk::ShaderModule module, const void* code, u64 size)
+	{
+		std::scoped_lock lock(s_ShaderModuleMutex);
+		s_ShaderModuleCode[(VkShaderModule)module].assign((const char*)code, size);
+	}
+
+	void Internal::UnregisterShaderModule(vk::ShaderModule module)
+	{
+		if (!module)
+			return;
+
+		std::scoped_lock lock(s_ShaderModuleMutex);
+		s_ShaderModuleCode.erase((VkShaderModule)module);
+	}
+
+	static void appendKey(std::string& key, const vk::PipelineShaderStageCreateInfo& stage)
+	{
+		{
+			std::scoped_lock lock(s_ShaderModuleMutex);
+			auto it = s_ShaderModuleCode.find((VkShaderModule)stage.module);
+
+			// handles can be reused for different code, so modules of unknown content are never shared,
+			// the whole code goes into the key since a hash collision would hand out another shader's pipeline
+			if (it != s_ShaderModuleCode.end())
+				appendKey(key, it->second.data(), it->second.size());
+			else
+				key += NA_FORMAT("unique {}", s_UniquePipelineCount++);
+		}
+		appendKey(key, (u32)stage.stage);
+		appendKey(key, stage.pName, strlen(stage.pName));
+
+		const vk::SpecializationInfo* specialization = stage.pSpecializationInfo;
+		appendKey(key, specialization ? specialization->mapEntryCount : 0);
+		if (!specialization)
+			return;
+
+		for (u32 i = 0; i < specialization->mapEntryCount; i++)
+		{
+			appendKey(key, specialization->pMapEntries[i].constantID);
+			appendKey(key, specialization->pMapEntries[i].offset);
+			appendKey(key, (u64)specialization->pMapEntries[i].size);
+		}
+		appendKey(key, specialization->pData, specialization->dataSize);
+	}
+
+	///
+	/// every piece of state the pipeline is created from, field by field so padding never ends up in the key
+	///
+	static std::string graphicsPipelineKey(const vk::GraphicsPipelineCreateInfo& info)
+	{
+		std::string key;
+
+		appendKey(key, info.stageCount);
+		for (u32 i = 0; i < info.stageCount; i++)
+			appendKey(key, info.pStages[i]);
+
+		const vk::PipelineVertexInputStateCreateInfo& vertex_input = *info.pVertexInputState;
+		appendKey(key, vertex_input.vertexBindingDescriptionCount);
+		for (u32 i = 0; i < vertex_input.vertexBindingDescriptionCount; i++)
+		{
+			appendKey(key, vertex_input.pVertexBindingDescriptions[i].binding);
+			appendKey(key, vertex_input.pVertexBindingDescriptions[i].stride);
+			appendKey(key, vertex_input.pVertexBindingDescriptions[i].inputRate);
+		}
+		appendKey(key, vertex_input.vertexAttributeDescriptionCount);
+		for (u32 i = 0; i < vertex_input.vertexAttributeDescriptionCount; i++)
+		{
+			appendKey(key, vertex_input.pVertexAttributeDescriptions[i].location);
+			appendKey(key, vertex_input.pVertexAttributeDescriptions[i].binding);
+			appendKey(key, vertex_input.pVertexAttributeDescriptions[i].format);
+			appendKey(key, vertex_input.pVertexAttributeDescriptions[i].offset);
+		}
+
+		appendKey(key, info.pInputAssemblyState->topology);
+		appendKey(key, info.pInputAssemblyState->primitiveRestartEnable);
+
+		const vk::PipelineRasterizationStateCreateInfo& rasterization = *info.pRasterizationState;
+		appendKey(key, rasterization.depthClampEnable);
+		appendKey(key, rasterization.rasterizerDiscardEnable);
+		appendKey(key, rasterization.polygonMode);
+		appendKey(key, (u32)rasterization.cullMode);
+		appendKey(key, rasterization.frontFace);
+		appendKey(key, rasterization.depthBiasEnable);
+		appendKey(key, rasterization.depthBiasConstantFactor);
+		appendKey(key, rasterization.depthBiasClamp);
+		appendKey(key, rasterization.depthBiasSlopeFactor);
+		appendKey(key, rasterization.lineWidth);
+
+		const vk::PipelineMultisampleStateCreateInfo& multisample = *info.pMultisampleState;
+		appendKey(key, multisample.rasterizationSamples);
+		appendKey(key, multisample.sampleShadingEnable);
+		appendKey(key, multisample.minSampleShading);
+		appendKey(key, multisample.alphaToCoverageEnable);
+		appendKey(key, multisample.alphaToOneEnable);
+
+		const vk::PipelineColorBlendStateCreateInfo& color_blend = *info.pColorBlendState;
+		appendKey(key, color_blend.logicOpEnable);
+		appendKey(key, color_blend.logicOp);
+		appendKey(key, color_blend.blendConstants);
+		appendKey(key, color_blend.attachmentCount);
+		for (u32 i = 0; i < color_blend.attachmentCount; i++)
+		{
+			const vk::PipelineColorBlendAttachmentState& attachment = color_blend.pAttachments[i];
+			appendKey(key, attachment.blendEnable);
+			appendKey(key, attachment.srcColorBlendFactor);
+			appendKey(key, attachment.dstColorBlendFactor);
+			appendKey(key, attachment.colorBlendOp);
+			appendKey(key, attachment.srcAlphaBlendFactor);
+			appendKey(key, attachment.dstAlphaBlendFactor);
+			appendKey(key, attachment.alphaBlendOp);
+			appendKey(key, (u32)attachment.colorWriteMask);
+		}
+
+		const vk::PipelineDepthStencilStateCreateInfo& depth_stencil = *info.pDepthStencilState;
+		appendKey(key, depth_stencil.depthTestEnable);
+		appendKey(key, depth_stencil.depthWriteEnable);
+		appendKey(key, depth_stencil.depthCompareOp);
+		appendKey(key, depth_stencil.depthBoundsTestEnable);
+		appendKey(key, depth_stencil.stencilTestEnable);
+		appendKey(key, depth_stencil.minDepthBounds);
+		appendKey(key, depth_stencil.maxDepthBounds);
+
+		appendKey(key, info.pDynamicState->dynamicStateCount);
+		appendKey(key, info.pDynamicState->pDynamicStates, info.pDynamicState->dynamicStateCount * sizeof(vk::DynamicState));
+
+		// layouts are deduplicated already, so their handles identify them
+		appendKey(key, (VkPipelineLayout)info.layout);
+		appendKey(key, (VkRenderPass)info.renderPass);
+		appendKey(key, info.subpass);
+
+		return key;
+	}
+
+	vk::Pipeline Internal::AcquireGraphicsPipeline(const vk::GraphicsPipelineCreateInfo& create_info)
+	{
+		return s_GraphicsPipelines.acquire(graphicsPipelineKey(create_info), [&](void)
+		{
+			vk::ResultValue<vk::Pipeline> pipeline = VkContext::GetLogicalDevice().createGraphicsPipeline(VkContext::GetPipelineCache(), create_info);
+			NA_VERIFY(pipeline.result == vk::Result::eSuccess, "Failed to create graphics pipeline: {}!", vk::to_string(pipeline.result));
+			return pipeline.value;
+		}, [](vk::Pipeline pipeline) { VkContext::GetLogicalDevice().destroyPipeline(pipeline); });
+	}
+
+	void Internal::ReleaseGraphicsPipeline(vk::Pipeline pipeline)
+	{
+		VkContext::GetLogicalDevice().destroyPipeline(s_GraphicsPipelines.release(pipeline));
+	}
+
+	vk::Pipeline Internal::AcquireComputePipeline(const vk::ComputePipelineCreateInfo& create_info)
+	{
+		std::string key;
+		appendKey(key, create_info.stage);
+		// layouts are deduplicated already, so their handles identify them
+		appendKey(key, (VkPipelineLayout)create_info.layout);
+
+		return s_ComputePipelines.acquire(std::move(key), [&](void)
+		{
+			vk::ResultValue<vk::Pipeline> pipeline = VkContext::GetLogicalDevice().createComputePipeline(VkContext::GetPipelineCache(), create_info);
+			NA_VERIFY(pipeline.result == vk::Result::eSuccess, "Failed to create compute pipeline: {}!", vk::to_string(pipeline.result));
+			return pipeline.value;
+		}, [](vk::Pipeline pipeline) { VkContext::GetLogicalDevice().destroyPipeline(pipeline); });
+	}
+
+	void Internal::ReleaseComputePipeline(vk::Pipeline pipeline)
+	{
+		VkContext::GetLogicalDevice().destroyPipeline(s_ComputePipelines.release(pipeline));
+	}
+} // namespace Na
@@ -0,0 +1,241 @@
+#include "Pch.hpp"
+#include "Natrium/Graphics/MipChain.hpp"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+	#include <emmintrin.h>
+	#define NA_MIP_CHAIN_SSE2
+#endif
+
+namespace Na {
+	u32 MipLevelCount(u32 width, u32 height)
+	{
+		return (u32)std::floor(std::log2(std::max(width, height))) + 1;
+	}
+
+	u64 MipChainSize(u32 width, u32 height, u32 level_count, u32 layer_count, u32 texel_size)
+	{
+		u64 size = 0;
+		for (u32 level = 0; level < level_count; level++)
+			size += (u64)MipExtent(width, level) * MipExtent(height, level) * layer_count * texel_size;
+		return size;
+	}
+
+	static float srgbToLinear(u8 value)
+	{
+		static const std::array<float, 256> x_Table = []()
+		{
+			std::array<float, 256> table;
+			for (u32 i = 0; i < 256; i++)
+			{
+				float c = i / 255.0f;
+				table[i] = c <= 0.04045f ? c / 12.92f : powf((c + 0.055f) / 1.055f, 2.4f);
+			}
+			return table;
+		}();
+		return x_Table[value];
+	}
+
+	static u8 linearToSrgb(float value)
+	{
+		// 4096 entries keep the round trip exact for every 8 bit value
+		static const std::array<u8, 4096> x_Table = []()
+		{
+			std::array<u8, 4096> table;
+			for (u32 i = 0; i < 4096; i++)
+			{
+				float l = i / 4095.0f;
+				float c = l <= 0.0031308f ? l * 12.92f : 1.055f * powf(l, 1.0f / 2.4f) - 0.055f;
+				table[i] = (u8)std::clamp(Round32(c * 255.0f), 0, 255);
+			}
+			return table;
+		}();
+		return x_Table[std::clamp(Round32(value * 4095.0f), 0, 4095)];
+	}
+
+	static void downsampleRowU8(
+		const u8* row0,
+		const u8* row1,
+		u8* dst,
+		u32 src_width,
+		u32 dst_width,
+		u32 channels
+	)
+	{
+		u32 x = 0;
+
+	#if defined(NA_MIP_CHAIN_SSE2)
+		// 4 channel images only, 2 destination texels (4 source texels per row) per iteration
+		if (channels == 4 && src_width >= 2)
+		{
+			const __m128i zero = _mm_setzero_si128();
+			const __m128i bias = _mm_set1_epi16(2);
+
+			for (; x + 2 <= dst_width && x * 2 + 4 <= src_width; x += 2)
+			{
+				__m128i a = _mm_loadu_si128((const __m128i*)(row0 + x * 8));
+				__m128i b = _mm_loadu_si128((const __m128i*)(row1 + x * 8));
+
+				__m128i a_lo = _mm_unpacklo_epi8(a, zero);
+				__m128i a_hi = _mm_unpackhi_epi8(a, zero);
+				__m128i b_lo = _mm_unpacklo_epi8(b, zero);
+				__m128i b_hi = _mm_unpackhi_epi8(b, zero);
+
+				// vertical sums, each 64 bit half holds one texel
+				__m128i lo = _mm_add_epi16(a_lo, b_lo);
+				__m128i hi = _mm_add_epi16(a_hi, b_hi);
+
+				// horizontal sums of neighbouring texels
+				__m128i lo_sum = _mm_add_epi16(lo, _mm_srli_si128(lo, 8));
+				__m128i hi_sum = _mm_add_epi16(hi, _mm_srli_si128(hi, 8));
+
+				__m128i sum = _mm_unpacklo_epi64(lo_sum, hi_sum);
+				sum = _mm_srli_epi16(_mm_add_epi16(sum, bias), 2);
+
+				__m128i packed = _mm_packus_epi16(sum, zero);
+				_mm_storel_epi64((__m128i*)(dst + x * 4), packed);
+			}
+		}
+	#endif
+
+		for (; x < dst_width; x++)
+		{
+			u32 x0 = std::min(x * 2, src_width - 1);
+			u32 x1 = std::min(x * 2 + 1, src_width - 1);
+
+			for (u32 c = 0; c < channels; c++)
+			{
+				u32 sum = (u32)row0[x0 * channels + c] + row0[x1 * channels + c]
+						+ row1[x0 * channels + c] + row1[x1 * channels + c];
+				dst[x * channels + c] = (u8)((sum + 2) / 4);
+			}
+		}
+	}
+
+	static void downsampleRowSrgb(
+		const u8* row0,
+		const u8* row1,
+		u8* dst,
+		u32 src_width,
+		u32 dst_width,
+		u32 channels
+	)
+	{
+		// grey + alpha or rgba, alpha is always stored linearly
+		u32 alpha = (channels == 2 || channels == 4) ? channels - 1 : UINT32_MAX;
+
+		for (u32 x = 0; x < dst_width; x++)
+		{
+			u32 x0 = std::min(x * 2, src_width - 1);
+			u32 x1 = std::min(x * 2 + 1, src_width - 1);
+
+			for (u32 c = 0; c < channels; c++)
+			{
+				if (c == alpha)
+				{
+					u32 sum = (u32)row0[x0 * channels + c] + row0[x1 * channels + c]
+							+ row1[x0 * channels + c] + row1[x1 * channels + c];
+					dst[x * channels + c] = (u8)((sum + 2) / 4);
+					continue;
+				}
+
+				float sum = srgbToLinear(row0[x0 * channels + c]) + srgbToLinear(row0[x1 * channels + c])
+						  + srgbToLinear(row1[x0 * channels + c]) + srgbToLinear(row1[x1 * channels + c]);
+				dst[x * channels + c] = linearToSrgb(sum * 0.25f);
+			}
+		}
+	}
+
+	static void downsampleRowU16(
+		const u16* row0,
+		const u16* row1,
+		u16* dst,
+		u32 src_width,
+		u32 dst_width,
+		u32 channels
+	)
+	{
+		for (u32 x = 0; x < dst_width; x++)
+		{
+			u32 x0 = std::min(x * 2, src_width - 1);
+			u32 x1 = std::min(x * 2 + 1, src_width - 1);
+
+			for (u32 c = 0; c < channels; c++)
+			{
+				u32 sum = (u32)row0[x0 * channels + c] + row0[x1 * channels + c]
+						+ row1[x0 * channels + c] + row1[x1 * channels + c];
+				dst[x * channels + c] = (u16)((sum + 2) / 4);
+			}
+		}
+	}
+
+	void DownsampleBox(
+		const Byte* src,
+		u32 src_width,
+		u32 src_height,
+		Byte* dst,
+		u32 channels,
+		u32 channel_size,
+		bool srgb
+	)
+	{
+		NA_ASSERT(channel_size == 1 || channel_size == 2, "Failed to downsample image: Unsupported channel size {}!", channel_size);
+
+		u32 dst_width = std::max(src_width / 2, 1u);
+		u32 dst_height = std::max(src_height / 2, 1u);
+
+		u64 src_pitch = (u64)src_width * channels * channel_size;
+		u64 dst_pitch = (u64)dst_width * channels * channel_size;
+
+		for (u32 y = 0; y < dst_height; y++)
+		{
+			const Byte* row0 = src + std::min(y * 2, src_height - 1) * src_pitch;
+			const Byte* row1 = src + std::min(y * 2 + 1, src_height - 1) * src_pitch;
+			Byte* dst_row = dst + y * dst_pitch;
+
+			if (channel_size == 2)
+				downsampleRowU16((const u16*)row0, (const u16*)row1, (u16*)dst_row, src_width, dst_width, channels);
+			else if (srgb)
+				downsampleRowSrgb(row0, row1, dst_row, src_width, dst_width, channels);
+			else
+				downsampleRowU8(row0, row1, dst_row, src_width, dst_width, channels);
+		}
+	}
+
+	void GenerateMipChain(
+		Byte* chain,
+		u32 width,
+		u32 height,
+		u32 level_count,
+		u32 layer_count,
+		u32 channels,
+		u32 channel_size,
+		bool srgb
+	)
+	{
+		u32 texel_size = channels * channel_size;
+
+		Byte* src_level = chain;
+		for (u32 level = 1; level < level_count; level++)
+		{
+			u32 src_width = MipExtent(width, level - 1);
+			u32 src_height = MipExtent(height, level - 1);
+			u64 src_layer_size = (u64)src_width * src_height * texel_size;
+
+			u64 dst_layer_size = (u64)MipExtent(width, level) * MipExtent(height, level) * texel_size;
+			Byte* dst_level = src_level + src_layer_size * layer_count;
+
+			for (u32 layer = 0; layer < layer_count; layer++)
+				DownsampleBox(
+					src_level + layer * src_layer_size,
+					src_width,
+					src_height,
+					dst_level + layer * dst_layer_size,
+					channels,
+					channel_size,
+					srgb
+				);
+
+			src_level = dst_level;
+		}
+	}
+} // namespace Na
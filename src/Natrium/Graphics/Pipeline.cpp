@@ -2,13 +2,25 @@
 #include "Natrium/Graphics/Pipeline.hpp"
 
 #include "Natrium/Graphics/VkContext.hpp"
+#include "Natrium/Graphics/ShaderModule.hpp"
+#include "Natrium/Graphics/ShaderReflection.hpp"
+
+#include "Natrium/Graphics/DescriptorAllocator.hpp"
+#include "Natrium/Graphics/BindlessTextures.hpp"
 
 #include "./PipelineStates.hpp"
 
 #include "Internal.hpp"
 #include "Natrium/Graphics/Buffers/UniformBuffer.hpp"
 #include "Natrium/Graphics/Buffers/StorageBuffer.hpp"
+#include "Natrium/Graphics/Buffers/TransientBuffer.hpp"
+#include "Natrium/Graphics/Buffers/IndirectBuffer.hpp"
 #include "Natrium/Graphics/Texture.hpp"
+#include "Natrium/Core/ParallelFor.hpp"
+#include "Natrium/Core/Logger.hpp"
+
+#include <mutex>
+#include <condition_variable>
 
 namespace Na {
 	static std::tuple<
@@ -54,273 +66,700 @@ namespace Na {
 		return { binding_descriptions, attribute_descriptions };
 	}
 
-	static vk::DescriptorSetLayout createDescriptorSetLayout(const ShaderUniformLayout& descriptor_layout)
+	static vk::DescriptorSetLayout acquireDescriptorSetLayout(const ShaderUniform* uniforms, u32 uniform_count)
 	{
-		Na::ArrayVector<vk::DescriptorSetLayoutBinding> bindings(descriptor_layout.size());
-		for (size_t i = 0; const auto& binding : descriptor_layout)
+		Na::ArrayVector<vk::DescriptorSetLayoutBinding> bindings(uniform_count);
+		for (u32 i = 0; i < uniform_count; i++)
 		{
-			bindings[i].binding            = binding.binding;
-			bindings[i].descriptorType     = (vk::DescriptorType)binding.type;
-			bindings[i].stageFlags         = (vk::ShaderStageFlagBits)binding.shader_stage;
+			bindings[i].binding            = uniforms[i].binding;
+			bindings[i].descriptorType     = (vk::DescriptorType)uniforms[i].type;
+			bindings[i].stageFlags         = (vk::ShaderStageFlagBits)uniforms[i].shader_stage;
 			bindings[i].descriptorCount    = 1;
 			bindings[i].pImmutableSamplers = nullptr;
+		}
 
-			i++;
+		return Internal::AcquireDescriptorSetLayout(bindings.ptr(), (u32)bindings.size());
+	}
+
+	// one entry of the packed data a set is written from, update templates read it with this stride
+	union DescriptorData {
+		vk::DescriptorImageInfo image;
+		vk::DescriptorBufferInfo buffer;
+
+		DescriptorData(void) : buffer() {}
+	};
+
+	static vk::WriteDescriptorSet descriptorWrite(vk::DescriptorSet set, u32 binding, vk::DescriptorType type, const DescriptorData& data)
+	{
+		vk::WriteDescriptorSet write;
+		write.dstSet = set;
+		write.dstBinding = binding;
+		write.dstArrayElement = 0;
+		write.descriptorCount = 1;
+		write.descriptorType = type;
+
+		if (type == vk::DescriptorType::eCombinedImageSampler || type == vk::DescriptorType::eStorageImage)
+			write.pImageInfo = &data.image;
+		else
+			write.pBufferInfo = &data.buffer;
+
+		return write;
+	}
+
+	// 1.0 devices fall back to batched writes
+	static vk::DescriptorUpdateTemplate createUpdateTemplate(vk::DescriptorSetLayout layout, const ShaderUniform* uniforms, u32 uniform_count)
+	{
+		if (VkContext::GetDeviceApiVersion() < VK_API_VERSION_1_1)
+			return nullptr;
+
+		Na::ArrayVector<vk::DescriptorUpdateTemplateEntry> entries(uniform_count);
+		for (u32 i = 0; i < uniform_count; i++)
+		{
+			entries[i].dstBinding      = uniforms[i].binding;
+			entries[i].dstArrayElement = 0;
+			entries[i].descriptorCount = 1;
+			entries[i].descriptorType  = (vk::DescriptorType)uniforms[i].type;
+			entries[i].offset          = i * sizeof(DescriptorData);
+			entries[i].stride          = sizeof(DescriptorData);
 		}
 
-		vk::DescriptorSetLayoutCreateInfo create_info;
-		create_info.bindingCount = (u32)bindings.size();
-		create_info.pBindings = bindings.ptr();
+		vk::DescriptorUpdateTemplateCreateInfo create_info;
+		create_info.descriptorUpdateEntryCount = uniform_count;
+		create_info.pDescriptorUpdateEntries = entries.ptr();
+		create_info.templateType = vk::DescriptorUpdateTemplateType::eDescriptorSet;
+		create_info.descriptorSetLayout = layout;
 
-		return VkContext::GetLogicalDevice().createDescriptorSetLayout(create_info);
+		return VkContext::GetLogicalDevice().createDescriptorUpdateTemplate(create_info);
 	}
 
-	static vk::DescriptorPool createDescriptorPool(const ShaderUniformLayout& descriptor_layout)
+	struct PipelineBuild {
+		template<typename... t_Args>
+		PipelineBuild(t_Args&&... args) : desc(std::forward<t_Args>(args)...) {}
+
+		GraphicsPipelineDesc desc;
+
+		std::mutex mutex; // held for the whole build
+		std::atomic<bool> done = false;
+		bool cancelled = false;
+
+		vk::Pipeline pipeline;
+		std::exception_ptr error;
+	};
+
+	static std::mutex s_CompileMutex;
+	static std::condition_variable s_CompileCondition;
+	static std::deque<std::shared_ptr<PipelineBuild>> s_CompileQueue;
+	static std::vector<std::thread> s_CompileWorkers;
+	static bool s_CompileStopping = false;
+
+	static void buildPipeline(PipelineBuild& build)
 	{
-		Na::ArrayVector<vk::DescriptorPoolSize> pool_sizes(descriptor_layout.size());
-		for (size_t i = 0; const ShaderUniform& uniform : descriptor_layout)
+		std::scoped_lock lock(build.mutex);
+		if (build.done || build.cancelled)
+			return;
+
+		try
 		{
-			pool_sizes[i].descriptorCount = 1; // 1 * uniform.count
-			pool_sizes[i].type = (vk::DescriptorType)uniform.type;
-			i++;
+			build.pipeline = Internal::AcquireGraphicsPipeline(build.desc.create_info);
+		} catch (const std::exception& e)
+		{
+			// skipping or falling back draws never wait on the build, so this is the only trace of it
+			g_Logger.fmt(Error, "Failed to build pipeline: {}", e.what());
+			build.error = std::current_exception();
+		} catch (...)
+		{
+			g_Logger.log(Error, "Failed to build pipeline: Unknown error!");
+			build.error = std::current_exception();
 		}
 
-		vk::DescriptorPoolCreateInfo create_info;
-		create_info.poolSizeCount = (u32)pool_sizes.size();
-		create_info.pPoolSizes = pool_sizes.ptr();
-		create_info.maxSets = 1; // 1 * uniform.count
+		build.done.store(true, std::memory_order_release);
+	}
+
+	static void compileWorker(void)
+	{
+		for (;;)
+		{
+			std::shared_ptr<PipelineBuild> build;
+			{
+				std::unique_lock lock(s_CompileMutex);
+				s_CompileCondition.wait(lock, [](void) { return s_CompileStopping || !s_CompileQueue.empty(); });
+				if (s_CompileStopping)
+					return;
+
+				build = std::move(s_CompileQueue.front());
+				s_CompileQueue.pop_front();
+			}
 
-		return VkContext::GetLogicalDevice().createDescriptorPool(create_info);
+			buildPipeline(*build);
+		}
 	}
 
-	static vk::DescriptorSet createDescriptorSet(vk::DescriptorSetLayout& layout, vk::DescriptorPool pool)
+	static void queuePipelineBuild(std::shared_ptr<PipelineBuild> build)
 	{
-		vk::DescriptorSet descriptor_set;
+		std::scoped_lock lock(s_CompileMutex);
 
-		vk::DescriptorSetAllocateInfo alloc_info;
-		alloc_info.descriptorPool = pool;
-		alloc_info.descriptorSetCount = 1;
-		alloc_info.pSetLayouts = &layout;
+		// started on first use, a few threads are enough to keep up without fighting the render thread
+		if (s_CompileWorkers.empty())
+		{
+			u32 worker_count = std::clamp(HardwareThreadCount() / 4, 1u, 4u);
+			for (u32 i = 0; i < worker_count; i++)
+				s_CompileWorkers.emplace_back(compileWorker);
+		}
 
-		vk::Result result = VkContext::GetLogicalDevice().allocateDescriptorSets(&alloc_info, &descriptor_set);
-		if (result != vk::Result::eSuccess)
-			throw std::runtime_error("Failed to allocate descriptor set!");
+		s_CompileQueue.push_back(std::move(build));
+		s_CompileCondition.notify_one();
+	}
 
-		return descriptor_set;
+	void Internal::ShutdownPipelineCompiler(void)
+	{
+		{
+			std::scoped_lock lock(s_CompileMutex);
+			s_CompileStopping = true;
+		}
+		s_CompileCondition.notify_all();
+
+		for (std::thread& worker : s_CompileWorkers)
+			worker.join();
+
+		s_CompileWorkers.clear();
+		s_CompileQueue.clear();
+		s_CompileStopping = false;
 	}
 
-	static Na::ArrayVector<vk::DescriptorSet> createDescriptorSets(u32 count, vk::DescriptorSetLayout* layouts, vk::DescriptorPool pool)
+	PipelineBase::PipelineBase(PipelineBase&& other)
+	: m_DescriptorLayout(std::exchange(other.m_DescriptorLayout, nullptr)),
+	m_Layout(std::exchange(other.m_Layout, nullptr)),
+
+	m_DescriptorAllocator(std::move(other.m_DescriptorAllocator)),
+	m_DescriptorSet(std::exchange(other.m_DescriptorSet, nullptr)),
+	m_Uniforms(std::move(other.m_Uniforms)),
+	m_UpdateTemplate(std::exchange(other.m_UpdateTemplate, nullptr)),
+
+	m_DynamicOffsets(std::move(other.m_DynamicOffsets)),
+	m_DynamicBindings(std::move(other.m_DynamicBindings)),
+	m_DynamicOffsetCount(other.m_DynamicOffsetCount),
+	m_DynamicOffsetIndex(other.m_DynamicOffsetIndex)
+	{}
+
+	PipelineBase& PipelineBase::operator=(PipelineBase&& other)
 	{
-		vk::DescriptorSetAllocateInfo alloc_info;
-		alloc_info.descriptorPool = pool;
-		alloc_info.descriptorSetCount = count;
-		alloc_info.pSetLayouts = layouts;
-
-		Na::ArrayVector<vk::DescriptorSet> descriptor_sets(count);
-		vk::Result result = VkContext::GetLogicalDevice().allocateDescriptorSets(&alloc_info, descriptor_sets.ptr());
-		if (result != vk::Result::eSuccess)
-			throw std::runtime_error("Failed to allocate descriptor sets!");
-		return descriptor_sets;
+		m_DescriptorLayout = std::exchange(other.m_DescriptorLayout, nullptr);
+		m_Layout = std::exchange(other.m_Layout, nullptr);
+
+		m_DescriptorAllocator = std::move(other.m_DescriptorAllocator);
+		m_DescriptorSet = std::exchange(other.m_DescriptorSet, nullptr);
+		m_Uniforms = std::move(other.m_Uniforms);
+		m_UpdateTemplate = std::exchange(other.m_UpdateTemplate, nullptr);
+
+		m_DynamicOffsets = std::move(other.m_DynamicOffsets);
+		m_DynamicBindings = std::move(other.m_DynamicBindings);
+		m_DynamicOffsetCount = other.m_DynamicOffsetCount;
+		m_DynamicOffsetIndex = other.m_DynamicOffsetIndex;
+
+		return *this;
 	}
 
-	GraphicsPipeline::GraphicsPipeline(
-		RendererCore& renderer_core,
-		const PipelineShaderInfos& shader_infos,
-		const ShaderAttributeLayout& vertex_buffer_layout,
-		const ShaderUniformLayout& uniform_data_layout,
-		const PushConstantLayout& push_constant_layout
+	void PipelineBase::_create_layout(
+		u32 max_frames_in_flight,
+		const ShaderUniform* uniforms,
+		u32 uniform_count,
+		const PushConstant* push_constants,
+		u32 push_constant_count,
+		vk::DescriptorSetLayout extra_set
 	)
 	{
-		for (const ShaderUniform& uniform : uniform_data_layout)
+		for (u32 i = 0; i < uniform_count; i++)
 		{
 			if (
-				uniform.type == ShaderUniformType::StorageBuffer ||
-				uniform.type == ShaderUniformType::UniformBuffer
+				uniforms[i].type == ShaderUniformType::StorageBuffer ||
+				uniforms[i].type == ShaderUniformType::UniformBuffer
 			)
+			{
 				m_DynamicOffsetCount++;
+				m_DynamicBindings.emplace(uniforms[i].binding);
+			}
 		}
-		m_DynamicOffsets.reallocate(u64(m_DynamicOffsetCount * renderer_core.settings().max_frames_in_flight));
+		m_DynamicOffsets.reallocate(u64(m_DynamicOffsetCount * max_frames_in_flight));
 		m_DynamicOffsets.resize(m_DynamicOffsets.capacity());
 
-		Na::ArrayVector<vk::DynamicState> dynamic_states = {
-			vk::DynamicState::eViewport,
-			vk::DynamicState::eScissor
-		};
-
-		auto [binding_descriptions, attribute_descriptions] = GetVertexInputInfo(vertex_buffer_layout);
-
-		vk::PipelineVertexInputStateCreateInfo vertex_input_info;
-		vertex_input_info.vertexAttributeDescriptionCount = (u32)attribute_descriptions.size();
-		vertex_input_info.pVertexAttributeDescriptions = attribute_descriptions.ptr();
-		vertex_input_info.vertexBindingDescriptionCount = (u32)binding_descriptions.size();
-		vertex_input_info.pVertexBindingDescriptions = binding_descriptions.ptr();
+		if (uniform_count)
+			m_DescriptorLayout = acquireDescriptorSetLayout(uniforms, uniform_count);
 
-		auto dynamic_state_info = dynamicStateInfo(dynamic_states);
-		auto viewport_info = viewportInfo();
-		auto input_assembly_info = inputAssemblyInfo();
-		auto rasterization_info = rasterizationInfo();
-		auto multisample_info = multisampleInfo(renderer_core.settings().msaa_enabled);
-		auto color_blend_attachment = colorBlendAttachment(false);
-		auto color_blend_info = colorBlendInfo(color_blend_attachment);
-		auto depth_stencil_info = depthStencilInfo();
+		Na::ArrayVector<vk::PushConstantRange> push_constant_ranges(push_constant_count);
 
-		if (uniform_data_layout.size())
-			m_DescriptorLayout = createDescriptorSetLayout(uniform_data_layout);
-
-		Na::ArrayVector<vk::PushConstantRange> push_constant_ranges(push_constant_layout.size());
+		for (u32 i = 0; i < push_constant_count; i++)
+		{
+			push_constant_ranges[i].stageFlags = (vk::ShaderStageFlagBits)push_constants[i].shader_stage;
+			push_constant_ranges[i].offset = push_constants[i].offset;
+			push_constant_ranges[i].size = push_constants[i].size;
+		}
 
-		for (u64 i = 0; const auto& push_constant : push_constant_layout)
+		vk::DescriptorSetLayout set_layouts[2] = { m_DescriptorLayout, extra_set };
+		u32 set_layout_count = (bool)m_DescriptorLayout;
+		if (extra_set)
 		{
-			push_constant_ranges[i].stageFlags = (vk::ShaderStageFlagBits)push_constant.shader_stage;
-			push_constant_ranges[i].offset = push_constant.offset;
-			push_constant_ranges[i].size = push_constant.size;
-			i++;
+			if (!m_DescriptorLayout)
+				m_DescriptorLayout = set_layouts[0] = Internal::AcquireDescriptorSetLayout(nullptr, 0);
+			set_layout_count = 2;
 		}
 
-		m_Layout = VkContext::GetLogicalDevice().createPipelineLayout(
-			vk::PipelineLayoutCreateInfo(
-				{}, // flags
-				(bool)m_DescriptorLayout, uniform_data_layout.size() ? &m_DescriptorLayout : nullptr,
-				(u32)push_constant_ranges.size(), push_constant_ranges.ptr()
-			)
+		m_Layout = Internal::AcquirePipelineLayout(
+			set_layouts, set_layout_count,
+			push_constant_ranges.ptr(), (u32)push_constant_ranges.size()
 		);
 
-		vk::GraphicsPipelineCreateInfo create_info;
-
-		create_info.stageCount = (u32)shader_infos.size();
-		create_info.pStages = shader_infos.begin();
+		if (uniform_count)
+		{
+			m_Uniforms = ArrayList<ShaderUniform>(uniforms, uniform_count);
+			m_UpdateTemplate = createUpdateTemplate(m_DescriptorLayout, uniforms, uniform_count);
 
-		create_info.renderPass = renderer_core.render_pass();
-		create_info.layout = m_Layout;
+			// the first pool only has room for the pipeline's own set, materials grow it
+			m_DescriptorAllocator = DescriptorAllocator(uniforms, uniform_count, 1);
+			m_DescriptorSet = m_DescriptorAllocator.allocate(m_DescriptorLayout);
+		}
+	}
 
-		create_info.pDynamicState = &dynamic_state_info;
-		create_info.pViewportState = &viewport_info;
-		create_info.pInputAssemblyState = &input_assembly_info;
-		create_info.pVertexInputState = &vertex_input_info;
-		create_info.pRasterizationState = &rasterization_info;
-		create_info.pMultisampleState = &multisample_info;
-		create_info.pColorBlendState = &color_blend_info;
-		create_info.pDepthStencilState = &depth_stencil_info;
+	void PipelineBase::_destroy_layout(void)
+	{
+		// defers destroying its pools itself
+		m_DescriptorAllocator.destroy();
+		m_DescriptorSet = nullptr;
 
-		m_Pipeline = VkContext::GetLogicalDevice().createGraphicsPipeline(nullptr, create_info).value;
+		// only read while writing sets, so it can go right away
+		if (m_UpdateTemplate)
+			VkContext::GetLogicalDevice().destroyDescriptorUpdateTemplate(std::exchange(m_UpdateTemplate, nullptr));
 
-		if (uniform_data_layout.size())
+		if (m_DescriptorLayout || m_Layout)
 		{
-			m_DescriptorPool = createDescriptorPool(uniform_data_layout);
-			m_DescriptorSet = createDescriptorSet(m_DescriptorLayout, m_DescriptorPool);
+			// layouts are shared, so they're only destroyed along with their last user
+			VkContext::DeferDestruction([
+				descriptor_layout = m_DescriptorLayout,
+				layout = m_Layout
+			](void)
+			{
+				Internal::ReleaseDescriptorSetLayout(descriptor_layout);
+				Internal::ReleasePipelineLayout(layout);
+			});
 		}
+		m_DescriptorLayout = nullptr;
+		m_Layout = nullptr;
+
+		m_Uniforms.~ArrayList();
+		m_DynamicOffsets.~ArrayList();
+		m_DynamicBindings.~ArrayList();
+		m_DynamicOffsetCount = 0;
+		m_DynamicOffsetIndex = 0;
 	}
 
-	void GraphicsPipeline::destroy(void)
+	vk::DescriptorSet PipelineBase::allocate_descriptor_set(void)
 	{
-		vk::Device logical_device = VkContext::GetLogicalDevice();
+		NA_ASSERT(m_DescriptorAllocator, "Failed to allocate descriptor set: Pipeline has no uniforms!");
+		return m_DescriptorAllocator.allocate(m_DescriptorLayout);
+	}
 
-		logical_device.destroyDescriptorPool(m_DescriptorPool);
-		logical_device.destroyPipeline(m_Pipeline);
-		logical_device.destroyDescriptorSetLayout(m_DescriptorLayout);
-		logical_device.destroyPipelineLayout(m_Layout);
+	void PipelineBase::_bind_uniform(vk::DescriptorSet set, u32 binding, UniformRef uniform)
+	{
+		DescriptorData data;
+		vk::DescriptorType type = this->_descriptor_data(binding, uniform, data);
 
-		m_DynamicOffsets.~ArrayList();
+		vk::WriteDescriptorSet write = descriptorWrite(set, binding, type, data);
+		Internal::WriteToDescriptorSets(&write, 1);
 	}
 
-	void GraphicsPipeline::_bind_uniform(u32 binding, const void* uniform)
+	void PipelineBase::_bind_uniforms(vk::DescriptorSet set, const UniformRef* uniforms, u32 count)
 	{
-		ShaderUniformType uniform_type = *(const ShaderUniformType*)uniform;
-		switch (uniform_type)
+		NA_ASSERT(count == m_Uniforms.size(), "Failed to bind uniforms to pipeline: Got {} uniforms for a layout of {}!", count, m_Uniforms.size());
+
+		Na::ArrayVector<DescriptorData> data(count);
+		for (u32 i = 0; i < count; i++)
 		{
-			case ShaderUniformType::Texture:
-			{
-				const Texture& texture = *(const Texture*)uniform;
-				vk::DescriptorImageInfo image_info;
-				image_info.imageLayout = vk::ImageLayout::eShaderReadOnlyOptimal;
-				image_info.imageView = texture.img_view();
-				image_info.sampler = texture.sampler();
-
-				Internal::WriteToDescriptorSet(
-					m_DescriptorSet,
-					binding,
-					vk::DescriptorType::eCombinedImageSampler,
-					1,
-					nullptr, // buffer info
-					&image_info,
-					nullptr // texel buffer view
-				);
+			vk::DescriptorType type = this->_descriptor_data(m_Uniforms[i].binding, uniforms[i], data[i]);
+			NA_ASSERT(type == (vk::DescriptorType)m_Uniforms[i].type, "Failed to bind uniforms to pipeline: Uniform {} doesn't match the type of binding {}!", i, m_Uniforms[i].binding);
+		}
 
+		if (m_UpdateTemplate)
+		{
+			VkContext::GetLogicalDevice().updateDescriptorSetWithTemplate(set, m_UpdateTemplate, data.ptr());
+			return;
+		}
+
+		Na::ArrayVector<vk::WriteDescriptorSet> writes(count);
+		for (u32 i = 0; i < count; i++)
+			writes[i] = descriptorWrite(set, m_Uniforms[i].binding, (vk::DescriptorType)m_Uniforms[i].type, data[i]);
+		Internal::WriteToDescriptorSets(writes.ptr(), count);
+	}
+
+	vk::DescriptorType PipelineBase::_descriptor_data(u32 binding, UniformRef uniform, DescriptorData& data)
+	{
+		vk::DescriptorType type;
+		u64 frame_stride;
+		switch (uniform.kind)
+		{
+			case UniformRef::Transient:
+			{
+				const TransientBuffer& buffer = *(const TransientBuffer*)uniform.uniform;
+				data.buffer = vk::DescriptorBufferInfo(buffer.buffer().buffer, 0, buffer.range());
+				type = (vk::DescriptorType)buffer.type();
+				frame_stride = buffer.per_frame_capacity();
 				break;
 			}
-			case ShaderUniformType::UniformBuffer:
+			case UniformRef::Indirect:
 			{
-				const UniformBuffer& uniform_buffer = *(const UniformBuffer*)uniform;
-				vk::DescriptorBufferInfo buffer_info(uniform_buffer.buffer().buffer, 0, uniform_buffer.aligned_size());
-
-				Internal::WriteToDescriptorSet(
-					m_DescriptorSet,
-					binding,
-					vk::DescriptorType::eUniformBufferDynamic,
-					1, // count
-					&buffer_info,
-					nullptr, // image info
-					nullptr // texel buffer view
-				);
-
-				for (u64 i = m_DynamicOffsetIndex++; i < m_DynamicOffsets.size(); i += m_DynamicOffsetCount)
-					m_DynamicOffsets[i] = u32(uniform_buffer.aligned_size() * i);
-
+				const IndirectBuffer& buffer = *(const IndirectBuffer*)uniform.uniform;
+				data.buffer = vk::DescriptorBufferInfo(buffer.buffer().buffer, 0, buffer.frame_size());
+				type = vk::DescriptorType::eStorageBufferDynamic;
+				frame_stride = buffer.frame_stride();
 				break;
 			}
-			case ShaderUniformType::StorageBuffer:
+			case UniformRef::Image:
 			{
-				const StorageBuffer& storage_buffer = *(const StorageBuffer*)uniform;
-				vk::DescriptorBufferInfo buffer_info(storage_buffer.buffer().buffer, 0, storage_buffer.aligned_size());
-
-				Internal::WriteToDescriptorSet(
-					m_DescriptorSet,
-					binding,
-					vk::DescriptorType::eStorageBufferDynamic,
-					1, // count
-					&buffer_info,
-					nullptr, // image info
-					nullptr // texel buffer view
+				const ImageUniform& image = *(const ImageUniform*)uniform.uniform;
+				NA_ASSERT(
+					image.type == ShaderUniformType::Texture || image.type == ShaderUniformType::StorageImage,
+					"Failed to bind uniform to pipeline: An ImageUniform has to be a Texture or a StorageImage!"
 				);
-
-				for (u64 i = m_DynamicOffsetIndex++; i < m_DynamicOffsets.size(); i += m_DynamicOffsetCount)
-					m_DynamicOffsets[i] = u32(storage_buffer.aligned_size() * i);
-
+				data.image = vk::DescriptorImageInfo(image.sampler, image.view, image.layout);
+				return (vk::DescriptorType)image.type;
+			}
+			case UniformRef::Tagged:
+			{
+				switch (*(const ShaderUniformType*)uniform.uniform)
+				{
+					case ShaderUniformType::Texture:
+					{
+						const Texture& texture = *(const Texture*)uniform.uniform;
+						data.image = vk::DescriptorImageInfo(texture.sampler(), texture.img_view(), vk::ImageLayout::eShaderReadOnlyOptimal);
+						return vk::DescriptorType::eCombinedImageSampler;
+					}
+					case ShaderUniformType::UniformBuffer:
+					{
+						const UniformBuffer& uniform_buffer = *(const UniformBuffer*)uniform.uniform;
+						data.buffer = vk::DescriptorBufferInfo(uniform_buffer.buffer().buffer, 0, uniform_buffer.aligned_size());
+						type = vk::DescriptorType::eUniformBufferDynamic;
+						frame_stride = uniform_buffer.aligned_size();
+						break;
+					}
+					case ShaderUniformType::StorageBuffer:
+					{
+						const StorageBuffer& storage_buffer = *(const StorageBuffer*)uniform.uniform;
+						data.buffer = vk::DescriptorBufferInfo(storage_buffer.buffer().buffer, 0, storage_buffer.aligned_size());
+						type = vk::DescriptorType::eStorageBufferDynamic;
+						frame_stride = storage_buffer.aligned_size();
+						break;
+					}
+					default:
+						throw std::runtime_error("Failed to bind uniform to pipeline: Uniform object of unknown descriptor type!");
+				}
 				break;
 			}
-			default:
-				throw std::runtime_error("Failed to bind uniform to pipeline: Uniform object of unknown descriptor type!");
 		}
+
+		// every frame in flight reads its own part of the buffer
+		u32 slot = this->dynamic_offset_slot(binding);
+		NA_ASSERT(slot < m_DynamicOffsetCount, "Failed to bind uniform to pipeline: Binding {} isn't a buffer uniform!", binding);
+
+		for (u64 i = slot; i < m_DynamicOffsets.size(); i += m_DynamicOffsetCount)
+			m_DynamicOffsets[i] = u32(frame_stride * (i / m_DynamicOffsetCount));
+		m_DynamicOffsetIndex++;
+
+		return type;
 	}
 
-	GraphicsPipeline::GraphicsPipeline(GraphicsPipeline&& other)
-	: m_Pipeline(std::exchange(other.m_Pipeline, nullptr)),
+	u32 PipelineBase::dynamic_offset_slot(u32 binding) const
+	{
+		for (u32 slot = 0; slot < m_DynamicOffsetCount; slot++)
+			if (m_DynamicBindings[slot] == binding)
+				return slot;
+		return m_DynamicOffsetCount;
+	}
 
-	m_DescriptorLayout(std::exchange(other.m_DescriptorLayout, nullptr)),
-	m_Layout(std::exchange(other.m_Layout, nullptr)),
+	GraphicsPipeline::GraphicsPipeline(
+		RendererCore& renderer_core,
+		const PipelineShaderInfos& shader_infos,
+		const ShaderAttributeLayout& vertex_buffer_layout,
+		const ShaderUniformLayout& uniform_data_layout,
+		const PushConstantLayout& push_constant_layout,
+		const PipelineState& state,
+		PipelineCompileMode compile_mode
+	)
+	: m_State(state)
+	{
+		auto [binding_descriptions, attribute_descriptions] = GetVertexInputInfo(vertex_buffer_layout);
 
-	m_DescriptorPool(std::exchange(other.m_DescriptorPool, nullptr)),
-	m_DescriptorSet(std::exchange(other.m_DescriptorSet, nullptr)),
-	m_DynamicOffsets(std::move(other.m_DynamicOffsets)),
-	m_DynamicOffsetCount(other.m_DynamicOffsetCount),
-	m_DynamicOffsetIndex(other.m_DynamicOffsetIndex)
+		vk::PipelineVertexInputStateCreateInfo vertex_input_info;
+		vertex_input_info.vertexAttributeDescriptionCount = (u32)attribute_descriptions.size();
+		vertex_input_info.pVertexAttributeDescriptions = attribute_descriptions.ptr();
+		vertex_input_info.vertexBindingDescriptionCount = (u32)binding_descriptions.size();
+		vertex_input_info.pVertexBindingDescriptions = binding_descriptions.ptr();
+
+		this->_create(
+			renderer_core,
+			shader_infos.begin(), (u32)shader_infos.size(),
+			vertex_input_info,
+			uniform_data_layout.begin(), (u32)uniform_data_layout.size(),
+			push_constant_layout.begin(), (u32)push_constant_layout.size(),
+			compile_mode
+		);
+	}
+
+	GraphicsPipeline::GraphicsPipeline(
+		RendererCore& renderer_core,
+		const PipelineShaderModules& modules,
+		const PipelineState& state,
+		PipelineCompileMode compile_mode
+	)
+	: m_State(state)
+	{
+		Na::ArrayVector<const ShaderReflection*> reflections(modules.size());
+		Na::ArrayVector<vk::PipelineShaderStageCreateInfo> shader_infos(modules.size());
+		for (u64 i = 0; const ShaderModule& module : modules)
+		{
+			reflections[i] = &module.reflection();
+			shader_infos[i] = module.pipeline_shader_info();
+			i++;
+		}
+
+		ShaderReflection reflection = MergeReflections(reflections.ptr(), (u32)reflections.size());
+		NA_ASSERT(reflection.valid(), "Failed to create GraphicsPipeline from reflection: {}!", reflection.error);
+		m_State.bindless_textures |= reflection.bindless_textures;
+
+		// every vertex input is assumed to come from one tightly packed per-vertex buffer
+		Na::ArrayVector<vk::VertexInputAttributeDescription> attribute_descriptions(reflection.attributes.size());
+		u32 stride = 0;
+		for (u64 i = 0; i < attribute_descriptions.size(); i++)
+		{
+			attribute_descriptions[i].binding = 0;
+			attribute_descriptions[i].location = reflection.attributes[i].location;
+			attribute_descriptions[i].format = (vk::Format)reflection.attributes[i].type;
+			attribute_descriptions[i].offset = stride;
+
+			stride += SizeOf(reflection.attributes[i].type);
+		}
+
+		vk::VertexInputBindingDescription binding_description(0, stride, vk::VertexInputRate::eVertex);
+
+		vk::PipelineVertexInputStateCreateInfo vertex_input_info;
+		vertex_input_info.vertexAttributeDescriptionCount = (u32)attribute_descriptions.size();
+		vertex_input_info.pVertexAttributeDescriptions = attribute_descriptions.ptr();
+		vertex_input_info.vertexBindingDescriptionCount = stride ? 1 : 0;
+		vertex_input_info.pVertexBindingDescriptions = &binding_description;
+
+		this->_create(
+			renderer_core,
+			shader_infos.ptr(), (u32)shader_infos.size(),
+			vertex_input_info,
+			reflection.uniforms.data(), (u32)reflection.uniforms.size(),
+			reflection.push_constants.data(), (u32)reflection.push_constants.size(),
+			compile_mode
+		);
+	}
+
+	void GraphicsPipeline::_create(
+		RendererCore& renderer_core,
+		const vk::PipelineShaderStageCreateInfo* shader_infos,
+		u32 shader_info_count,
+		const vk::PipelineVertexInputStateCreateInfo& vertex_input_info,
+		const ShaderUniform* uniforms,
+		u32 uniform_count,
+		const PushConstant* push_constants,
+		u32 push_constant_count,
+		PipelineCompileMode compile_mode
+	)
+	{
+		// the texture table is set 1
+		vk::DescriptorSetLayout bindless_layout = nullptr;
+		if (m_State.bindless_textures)
+		{
+			NA_VERIFY(BindlessTextures::Supported(), "Failed to create GraphicsPipeline: Bindless textures aren't supported by the device!");
+			bindless_layout = BindlessTextures::GetLayout();
+		}
+
+		this->_create_layout(
+			renderer_core.settings().max_frames_in_flight,
+			uniforms, uniform_count,
+			push_constants, push_constant_count,
+			bindless_layout
+		);
+
+		if (compile_mode == PipelineCompileMode::Background)
+		{
+			m_Build = std::make_shared<PipelineBuild>(
+				shader_infos, shader_info_count,
+				vertex_input_info,
+				this->layout(), renderer_core.render_pass(),
+				renderer_core.settings().msaa_enabled,
+				m_State
+			);
+			queuePipelineBuild(m_Build);
+		} else
+		{
+			GraphicsPipelineDesc desc(
+				shader_infos, shader_info_count,
+				vertex_input_info,
+				this->layout(), renderer_core.render_pass(),
+				renderer_core.settings().msaa_enabled,
+				m_State
+			);
+			m_Pipeline = Internal::AcquireGraphicsPipeline(desc.create_info);
+		}
+	}
+
+	void GraphicsPipeline::destroy(void)
+	{
+		vk::Pipeline built_pipeline = nullptr;
+		if (m_Build)
+		{
+			// waits out a build that's already running, one that's still queued is just dropped
+			std::scoped_lock lock(m_Build->mutex);
+			m_Build->cancelled = true;
+			built_pipeline = std::exchange(m_Build->pipeline, nullptr);
+		}
+		m_Build.reset();
+
+		if (built_pipeline || m_Pipeline)
+		{
+			// pipelines are shared, so they're only destroyed along with their last user
+			VkContext::DeferDestruction([built_pipeline, pipeline = m_Pipeline](void)
+			{
+				Internal::ReleaseGraphicsPipeline(built_pipeline);
+				Internal::ReleaseGraphicsPipeline(pipeline);
+			});
+		}
+		m_Pipeline = nullptr;
+
+		this->_destroy_layout();
+	}
+
+	vk::Pipeline GraphicsPipeline::pipeline(void) const
+	{
+		if (!m_Build)
+			return m_Pipeline;
+
+		return m_Build->done.load(std::memory_order_acquire) ? m_Build->pipeline : nullptr;
+	}
+
+	bool GraphicsPipeline::failed(void) const
+	{
+		return m_Build && m_Build->done.load(std::memory_order_acquire) && m_Build->error;
+	}
+
+	void GraphicsPipeline::wait(void) const
+	{
+		if (!m_Build)
+			return;
+
+		buildPipeline(*m_Build);
+		if (m_Build->error)
+			std::rethrow_exception(m_Build->error);
+	}
+
+	GraphicsPipeline::GraphicsPipeline(GraphicsPipeline&& other)
+	: PipelineBase(std::move(other)),
+	m_Pipeline(std::exchange(other.m_Pipeline, nullptr)),
+	m_Build(std::move(other.m_Build)),
+	m_State(other.m_State)
 	{}
 
 	GraphicsPipeline& GraphicsPipeline::operator=(GraphicsPipeline&& other)
 	{
 		this->destroy();
+		PipelineBase::operator=(std::move(other));
 
 		m_Pipeline = std::exchange(other.m_Pipeline, nullptr);
+		m_Build = std::move(other.m_Build);
+		m_State = other.m_State;
 
-		m_DescriptorLayout = std::exchange(other.m_DescriptorLayout, nullptr);
-		m_Layout = std::exchange(other.m_Layout, nullptr);
+		return *this;
+	}
 
-		m_DescriptorPool = std::exchange(other.m_DescriptorPool, nullptr);
-		m_DescriptorSet = std::exchange(other.m_DescriptorSet, nullptr);
+	ComputePipeline::ComputePipeline(
+		const RendererSettings& renderer_settings,
+		const vk::PipelineShaderStageCreateInfo& shader_info,
+		const ShaderUniformLayout& uniform_data_layout,
+		const PushConstantLayout& push_constant_layout,
+		bool bindless_textures
+	)
+	{
+		this->_create(
+			renderer_settings,
+			shader_info,
+			uniform_data_layout.begin(), (u32)uniform_data_layout.size(),
+			push_constant_layout.begin(), (u32)push_constant_layout.size(),
+			bindless_textures
+		);
+	}
 
-		m_DynamicOffsets = std::move(other.m_DynamicOffsets);
-		m_DynamicOffsetCount = other.m_DynamicOffsetCount;
-		m_DynamicOffsetIndex = other.m_DynamicOffsetIndex;
+	ComputePipeline::ComputePipeline(const RendererSettings& renderer_settings, const ShaderModule& module)
+	{
+		const ShaderReflection& reflection = module.reflection();
+		NA_ASSERT(reflection.valid(), "Failed to create ComputePipeline from reflection: {}!", reflection.error);
+		NA_ASSERT(reflection.stage == ShaderStageBits::Compute, "Failed to create ComputePipeline: Module isn't a compute shader!");
+
+		this->_create(
+			renderer_settings,
+			module.pipeline_shader_info(),
+			reflection.uniforms.data(), (u32)reflection.uniforms.size(),
+			reflection.push_constants.data(), (u32)reflection.push_constants.size(),
+			reflection.bindless_textures
+		);
+	}
+
+	void ComputePipeline::_create(
+		const RendererSettings& renderer_settings,
+		const vk::PipelineShaderStageCreateInfo& shader_info,
+		const ShaderUniform* uniforms,
+		u32 uniform_count,
+		const PushConstant* push_constants,
+		u32 push_constant_count,
+		bool bindless_textures
+	)
+	{
+		// the texture table is set 1, like for graphics pipelines
+		vk::DescriptorSetLayout bindless_layout = nullptr;
+		if (bindless_textures)
+		{
+			NA_VERIFY(BindlessTextures::Supported(), "Failed to create ComputePipeline: Bindless textures aren't supported by the device!");
+			bindless_layout = BindlessTextures::GetLayout();
+		}
+		m_BindlessTextures = bindless_textures;
+
+		this->_create_layout(
+			renderer_settings.max_frames_in_flight,
+			uniforms, uniform_count,
+			push_constants, push_constant_count,
+			bindless_layout
+		);
+
+		vk::ComputePipelineCreateInfo create_info;
+		create_info.stage = shader_info;
+		create_info.layout = this->layout();
+
+		m_Pipeline = Internal::AcquireComputePipeline(create_info);
+	}
+
+	void ComputePipeline::destroy(void)
+	{
+		// shared like graphics pipelines
+		if (m_Pipeline)
+			VkContext::DeferDestruction([pipeline = m_Pipeline](void) { Internal::ReleaseComputePipeline(pipeline); });
+		m_Pipeline = nullptr;
+
+		this->_destroy_layout();
+	}
+
+	ComputePipeline::ComputePipeline(ComputePipeline&& other)
+	: PipelineBase(std::move(other)),
+	m_Pipeline(std::exchange(other.m_Pipeline, nullptr)),
+	m_BindlessTextures(other.m_BindlessTextures)
+	{}
+
+	ComputePipeline& ComputePipeline::operator=(ComputePipeline&& other)
+	{
+		this->destroy();
+		PipelineBase::operator=(std::move(other));
+
+		m_Pipeline = std::exchange(other.m_Pipeline, nullptr);
+		m_BindlessTextures = other.m_BindlessTextures;
 
 		return *this;
 	}
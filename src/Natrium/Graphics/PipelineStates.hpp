@@ -18,15 +18,15 @@ namespace Na {
 		return viewport_state_info;
 	}
 
-	static vk::PipelineInputAssemblyStateCreateInfo inputAssemblyInfo(void)
+	static vk::PipelineInputAssemblyStateCreateInfo inputAssemblyInfo(PrimitiveTopology topology)
 	{
 		vk::PipelineInputAssemblyStateCreateInfo input_assembly_info;
-		input_assembly_info.topology = vk::PrimitiveTopology::eTriangleList;
+		input_assembly_info.topology = (vk::PrimitiveTopology)topology;
 		input_assembly_info.primitiveRestartEnable = VK_FALSE;
 		return input_assembly_info;
 	}
 
-	static vk::PipelineRasterizationStateCreateInfo rasterizationInfo(void)
+	static vk::PipelineRasterizationStateCreateInfo rasterizationInfo(CullMode cull_mode)
 	{
 		vk::PipelineRasterizationStateCreateInfo rasterization_info;
 
@@ -36,7 +36,7 @@ namespace Na {
 		rasterization_info.polygonMode = vk::PolygonMode::eFill;
 		rasterization_info.lineWidth = 1.0f;
 
-		rasterization_info.cullMode = vk::CullModeFlagBits::eBack;
+		rasterization_info.cullMode = (vk::CullModeFlagBits)cull_mode;
 		rasterization_info.frontFace = vk::FrontFace::eCounterClockwise;
 
 		rasterization_info.depthBiasEnable = VK_FALSE;
@@ -47,14 +47,15 @@ namespace Na {
 		return rasterization_info;
 	}
 
-	static vk::PipelineMultisampleStateCreateInfo multisampleInfo(bool enabled)
+	static vk::PipelineMultisampleStateCreateInfo multisampleInfo(bool enabled, float min_sample_shading)
 	{
 		vk::PipelineMultisampleStateCreateInfo multisample_info;
 
 		multisample_info.rasterizationSamples = VkContext::GetMSAASamples(enabled);
 
-		multisample_info.sampleShadingEnable = VK_TRUE;
-		multisample_info.minSampleShading = 0.2f;
+		// without msaa there's only one sample to shade anyway
+		multisample_info.sampleShadingEnable = enabled && min_sample_shading > 0.0f;
+		multisample_info.minSampleShading = multisample_info.sampleShadingEnable ? min_sample_shading : 0.0f;
 
 		multisample_info.pSampleMask = nullptr;
 		multisample_info.alphaToCoverageEnable = VK_FALSE;
@@ -62,7 +63,7 @@ namespace Na {
 		return multisample_info;
 	}
 
-	static vk::PipelineColorBlendAttachmentState colorBlendAttachment(bool enabled)
+	static vk::PipelineColorBlendAttachmentState colorBlendAttachment(BlendMode blend_mode)
 	{
 		vk::PipelineColorBlendAttachmentState color_blend_attachment;
 		color_blend_attachment.colorWriteMask =
@@ -75,16 +76,24 @@ namespace Na {
 		color_blend_attachment.dstAlphaBlendFactor = vk::BlendFactor::eZero;
 		color_blend_attachment.alphaBlendOp = vk::BlendOp::eAdd;
 
-		if ((color_blend_attachment.blendEnable = enabled))
+		color_blend_attachment.colorBlendOp = vk::BlendOp::eAdd;
+		switch (blend_mode)
 		{
+		case BlendMode::Alpha:
+			color_blend_attachment.blendEnable = VK_TRUE;
 			color_blend_attachment.srcColorBlendFactor = vk::BlendFactor::eSrcAlpha;
 			color_blend_attachment.dstColorBlendFactor = vk::BlendFactor::eOneMinusSrcAlpha;
-			color_blend_attachment.colorBlendOp = vk::BlendOp::eAdd;
-		} else
-		{
+			break;
+		case BlendMode::Additive:
+			color_blend_attachment.blendEnable = VK_TRUE;
+			color_blend_attachment.srcColorBlendFactor = vk::BlendFactor::eSrcAlpha;
+			color_blend_attachment.dstColorBlendFactor = vk::BlendFactor::eOne;
+			break;
+		default:
+			color_blend_attachment.blendEnable = VK_FALSE;
 			color_blend_attachment.srcColorBlendFactor = vk::BlendFactor::eOne;
 			color_blend_attachment.dstColorBlendFactor = vk::BlendFactor::eZero;
-			color_blend_attachment.colorBlendOp = vk::BlendOp::eAdd;
+			break;
 		}
 
 		return color_blend_attachment;
@@ -104,15 +113,111 @@ namespace Na {
 		return color_blend_info;
 	}
 
-	static vk::PipelineDepthStencilStateCreateInfo depthStencilInfo(void)
+	static vk::PipelineDepthStencilStateCreateInfo depthStencilInfo(bool depth_test, bool depth_write)
 	{
 		vk::PipelineDepthStencilStateCreateInfo depth_stencil_info;
-		depth_stencil_info.depthTestEnable = VK_TRUE;
-		depth_stencil_info.depthWriteEnable = VK_TRUE;
+		depth_stencil_info.depthTestEnable = depth_test;
+		depth_stencil_info.depthWriteEnable = depth_test && depth_write;
 		depth_stencil_info.depthCompareOp = vk::CompareOp::eLess;
 		depth_stencil_info.minDepthBounds = 0.0f;
 		depth_stencil_info.maxDepthBounds = 1.0f;
 		depth_stencil_info.stencilTestEnable = VK_FALSE;
 		return depth_stencil_info;
 	}
-} // namespace Na
+
+	///
+	/// owns everything vk::GraphicsPipelineCreateInfo points to, so the pipeline can still be built after the
+	/// caller's arrays are gone, the vk::ShaderModules themselves are only referenced
+	///
+	struct GraphicsPipelineDesc {
+		std::vector<vk::PipelineShaderStageCreateInfo> stages;
+		std::vector<std::string> entry_points;
+		std::vector<vk::SpecializationInfo> specializations;
+		std::vector<std::vector<vk::SpecializationMapEntry>> specialization_entries;
+		std::vector<std::vector<Byte>> specialization_data;
+
+		std::vector<vk::VertexInputBindingDescription> vertex_bindings;
+		std::vector<vk::VertexInputAttributeDescription> vertex_attributes;
+		vk::PipelineVertexInputStateCreateInfo vertex_input_info;
+
+		Na::ArrayVector<vk::DynamicState> dynamic_states = {
+			vk::DynamicState::eViewport,
+			vk::DynamicState::eScissor
+		};
+
+		vk::PipelineDynamicStateCreateInfo dynamic_state_info = dynamicStateInfo(dynamic_states);
+		vk::PipelineViewportStateCreateInfo viewport_info = viewportInfo();
+		vk::PipelineInputAssemblyStateCreateInfo input_assembly_info;
+		vk::PipelineRasterizationStateCreateInfo rasterization_info;
+		vk::PipelineMultisampleStateCreateInfo multisample_info;
+		vk::PipelineColorBlendAttachmentState color_blend_attachment;
+		vk::PipelineColorBlendStateCreateInfo color_blend_info;
+		vk::PipelineDepthStencilStateCreateInfo depth_stencil_info;
+
+		vk::GraphicsPipelineCreateInfo create_info;
+
+		GraphicsPipelineDesc(
+			const vk::PipelineShaderStageCreateInfo* shader_infos,
+			u32 shader_info_count,
+			const vk::PipelineVertexInputStateCreateInfo& vertex_input,
+			vk::PipelineLayout layout,
+			vk::RenderPass render_pass,
+			bool msaa_enabled,
+			const PipelineState& state
+		)
+		: stages(shader_infos, shader_infos + shader_info_count),
+		vertex_bindings(vertex_input.pVertexBindingDescriptions, vertex_input.pVertexBindingDescriptions + vertex_input.vertexBindingDescriptionCount),
+		vertex_attributes(vertex_input.pVertexAttributeDescriptions, vertex_input.pVertexAttributeDescriptions + vertex_input.vertexAttributeDescriptionCount),
+		vertex_input_info(vertex_input),
+		input_assembly_info(inputAssemblyInfo(state.topology)),
+		rasterization_info(rasterizationInfo(state.cull_mode)),
+		multisample_info(multisampleInfo(msaa_enabled, state.min_sample_shading)),
+		color_blend_attachment(colorBlendAttachment(state.blend_mode)),
+		color_blend_info(colorBlendInfo(color_blend_attachment)),
+		depth_stencil_info(depthStencilInfo(state.depth_test, state.depth_write))
+		{
+			// reserved up front, the create infos point into these
+			entry_points.reserve(shader_info_count);
+			specializations.reserve(shader_info_count);
+			specialization_entries.reserve(shader_info_count);
+			specialization_data.reserve(shader_info_count);
+
+			for (vk::PipelineShaderStageCreateInfo& stage : stages)
+			{
+				stage.pName = entry_points.emplace_back(stage.pName).c_str();
+				if (!stage.pSpecializationInfo)
+					continue;
+
+				const vk::SpecializationInfo& specialization = *stage.pSpecializationInfo;
+				const auto& entries = specialization_entries.emplace_back(
+					specialization.pMapEntries, specialization.pMapEntries + specialization.mapEntryCount
+				);
+				const auto& data = specialization_data.emplace_back(
+					(const Byte*)specialization.pData, (const Byte*)specialization.pData + specialization.dataSize
+				);
+				stage.pSpecializationInfo = &specializations.emplace_back((u32)entries.size(), entries.data(), data.size(), data.data());
+			}
+
+			vertex_input_info.pVertexBindingDescriptions = vertex_bindings.data();
+			vertex_input_info.pVertexAttributeDescriptions = vertex_attributes.data();
+
+			create_info.stageCount = (u32)stages.size();
+			create_info.pStages = stages.data();
+
+			create_info.renderPass = render_pass;
+			create_info.layout = layout;
+
+			create_info.pDynamicState = &dynamic_state_info;
+			create_info.pViewportState = &viewport_info;
+			create_info.pInputAssemblyState = &input_assembly_info;
+			create_info.pVertexInputState = &vertex_input_info;
+			create_info.pRasterizationState = &rasterization_info;
+			create_info.pMultisampleState = &multisample_info;
+			create_info.pColorBlendState = &color_blend_info;
+			create_info.pDepthStencilState = &depth_stencil_info;
+		}
+
+		GraphicsPipelineDesc(const GraphicsPipelineDesc& other) = delete;
+		GraphicsPipelineDesc& operator=(const GraphicsPipelineDesc& other) = delete;
+	};
+} // namespace Na
\ No newline at end of file
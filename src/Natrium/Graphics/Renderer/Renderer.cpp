@@ -3,8 +3,11 @@
 
 #include "Natrium/Graphics/VkContext.hpp"
 #include "Natrium/Graphics/Pipeline.hpp"
+#include "Natrium/Graphics/BindlessTextures.hpp"
 #include "Natrium/Core/Logger.hpp"
 
+#include "Internal.hpp"
+
 namespace Na {
 	Renderer::Renderer(RendererCore& renderer_core)
 	: m_Core(&renderer_core)
@@ -14,6 +17,17 @@ namespace Na {
 
 		this->_create_command_objects();
 		this->_create_sync_objects();
+
+		// a frame that needs more sets grows its allocator once
+		const FrameDescriptorSizes& sizes = renderer_core.m_Settings.frame_descriptors;
+		std::array<vk::DescriptorPoolSize, 4> pool_sizes = {
+			vk::DescriptorPoolSize((vk::DescriptorType)ShaderUniformType::UniformBuffer, sizes.uniform_buffers),
+			vk::DescriptorPoolSize((vk::DescriptorType)ShaderUniformType::StorageBuffer, sizes.storage_buffers),
+			vk::DescriptorPoolSize((vk::DescriptorType)ShaderUniformType::Texture, sizes.textures),
+			vk::DescriptorPoolSize((vk::DescriptorType)ShaderUniformType::StorageImage, sizes.storage_images)
+		};
+		for (FrameData& fd : m_Frames)
+			fd.descriptors = new DescriptorAllocator(pool_sizes.data(), (u32)pool_sizes.size(), sizes.set_count);
 	}
 
 	void Renderer::destroy(void)
@@ -22,6 +36,8 @@ namespace Na {
 
 		for (FrameData& fd : m_Frames)
 		{
+			delete std::exchange(fd.descriptors, nullptr);
+
 			logical_device.destroyFence(fd.in_flight_fence);
 
 			logical_device.destroySemaphore(fd.image_available_semaphore);
@@ -39,6 +55,7 @@ namespace Na {
 		FrameData& fd = m_Frames[m_FrameIndex];
 
 		fd.valid = true;
+		m_SkipDraws = false;
 
 		if (m_Core->m_Width  != m_Core->m_Window->width() ||
 			m_Core->m_Height != m_Core->m_Window->height())
@@ -61,6 +78,16 @@ namespace Na {
 				m_FrameIndex,
 				m_ImageIndex
 		);
+
+		Internal::RetireDeferredDestructions(fd.serial);
+		m_FrameNumber++;
+		m_BoundPipeline = nullptr;
+		m_BoundSet = nullptr;
+		m_BoundVertexBuffer = nullptr;
+		m_BoundIndexBuffer = nullptr;
+
+		// the frame's fence has signaled, nothing reads its sets anymore
+		fd.descriptors->reset();
 		
 		result = logical_device.acquireNextImageKHR(
 			m_Core->m_Swapchain,
@@ -97,8 +124,24 @@ namespace Na {
 		vk::CommandBufferBeginInfo begin_info;
 		fd.cmd_buffer.begin(begin_info);
 
+		fd.cmd_buffer.setViewport(0, 1, &m_Core->m_Viewport);
+		fd.cmd_buffer.setScissor(0, 1, &m_Core->m_Scissor);
+
+		// dispatches can't be recorded inside the render pass, so it's begun by the first draw
+		m_ClearColor = color;
+		m_InRenderPass = false;
+		m_DepthAcquired = false;
+
+		return true;
+	}
+
+	void Renderer::_begin_render_pass(void)
+	{
+		if (m_InRenderPass)
+			return;
+
 		std::array<vk::ClearValue, 2> clear_values;
-		clear_values[0].color = std::array<float, 4>{ color.r, color.g, color.g, color.a };
+		clear_values[0].color = std::array<float, 4>{ m_ClearColor.r, m_ClearColor.g, m_ClearColor.b, m_ClearColor.a };
 		clear_values[1].depthStencil = { { 1.0f, 0 } };
 
 		vk::RenderPassBeginInfo render_pass_info;
@@ -112,12 +155,8 @@ namespace Na {
 		render_pass_info.clearValueCount = (u32)clear_values.size();
 		render_pass_info.pClearValues = clear_values.data();
 
-		fd.cmd_buffer.beginRenderPass(render_pass_info, vk::SubpassContents::eInline);
-
-		fd.cmd_buffer.setViewport(0, 1, &m_Core->m_Viewport);
-		fd.cmd_buffer.setScissor(0, 1, &m_Core->m_Scissor);
-
-		return true;
+		m_Frames[m_FrameIndex].cmd_buffer.beginRenderPass(render_pass_info, vk::SubpassContents::eInline);
+		m_InRenderPass = true;
 	}
 
 	void Renderer::end_frame(void)
@@ -127,7 +166,10 @@ namespace Na {
 
 		vk::Result result = vk::Result::eSuccess;
 
+		// still clears and presents a frame nothing was drawn in
+		this->_begin_render_pass();
 		fd.cmd_buffer.endRenderPass();
+		m_InRenderPass = false;
 		fd.cmd_buffer.end();
 
 		vk::SubmitInfo submit_info;
@@ -154,6 +196,10 @@ namespace Na {
 				m_FrameIndex,
 				m_ImageIndex
 		);
+		fd.serial = Internal::AdvanceFrameSerial();
+
+		// what the next frame's acquire_previous_depth reads, unless the swapchain is recreated in between
+		m_DepthGeneration = m_Core->m_DepthGeneration;
 
 		vk::PresentInfoKHR present_info;
 		present_info.waitSemaphoreCount = submit_info.waitSemaphoreCount;
@@ -191,28 +237,157 @@ namespace Na {
 
 	void Renderer::bind_pipeline(const GraphicsPipeline& pipeline)
 	{
-		vk::Device logical_device = VkContext::GetLogicalDevice();
 		FrameData& fd = m_Frames[m_FrameIndex];
 
-		fd.cmd_buffer.bindPipeline(vk::PipelineBindPoint::eGraphics, pipeline.pipeline());
+		const GraphicsPipeline* bound = &pipeline;
+		if (!pipeline.ready())
+		{
+			// a failed build never becomes ready, so its draws would silently vanish
+			if (pipeline.failed())
+				pipeline.wait();
+
+			switch (m_PendingPipelineMode)
+			{
+			case PendingPipelineMode::Wait:
+				pipeline.wait();
+				break;
+			case PendingPipelineMode::Fallback:
+				if (m_FallbackPipeline && m_FallbackPipeline->ready())
+				{
+					bound = m_FallbackPipeline;
+					break;
+				}
+				[[fallthrough]];
+			case PendingPipelineMode::Skip:
+				m_SkipDraws = true;
+				m_BoundPipeline = nullptr;
+				m_BindPoint = vk::PipelineBindPoint::eGraphics;
+				return;
+			}
+		}
+		m_SkipDraws = false;
+
+		fd.cmd_buffer.bindPipeline(vk::PipelineBindPoint::eGraphics, bound->pipeline());
+		this->_bind_pipeline_set(*bound, vk::PipelineBindPoint::eGraphics);
 
-		if (pipeline.descriptor_set())
+		if (bound->state().bindless_textures)
+		{
+			vk::DescriptorSet texture_set = BindlessTextures::GetSet();
 			fd.cmd_buffer.bindDescriptorSets(
 				vk::PipelineBindPoint::eGraphics,
+				bound->layout(),
+				BindlessTextures::k_Set,
+				1, &texture_set,
+				0, nullptr // dynamic offsets
+			);
+		}
+	}
+
+	void Renderer::bind_pipeline(const ComputePipeline& pipeline)
+	{
+		FrameData& fd = m_Frames[m_FrameIndex];
+
+		fd.cmd_buffer.bindPipeline(vk::PipelineBindPoint::eCompute, pipeline.pipeline());
+		this->_bind_pipeline_set(pipeline, vk::PipelineBindPoint::eCompute);
+
+		if (pipeline.bindless_textures())
+		{
+			vk::DescriptorSet texture_set = BindlessTextures::GetSet();
+			fd.cmd_buffer.bindDescriptorSets(
+				vk::PipelineBindPoint::eCompute,
+				pipeline.layout(),
+				BindlessTextures::k_Set,
+				1, &texture_set,
+				0, nullptr // dynamic offsets
+			);
+		}
+	}
+
+	void Renderer::_bind_pipeline_set(const PipelineBase& pipeline, vk::PipelineBindPoint bind_point)
+	{
+		u32 offset_count = pipeline.dynamic_offset_count();
+		NA_ASSERT(offset_count <= k_MaxBoundDynamicOffsets, "Failed to bind pipeline: More than {} dynamic offsets!", k_MaxBoundDynamicOffsets);
+
+		// kept around so set_transient_uniform can rebind with one of them changed
+		m_BoundPipeline = &pipeline;
+		m_BindPoint = bind_point;
+		m_BoundSet = pipeline.descriptor_set();
+		if (offset_count)
+			memcpy(m_BoundOffsets.data(), pipeline.dynamic_offsets().ptr() + (m_FrameIndex * offset_count), offset_count * sizeof(u32));
+
+		if (m_BoundSet)
+			m_Frames[m_FrameIndex].cmd_buffer.bindDescriptorSets(
+				bind_point,
 				pipeline.layout(),
 				0, // first set
-				1, &pipeline.descriptor_set(),
-				pipeline.dynamic_offset_count(), pipeline.dynamic_offsets().ptr() + (m_FrameIndex * pipeline.dynamic_offset_count())
+				1, &m_BoundSet,
+				offset_count, m_BoundOffsets.data()
 			);
 	}
 
+	void Renderer::set_transient_uniform(u32 binding, const TransientAllocation& allocation)
+	{
+		if (m_SkipDraws && m_BindPoint == vk::PipelineBindPoint::eGraphics)
+			return;
+
+		NA_ASSERT(m_BoundPipeline, "Failed to set transient uniform: No pipeline is bound!");
+
+		u32 slot = m_BoundPipeline->dynamic_offset_slot(binding);
+		NA_ASSERT(slot < m_BoundPipeline->dynamic_offset_count(), "Failed to set transient uniform: Binding {} isn't a buffer uniform!", binding);
+
+		m_BoundOffsets[slot] = allocation.offset;
+
+		m_Frames[m_FrameIndex].cmd_buffer.bindDescriptorSets(
+			m_BindPoint,
+			m_BoundPipeline->layout(),
+			0, // first set
+			1, &m_BoundSet,
+			m_BoundPipeline->dynamic_offset_count(), m_BoundOffsets.data()
+		);
+	}
+
+	void Renderer::bind_descriptor_set(vk::DescriptorSet set)
+	{
+		if (m_SkipDraws && m_BindPoint == vk::PipelineBindPoint::eGraphics)
+			return;
+
+		NA_ASSERT(m_BoundPipeline, "Failed to bind descriptor set: No pipeline is bound!");
+
+		m_BoundSet = set;
+
+		m_Frames[m_FrameIndex].cmd_buffer.bindDescriptorSets(
+			m_BindPoint,
+			m_BoundPipeline->layout(),
+			0, // first set
+			1, &m_BoundSet,
+			m_BoundPipeline->dynamic_offset_count(), m_BoundOffsets.data()
+		);
+	}
+
+	vk::DescriptorSet Renderer::allocate_frame_descriptor_set(const PipelineBase& pipeline)
+	{
+		NA_ASSERT(pipeline.descriptor_layout(), "Failed to allocate frame descriptor set: Pipeline has no uniforms!");
+		return m_Frames[m_FrameIndex].descriptors->allocate(pipeline.descriptor_layout());
+	}
+
+	void Renderer::set_pending_pipeline_mode(PendingPipelineMode mode, const GraphicsPipeline* fallback)
+	{
+		NA_ASSERT(mode != PendingPipelineMode::Fallback || fallback, "Failed to set pending pipeline mode: Fallback mode needs a fallback pipeline!");
+
+		m_PendingPipelineMode = mode;
+		m_FallbackPipeline = fallback;
+	}
+
 	void Renderer::set_push_constant(
 		const PushConstant& push_constant,
 		const void* data,
-		const GraphicsPipeline& pipeline
+		const PipelineBase& pipeline
 	)
 	{
-		vk::Device logical_device = VkContext::GetLogicalDevice();
+		// a compute pipeline bound after a skipped graphics one still gets its constants
+		if (m_SkipDraws && &pipeline != m_BoundPipeline)
+			return;
+
 		FrameData& fd = m_Frames[m_FrameIndex];
 
 		fd.cmd_buffer.pushConstants(
@@ -226,9 +401,18 @@ namespace Na {
 
 	void Renderer::draw_vertices(const VertexBuffer& vertex_buffer, u32 vertex_count, u32 instance_count)
 	{
+		if (m_SkipDraws)
+			return;
+
+		this->_begin_render_pass();
+
 		FrameData& fd = m_Frames[m_FrameIndex];
 
-		fd.cmd_buffer.bindVertexBuffers(0, { vertex_buffer.native() }, { 0 });
+		if (vertex_buffer.native() != m_BoundVertexBuffer)
+		{
+			m_BoundVertexBuffer = vertex_buffer.native();
+			fd.cmd_buffer.bindVertexBuffers(0, { m_BoundVertexBuffer }, { 0 });
+		}
 
 		fd.cmd_buffer.draw(
 			vertex_count,
@@ -240,10 +424,23 @@ namespace Na {
 
 	void Renderer::draw_indexed(const VertexBuffer& vertex_buffer, const IndexBuffer& index_buffer, u32 instance_count)
 	{
+		if (m_SkipDraws)
+			return;
+
+		this->_begin_render_pass();
+
 		FrameData& fd = m_Frames[m_FrameIndex];
 
-		fd.cmd_buffer.bindVertexBuffers(0, { vertex_buffer.native() }, { 0 });
-		fd.cmd_buffer.bindIndexBuffer(index_buffer.native(), 0, vk::IndexType::eUint32);
+		if (vertex_buffer.native() != m_BoundVertexBuffer)
+		{
+			m_BoundVertexBuffer = vertex_buffer.native();
+			fd.cmd_buffer.bindVertexBuffers(0, { m_BoundVertexBuffer }, { 0 });
+		}
+		if (index_buffer.native() != m_BoundIndexBuffer)
+		{
+			m_BoundIndexBuffer = index_buffer.native();
+			fd.cmd_buffer.bindIndexBuffer(m_BoundIndexBuffer, 0, vk::IndexType::eUint32);
+		}
 
 		fd.cmd_buffer.drawIndexed(
 			index_buffer.count(),
@@ -254,6 +451,251 @@ namespace Na {
 		);
 	}
 
+	void Renderer::bind_geometry(const GeometryArena& arena)
+	{
+		FrameData& fd = m_Frames[m_FrameIndex];
+
+		if (arena.vertex_buffer().buffer != m_BoundVertexBuffer)
+		{
+			m_BoundVertexBuffer = arena.vertex_buffer().buffer;
+			fd.cmd_buffer.bindVertexBuffers(0, { m_BoundVertexBuffer }, { 0 });
+		}
+		if (arena.index_buffer().buffer != m_BoundIndexBuffer)
+		{
+			m_BoundIndexBuffer = arena.index_buffer().buffer;
+			fd.cmd_buffer.bindIndexBuffer(m_BoundIndexBuffer, 0, vk::IndexType::eUint32);
+		}
+	}
+
+	void Renderer::draw_geometry(const GeometryRange& range, u32 instance_count, u32 first_instance)
+	{
+		if (m_SkipDraws)
+			return;
+
+		this->_begin_render_pass();
+
+		NA_ASSERT(m_BoundIndexBuffer, "Failed to draw geometry: No GeometryArena is bound!");
+
+		m_Frames[m_FrameIndex].cmd_buffer.drawIndexed(
+			range.index_count,
+			instance_count,
+			range.first_index,
+			range.vertex_offset,
+			first_instance
+		);
+	}
+
+	void Renderer::draw_indexed_indirect(const IndirectBuffer& buffer, u32 draw_count, u32 first_draw)
+	{
+		if (m_SkipDraws || !draw_count)
+			return;
+
+		this->_begin_render_pass();
+
+		NA_ASSERT(first_draw + draw_count <= buffer.max_draws(), "Failed to draw indirect: Draws {} to {} are past the buffer's {}!", first_draw, first_draw + draw_count, buffer.max_draws());
+
+		vk::CommandBuffer cmd_buffer = m_Frames[m_FrameIndex].cmd_buffer;
+		vk::DeviceSize offset = buffer.frame_offset(m_FrameIndex) + IndirectBuffer::k_CommandsOffset + IndirectBuffer::k_CommandStride * first_draw;
+
+		if (VkContext::IsMultiDrawIndirectSupported())
+		{
+			cmd_buffer.drawIndexedIndirect(buffer.buffer().buffer, offset, draw_count, (u32)IndirectBuffer::k_CommandStride);
+			return;
+		}
+
+		// still saves building the draws on the cpu, just not the calls
+		for (u32 i = 0; i < draw_count; i++)
+			cmd_buffer.drawIndexedIndirect(buffer.buffer().buffer, offset + IndirectBuffer::k_CommandStride * i, 1, (u32)IndirectBuffer::k_CommandStride);
+	}
+
+	void Renderer::draw_indexed_indirect_count(const IndirectBuffer& buffer, u32 max_draw_count)
+	{
+		if (m_SkipDraws || !max_draw_count)
+			return;
+
+		this->_begin_render_pass();
+
+		PFN_vkCmdDrawIndexedIndirectCountKHR draw_indexed_indirect_count = VkContext::GetCmdDrawIndexedIndirectCount();
+		if (!draw_indexed_indirect_count)
+		{
+			this->draw_indexed_indirect(buffer, max_draw_count);
+			return;
+		}
+
+		NA_ASSERT(max_draw_count <= buffer.max_draws(), "Failed to draw indirect: {} draws are past the buffer's {}!", max_draw_count, buffer.max_draws());
+
+		vk::DeviceSize region = buffer.frame_offset(m_FrameIndex);
+		draw_indexed_indirect_count(
+			m_Frames[m_FrameIndex].cmd_buffer,
+			buffer.buffer().buffer,
+			region + IndirectBuffer::k_CommandsOffset,
+			buffer.buffer().buffer,
+			region, // count
+			max_draw_count,
+			(u32)IndirectBuffer::k_CommandStride
+		);
+	}
+
+	void Renderer::dispatch(u32 group_count_x, u32 group_count_y, u32 group_count_z)
+	{
+		NA_ASSERT(!m_InRenderPass, "Failed to dispatch: Compute work has to be recorded before the frame's first draw!");
+		NA_ASSERT(m_BoundPipeline && m_BindPoint == vk::PipelineBindPoint::eCompute, "Failed to dispatch: No compute pipeline is bound!");
+
+		m_Frames[m_FrameIndex].cmd_buffer.dispatch(group_count_x, group_count_y, group_count_z);
+	}
+
+	void Renderer::dispatch_indirect(const DeviceBuffer& buffer, vk::DeviceSize offset)
+	{
+		NA_ASSERT(!m_InRenderPass, "Failed to dispatch: Compute work has to be recorded before the frame's first draw!");
+		NA_ASSERT(m_BoundPipeline && m_BindPoint == vk::PipelineBindPoint::eCompute, "Failed to dispatch: No compute pipeline is bound!");
+
+		m_Frames[m_FrameIndex].cmd_buffer.dispatchIndirect(buffer.buffer, offset);
+	}
+
+	static void computeOutputDst(ComputeOutputUse use, vk::PipelineStageFlags& stages, vk::AccessFlags& access)
+	{
+		switch (use)
+		{
+		case ComputeOutputUse::Compute:
+			stages = vk::PipelineStageFlagBits::eComputeShader;
+			access = vk::AccessFlagBits::eShaderRead | vk::AccessFlagBits::eShaderWrite;
+			break;
+		case ComputeOutputUse::Indirect:
+			stages = vk::PipelineStageFlagBits::eDrawIndirect;
+			access = vk::AccessFlagBits::eIndirectCommandRead;
+			break;
+		case ComputeOutputUse::Vertex:
+			stages = vk::PipelineStageFlagBits::eVertexInput;
+			access = vk::AccessFlagBits::eVertexAttributeRead | vk::AccessFlagBits::eIndexRead;
+			break;
+		case ComputeOutputUse::Shader:
+			stages = vk::PipelineStageFlagBits::eVertexShader | vk::PipelineStageFlagBits::eFragmentShader;
+			access = vk::AccessFlagBits::eShaderRead | vk::AccessFlagBits::eUniformRead;
+			break;
+		}
+	}
+
+	void Renderer::compute_barrier(const DeviceBuffer& buffer, ComputeOutputUse use, vk::DeviceSize offset, vk::DeviceSize size)
+	{
+		NA_ASSERT(!m_InRenderPass, "Failed to record compute barrier: Compute work has to be recorded before the frame's first draw!");
+
+		vk::PipelineStageFlags dst_stages;
+		vk::AccessFlags dst_access;
+		computeOutputDst(use, dst_stages, dst_access);
+
+		vk::BufferMemoryBarrier barrier;
+		barrier.srcAccessMask = vk::AccessFlagBits::eShaderWrite;
+		barrier.dstAccessMask = dst_access;
+		barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.buffer = buffer.buffer;
+		barrier.offset = offset;
+		barrier.size = size;
+
+		m_Frames[m_FrameIndex].cmd_buffer.pipelineBarrier(
+			vk::PipelineStageFlagBits::eComputeShader, dst_stages,
+			{}, // dependency flags
+			0, nullptr, // memory barriers
+			1, &barrier,
+			0, nullptr // image barriers
+		);
+	}
+
+	void Renderer::compute_barrier(const DeviceImage& image, vk::ImageLayout old_layout, vk::ImageLayout new_layout, ComputeOutputUse use)
+	{
+		NA_ASSERT(!m_InRenderPass, "Failed to record compute barrier: Compute work has to be recorded before the frame's first draw!");
+		NA_ASSERT(use == ComputeOutputUse::Compute || use == ComputeOutputUse::Shader, "Failed to record compute barrier: Images can only be read by shaders!");
+
+		vk::PipelineStageFlags dst_stages;
+		vk::AccessFlags dst_access;
+		computeOutputDst(use, dst_stages, dst_access);
+
+		vk::ImageMemoryBarrier barrier;
+		barrier.srcAccessMask = vk::AccessFlagBits::eShaderWrite;
+		barrier.dstAccessMask = dst_access;
+		barrier.oldLayout = old_layout;
+		barrier.newLayout = new_layout;
+		barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.image = image.img;
+		barrier.subresourceRange = image.subresource_range;
+
+		m_Frames[m_FrameIndex].cmd_buffer.pipelineBarrier(
+			vk::PipelineStageFlagBits::eComputeShader, dst_stages,
+			{}, // dependency flags
+			0, nullptr, // memory barriers
+			0, nullptr, // buffer barriers
+			1, &barrier
+		);
+	}
+
+	void Renderer::fill_buffer(const DeviceBuffer& buffer, vk::DeviceSize offset, vk::DeviceSize size, u32 value, ComputeOutputUse use)
+	{
+		NA_ASSERT(!m_InRenderPass, "Failed to fill buffer: Transfers have to be recorded before the frame's first draw!");
+
+		vk::CommandBuffer cmd_buffer = m_Frames[m_FrameIndex].cmd_buffer;
+		cmd_buffer.fillBuffer(buffer.buffer, offset, size, value);
+
+		vk::PipelineStageFlags dst_stages;
+		vk::AccessFlags dst_access;
+		computeOutputDst(use, dst_stages, dst_access);
+
+		vk::BufferMemoryBarrier barrier;
+		barrier.srcAccessMask = vk::AccessFlagBits::eTransferWrite;
+		barrier.dstAccessMask = dst_access;
+		barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.buffer = buffer.buffer;
+		barrier.offset = offset;
+		barrier.size = size;
+
+		cmd_buffer.pipelineBarrier(
+			vk::PipelineStageFlagBits::eTransfer, dst_stages,
+			{}, // dependency flags
+			0, nullptr, // memory barriers
+			1, &barrier,
+			0, nullptr // image barriers
+		);
+	}
+
+	bool Renderer::acquire_previous_depth(void)
+	{
+		NA_ASSERT(!m_InRenderPass, "Failed to acquire previous depth: Compute work has to be recorded before the frame's first draw!");
+		NA_VERIFY(m_Core->settings().keep_depth_for_culling, "Failed to acquire previous depth: RendererSettings::keep_depth_for_culling is off!");
+
+		if (m_DepthAcquired)
+			return true;
+		if (m_DepthGeneration != m_Core->m_DepthGeneration)
+			return false;
+
+		const DeviceImage& depth = m_Core->m_DepthImage;
+
+		vk::ImageMemoryBarrier barrier;
+		barrier.srcAccessMask = vk::AccessFlagBits::eDepthStencilAttachmentWrite;
+		barrier.dstAccessMask = vk::AccessFlagBits::eShaderRead;
+		barrier.oldLayout = vk::ImageLayout::eDepthStencilAttachmentOptimal;
+		barrier.newLayout = vk::ImageLayout::eShaderReadOnlyOptimal;
+		barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.image = depth.img;
+		barrier.subresourceRange = depth.subresource_range;
+
+		// layouts of combined formats can only change for both aspects at once
+		if (depth.format != vk::Format::eD32Sfloat)
+			barrier.subresourceRange.aspectMask |= vk::ImageAspectFlagBits::eStencil;
+
+		m_Frames[m_FrameIndex].cmd_buffer.pipelineBarrier(
+			vk::PipelineStageFlagBits::eLateFragmentTests, vk::PipelineStageFlagBits::eComputeShader,
+			{}, // dependency flags
+			0, nullptr, // memory barriers
+			0, nullptr, // buffer barriers
+			1, &barrier
+		);
+
+		m_DepthAcquired = true;
+		return true;
+	}
+
 	void Renderer::set_descriptor_buffer(void* buffer, const void* data) const
 	{
 		NA_ASSERT(buffer, "Failed to set descriptor buffer: buffer is null!");
@@ -327,7 +769,21 @@ namespace Na {
 	m_GraphicsCmdPool(std::exchange(other.m_GraphicsCmdPool, nullptr)),
 	m_Frames(std::move(other.m_Frames)),
 	m_FrameIndex(other.m_FrameIndex),
-	m_ImageIndex(other.m_ImageIndex)
+	m_FrameNumber(other.m_FrameNumber),
+	m_ImageIndex(other.m_ImageIndex),
+	m_PendingPipelineMode(other.m_PendingPipelineMode),
+	m_FallbackPipeline(std::exchange(other.m_FallbackPipeline, nullptr)),
+	m_SkipDraws(other.m_SkipDraws),
+	m_BoundPipeline(std::exchange(other.m_BoundPipeline, nullptr)),
+	m_BindPoint(other.m_BindPoint),
+	m_BoundSet(std::exchange(other.m_BoundSet, nullptr)),
+	m_BoundOffsets(other.m_BoundOffsets),
+	m_BoundVertexBuffer(std::exchange(other.m_BoundVertexBuffer, nullptr)),
+	m_BoundIndexBuffer(std::exchange(other.m_BoundIndexBuffer, nullptr)),
+	m_ClearColor(other.m_ClearColor),
+	m_InRenderPass(std::exchange(other.m_InRenderPass, false)),
+	m_DepthGeneration(other.m_DepthGeneration),
+	m_DepthAcquired(other.m_DepthAcquired)
 	{}
 
 	Renderer& Renderer::operator=(Renderer&& other)
@@ -338,8 +794,24 @@ namespace Na {
 		m_GraphicsCmdPool = std::exchange(other.m_GraphicsCmdPool, nullptr);
 		m_Frames = std::move(other.m_Frames);
 		m_FrameIndex = other.m_FrameIndex;
+		m_FrameNumber = other.m_FrameNumber;
 		m_ImageIndex = other.m_ImageIndex;
 
+		m_PendingPipelineMode = other.m_PendingPipelineMode;
+		m_FallbackPipeline = std::exchange(other.m_FallbackPipeline, nullptr);
+		m_SkipDraws = other.m_SkipDraws;
+
+		m_BoundPipeline = std::exchange(other.m_BoundPipeline, nullptr);
+		m_BindPoint = other.m_BindPoint;
+		m_BoundSet = std::exchange(other.m_BoundSet, nullptr);
+		m_BoundOffsets = other.m_BoundOffsets;
+		m_BoundVertexBuffer = std::exchange(other.m_BoundVertexBuffer, nullptr);
+		m_BoundIndexBuffer = std::exchange(other.m_BoundIndexBuffer, nullptr);
+		m_ClearColor = other.m_ClearColor;
+		m_InRenderPass = std::exchange(other.m_InRenderPass, false);
+		m_DepthGeneration = other.m_DepthGeneration;
+		m_DepthAcquired = other.m_DepthAcquired;
+
 		return *this;
 	}
 } // namespace Na
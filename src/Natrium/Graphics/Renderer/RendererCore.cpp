@@ -44,6 +44,20 @@ namespace Na {
 		};
 	}
 
+	// the render pass and the depth buffer have to agree on it
+	static vk::Format depthFormat(bool sampled)
+	{
+		vk::FormatFeatureFlags features = vk::FormatFeatureFlagBits::eDepthStencilAttachment;
+		if (sampled)
+			features |= vk::FormatFeatureFlagBits::eSampledImage;
+
+		return FindSupportedFormat(
+			{ vk::Format::eD32Sfloat, vk::Format::eD32SfloatS8Uint, vk::Format::eD24UnormS8Uint },
+			vk::ImageTiling::eOptimal,
+			features
+		);
+	}
+
 	RendererCore::RendererCore(Window& window, const RendererSettings& settings)
 	: m_Window(&window),
 	m_Settings(settings)
@@ -185,11 +199,12 @@ namespace Na {
 
 	void RendererCore::_create_depth_buffer(void)
 	{
-		vk::Format depth_format = FindSupportedFormat(
-			{ vk::Format::eD32Sfloat, vk::Format::eD32SfloatS8Uint, vk::Format::eD24UnormS8Uint },
-			vk::ImageTiling::eOptimal,
-			vk::FormatFeatureFlagBits::eDepthStencilAttachment
-		);
+		vk::Format depth_format = depthFormat(m_Settings.keep_depth_for_culling);
+
+		// sampled by the next frame's compute work, e.g. to build a DepthPyramid
+		vk::ImageUsageFlags depth_usage = vk::ImageUsageFlagBits::eDepthStencilAttachment;
+		if (m_Settings.keep_depth_for_culling)
+			depth_usage |= vk::ImageUsageFlagBits::eSampled;
 
 		m_DepthImage = DeviceImage(
 			{ m_Width, m_Height, 1 },
@@ -197,7 +212,7 @@ namespace Na {
 			vk::ImageAspectFlagBits::eDepth,
 			depth_format,
 			vk::ImageTiling::eOptimal,
-			vk::ImageUsageFlagBits::eDepthStencilAttachment,
+			depth_usage,
 			vk::SharingMode::eExclusive,
 			VkContext::GetMSAASamples(m_Settings.msaa_enabled),
 			vk::MemoryPropertyFlagBits::eDeviceLocal
@@ -208,6 +223,7 @@ namespace Na {
 			depth_format,
 			1 // layer count
 		);
+		m_DepthGeneration++;
 	}
 
 	void RendererCore::_create_render_pass(void)
@@ -215,11 +231,7 @@ namespace Na {
 		std::array<vk::AttachmentDescription, 3> attachments{};
 		attachments.fill({});
 
-		vk::Format depth_format = FindSupportedFormat(
-			{ vk::Format::eD32Sfloat, vk::Format::eD32SfloatS8Uint, vk::Format::eD24UnormS8Uint },
-			vk::ImageTiling::eOptimal,
-			vk::FormatFeatureFlagBits::eDepthStencilAttachment
-		);
+		vk::Format depth_format = depthFormat(m_Settings.keep_depth_for_culling);
 
 		vk::AttachmentDescription& color_attachment = attachments[0];
 		vk::AttachmentDescription& depth_attachment = attachments[1];
@@ -247,7 +259,7 @@ namespace Na {
 		depth_attachment.format         = depth_format;
 		depth_attachment.samples        = VkContext::GetMSAASamples(m_Settings.msaa_enabled);
 		depth_attachment.loadOp         = vk::AttachmentLoadOp::eClear;
-		depth_attachment.storeOp        = vk::AttachmentStoreOp::eDontCare;
+		depth_attachment.storeOp        = m_Settings.keep_depth_for_culling ? vk::AttachmentStoreOp::eStore : vk::AttachmentStoreOp::eDontCare;
 		depth_attachment.stencilLoadOp  = vk::AttachmentLoadOp::eDontCare;
 		depth_attachment.stencilStoreOp = vk::AttachmentStoreOp::eDontCare;
 		depth_attachment.initialLayout  = vk::ImageLayout::eUndefined;
@@ -281,6 +293,10 @@ namespace Na {
 		dependency.srcStageMask         = vk::PipelineStageFlagBits::eColorAttachmentOutput
 			                            | vk::PipelineStageFlagBits::eLateFragmentTests;
 
+		// orders the clear after compute reads of the previous frame's depth
+		if (m_Settings.keep_depth_for_culling)
+			dependency.srcStageMask    |= vk::PipelineStageFlagBits::eComputeShader;
+
 		dependency.srcAccessMask        = vk::AccessFlagBits::eColorAttachmentWrite
 			                            | vk::AccessFlagBits::eDepthStencilAttachmentWrite;
 
@@ -397,6 +413,7 @@ namespace Na {
 
 	m_DepthImage(std::move(other.m_DepthImage)),
 	m_DepthImageView(std::exchange(other.m_DepthImageView, nullptr)),
+	m_DepthGeneration(other.m_DepthGeneration),
 
 	m_ColorImage(std::move(other.m_ColorImage)),
 	m_ColorImageView(std::exchange(other.m_ColorImageView, nullptr)),
@@ -431,6 +448,7 @@ namespace Na {
 
 		m_DepthImage = std::move(other.m_DepthImage);
 		m_DepthImageView = std::exchange(other.m_DepthImageView, nullptr);
+		m_DepthGeneration = other.m_DepthGeneration;
 
 		m_ColorImage = std::move(other.m_ColorImage);
 		m_ColorImageView = std::exchange(other.m_ColorImageView, nullptr);
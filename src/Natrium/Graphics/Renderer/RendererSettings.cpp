@@ -10,7 +10,16 @@ namespace Na {
 			.max_frames_in_flight = 2,
 			.anisotropy_enabled = true,
 			.max_anisotropy = VkContext::GetPhysicalDevice().getProperties().limits.maxSamplerAnisotropy,
-			.msaa_enabled = true
+			.msaa_enabled = true,
+			.keep_depth_for_culling = false,
+			// a material's uniforms and textures, a culling pass's buffers or a reduction's images per set
+			.frame_descriptors = {
+				.set_count = 64,
+				.uniform_buffers = 1,
+				.storage_buffers = 2,
+				.textures = 2,
+				.storage_images = 1
+			}
 		};
 	}
 } // namespace Na
@@ -2,6 +2,7 @@
 #include "Natrium/Graphics/ShaderModule.hpp"
 
 #include "Natrium/Graphics/VkContext.hpp"
+#include "Internal.hpp"
 
 namespace Na {
 	ShaderModule::ShaderModule(
@@ -16,26 +17,67 @@ namespace Na {
 				   binary.ptr()
 			   ))),
 	m_Stage(stage),
-	m_EntryPoint(entry_point)
-	{}
+	m_EntryPoint(entry_point),
+	m_Reflection(ReflectShader(binary, entry_point))
+	{
+		// lets pipelines built from identical code be shared even after the handle gets reused
+		Internal::RegisterShaderModule(m_Module, binary.ptr(), binary.size());
+	}
 
 	ShaderModule::~ShaderModule(void)
 	{
+		Internal::UnregisterShaderModule(m_Module);
 		VkContext::GetLogicalDevice().destroyShaderModule(m_Module);
 	}
 
 	ShaderModule::ShaderModule(ShaderModule&& other)
 	: m_Module(std::exchange(other.m_Module, nullptr)),
 	m_Stage(std::move(other.m_Stage)),
-	m_EntryPoint(std::move(other.m_EntryPoint))
+	m_EntryPoint(std::move(other.m_EntryPoint)),
+	m_Reflection(std::move(other.m_Reflection)),
+	m_SpecializationEntries(std::move(other.m_SpecializationEntries)),
+	m_SpecializationData(std::move(other.m_SpecializationData)),
+	m_SpecializationInfo(std::exchange(other.m_SpecializationInfo, {}))
 	{}
 
 	ShaderModule& ShaderModule::operator=(ShaderModule&& other)
 	{
+		Internal::UnregisterShaderModule(m_Module);
 		VkContext::GetLogicalDevice().destroyShaderModule(m_Module);
 		m_Module = std::exchange(other.m_Module, nullptr);
 		m_Stage = std::move(other.m_Stage);
 		m_EntryPoint = std::move(other.m_EntryPoint);
+		m_Reflection = std::move(other.m_Reflection);
+		m_SpecializationEntries = std::move(other.m_SpecializationEntries);
+		m_SpecializationData = std::move(other.m_SpecializationData);
+		m_SpecializationInfo = std::exchange(other.m_SpecializationInfo, {});
+		return *this;
+	}
+
+	ShaderModule& ShaderModule::_specialize(u32 constant_id, const void* data, u32 size)
+	{
+		auto it = std::find_if(
+			m_SpecializationEntries.begin(),
+			m_SpecializationEntries.end(),
+			[constant_id](const vk::SpecializationMapEntry& entry) { return entry.constantID == constant_id; }
+		);
+
+		if (it != m_SpecializationEntries.end())
+		{
+			NA_ASSERT(it->size == size, "Failed to specialize constant {}: size changed from {} to {}!", constant_id, it->size, size);
+			memcpy(m_SpecializationData.data() + it->offset, data, size);
+			return *this;
+		}
+
+		m_SpecializationEntries.emplace_back(constant_id, (u32)m_SpecializationData.size(), (size_t)size);
+		m_SpecializationData.insert(m_SpecializationData.end(), (const Byte*)data, (const Byte*)data + size);
+
+		m_SpecializationInfo = vk::SpecializationInfo(
+			(u32)m_SpecializationEntries.size(),
+			m_SpecializationEntries.data(),
+			m_SpecializationData.size(),
+			m_SpecializationData.data()
+		);
 		return *this;
 	}
 } // namespace Na
@@ -0,0 +1,533 @@
+#include "Pch.hpp"
+#include "Natrium/Graphics/ShaderReflection.hpp"
+
+#include "Natrium/Graphics/BindlessTextures.hpp"
+
+namespace Na {
+	// only the parts of the spir-v spec the reflection needs
+	namespace Spv {
+		static constexpr u32 k_Magic = 0x07230203;
+		static constexpr u32 k_HeaderSize = 5;
+
+		enum Op : u32 {
+			OpEntryPoint        = 15,
+			OpTypeBool          = 20,
+			OpTypeInt           = 21,
+			OpTypeFloat         = 22,
+			OpTypeVector        = 23,
+			OpTypeMatrix        = 24,
+			OpTypeImage         = 25,
+			OpTypeSampler       = 26,
+			OpTypeSampledImage  = 27,
+			OpTypeArray         = 28,
+			OpTypeRuntimeArray  = 29,
+			OpTypeStruct        = 30,
+			OpTypePointer       = 32,
+			OpConstant          = 43,
+			OpFunction          = 54,
+			OpFunctionEnd       = 56,
+			OpFunctionCall      = 57,
+			OpVariable          = 59,
+			OpDecorate          = 71,
+			OpMemberDecorate    = 72
+		};
+
+		enum Decoration : u32 {
+			Block         = 2,
+			BufferBlock   = 3,
+			ArrayStride   = 6,
+			MatrixStride  = 7,
+			BuiltIn       = 11,
+			Location      = 30,
+			Binding       = 33,
+			DescriptorSet = 34,
+			Offset        = 35
+		};
+
+		enum StorageClass : u32 {
+			UniformConstant = 0,
+			Input           = 1,
+			Uniform         = 2,
+			PushConstant    = 9,
+			StorageBuffer   = 12
+		};
+
+		struct Id {
+			u32 opcode = 0;
+			u32 word = 0; // first word of the defining instruction
+
+			u32 location = UINT32_MAX;
+			u32 binding = UINT32_MAX;
+			u32 set = 0;
+			u32 array_stride = 0;
+			bool builtin = false;
+			bool block = false;
+			bool buffer_block = false;
+		};
+
+		struct Member {
+			u32 offset = 0;
+			u32 matrix_stride = 0;
+		};
+	} // namespace Spv
+
+	class SpvModule {
+	public:
+		SpvModule(const u32* spv, u64 word_count) : m_Words(spv), m_WordCount(word_count) {}
+
+		bool parse(std::string& error)
+		{
+			if (m_WordCount < Spv::k_HeaderSize || m_Words[0] != Spv::k_Magic)
+			{
+				error = "Invalid spir-v header";
+				return false;
+			}
+
+			m_Ids.resize(m_Words[3]); // id bound
+
+			for (u64 word = Spv::k_HeaderSize; word < m_WordCount;)
+			{
+				u32 opcode = m_Words[word] & 0xffff;
+				u32 length = m_Words[word] >> 16;
+				if (!length || word + length > m_WordCount)
+				{
+					error = NA_FORMAT("Malformed instruction at word {}", word);
+					return false;
+				}
+
+				if (!this->_record(opcode, word, length))
+				{
+					error = NA_FORMAT("Id out of bounds at word {}", word);
+					return false;
+				}
+
+				word += length;
+			}
+			return true;
+		}
+
+		[[nodiscard]] inline u32 word(u64 index) const { return m_Words[index]; }
+		[[nodiscard]] inline const Spv::Id& id(u32 id) const { return m_Ids[id]; }
+		[[nodiscard]] inline u32 id_bound(void) const { return (u32)m_Ids.size(); }
+		[[nodiscard]] inline const std::vector<u64>& entry_points(void) const { return m_EntryPoints; }
+
+		///
+		/// word w of the instruction defining id, 0 if it doesn't exist
+		///
+		[[nodiscard]] inline u32 operand(u32 id, u32 w) const
+		{
+			if (id >= m_Ids.size() || !m_Ids[id].opcode)
+				return 0;
+			u64 word = m_Ids[id].word;
+			return w < (m_Words[word] >> 16) ? m_Words[word + w] : 0;
+		}
+
+		[[nodiscard]] inline u32 opcode(u32 id) const { return id < m_Ids.size() ? m_Ids[id].opcode : 0; }
+
+		///
+		/// every id an instruction of function or the functions it calls refers to, global variables
+		/// included, literal operands can mark unrelated ids as well so it's only ever too many
+		///
+		[[nodiscard]] std::vector<bool> referenced_ids(u32 function) const
+		{
+			std::vector<bool> referenced(m_Ids.size(), false);
+			std::vector<bool> visited(m_Ids.size(), false);
+
+			std::vector<u32> pending = { function };
+			while (!pending.empty())
+			{
+				u32 current = pending.back();
+				pending.pop_back();
+
+				if (this->opcode(current) != Spv::OpFunction || visited[current])
+					continue;
+				visited[current] = true;
+
+				for (u64 word = m_Ids[current].word; word < m_WordCount; word += m_Words[word] >> 16)
+				{
+					u32 opcode = m_Words[word] & 0xffff;
+					u32 length = m_Words[word] >> 16;
+					if (opcode == Spv::OpFunctionEnd)
+						break;
+
+					if (opcode == Spv::OpFunctionCall && length > 3)
+						pending.push_back(m_Words[word + 3]);
+
+					for (u32 w = 1; w < length; w++)
+						if (m_Words[word + w] < referenced.size())
+							referenced[m_Words[word + w]] = true;
+				}
+			}
+			return referenced;
+		}
+
+		[[nodiscard]] inline Spv::Member member(u32 struct_id, u32 index) const
+		{
+			auto it = m_Members.find(((u64)struct_id << 32) | index);
+			return it != m_Members.end() ? it->second : Spv::Member{};
+		}
+
+		[[nodiscard]] inline u32 member_count(u32 struct_id) const
+		{
+			if (this->opcode(struct_id) != Spv::OpTypeStruct)
+				return 0;
+			return (m_Words[m_Ids[struct_id].word] >> 16) - 2;
+		}
+
+		///
+		/// size of a type as laid out in a buffer block, matrices are assumed column major
+		///
+		u32 type_size(u32 type, u32 matrix_stride = 0) const
+		{
+			switch (this->opcode(type))
+			{
+			case Spv::OpTypeBool:
+				return 4;
+			case Spv::OpTypeInt:
+			case Spv::OpTypeFloat:
+				return this->operand(type, 2) / 8;
+			case Spv::OpTypeVector:
+				return this->type_size(this->operand(type, 2)) * this->operand(type, 3);
+			case Spv::OpTypeMatrix:
+				return (matrix_stride ? matrix_stride : this->type_size(this->operand(type, 2))) * this->operand(type, 3);
+			case Spv::OpTypeArray:
+			{
+				u32 element = this->operand(type, 2);
+				u32 length = this->operand(this->operand(type, 3), 3); // OpConstant value
+				u32 stride = m_Ids[type].array_stride ? m_Ids[type].array_stride : this->type_size(element, matrix_stride);
+				return stride * length;
+			}
+			case Spv::OpTypeStruct:
+			{
+				u32 size = 0;
+				for (u32 i = 0; i < this->member_count(type); i++)
+				{
+					Spv::Member member = this->member(type, i);
+					size = std::max(size, member.offset + this->type_size(this->operand(type, 2 + i), member.matrix_stride));
+				}
+				return size;
+			}
+			default:
+				return 0;
+			}
+		}
+	private:
+		bool _record(u32 opcode, u64 word, u32 length)
+		{
+			switch (opcode)
+			{
+			case Spv::OpEntryPoint:
+				m_EntryPoints.emplace_back(word);
+				return true;
+			case Spv::OpTypeBool:
+			case Spv::OpTypeInt:
+			case Spv::OpTypeFloat:
+			case Spv::OpTypeVector:
+			case Spv::OpTypeMatrix:
+			case Spv::OpTypeImage:
+			case Spv::OpTypeSampler:
+			case Spv::OpTypeSampledImage:
+			case Spv::OpTypeArray:
+			case Spv::OpTypeRuntimeArray:
+			case Spv::OpTypeStruct:
+			case Spv::OpTypePointer:
+				return length > 1 && this->_define(m_Words[word + 1], opcode, word);
+			case Spv::OpConstant:
+			case Spv::OpFunction:
+			case Spv::OpVariable:
+				return length > 2 && this->_define(m_Words[word + 2], opcode, word);
+			case Spv::OpDecorate:
+			{
+				if (length < 3)
+					return true;
+				if (m_Words[word + 1] >= m_Ids.size())
+					return false;
+
+				Spv::Id& id = m_Ids[m_Words[word + 1]];
+				u32 literal = length > 3 ? m_Words[word + 3] : 0;
+				switch (m_Words[word + 2])
+				{
+				case Spv::Block:         id.block = true; break;
+				case Spv::BufferBlock:   id.buffer_block = true; break;
+				case Spv::ArrayStride:   id.array_stride = literal; break;
+				case Spv::BuiltIn:       id.builtin = true; break;
+				case Spv::Location:      id.location = literal; break;
+				case Spv::Binding:       id.binding = literal; break;
+				case Spv::DescriptorSet: id.set = literal; break;
+				}
+				return true;
+			}
+			case Spv::OpMemberDecorate:
+			{
+				if (length < 5)
+					return true;
+
+				Spv::Member& member = m_Members[((u64)m_Words[word + 1] << 32) | m_Words[word + 2]];
+				if (m_Words[word + 3] == Spv::Offset)
+					member.offset = m_Words[word + 4];
+				else if (m_Words[word + 3] == Spv::MatrixStride)
+					member.matrix_stride = m_Words[word + 4];
+				return true;
+			}
+			default:
+				return true;
+			}
+		}
+
+		bool _define(u32 id, u32 opcode, u64 word)
+		{
+			if (id >= m_Ids.size())
+				return false;
+			m_Ids[id].opcode = opcode;
+			m_Ids[id].word = (u32)word;
+			return true;
+		}
+	private:
+		const u32* m_Words;
+		u64 m_WordCount;
+
+		std::vector<Spv::Id> m_Ids;
+		std::unordered_map<u64, Spv::Member> m_Members;
+		std::vector<u64> m_EntryPoints;
+	};
+
+	static ShaderStageBits executionModelStage(u32 model)
+	{
+		switch (model)
+		{
+		case 0: return ShaderStageBits::Vertex;
+		case 1: return (ShaderStageBits)(u32)vk::ShaderStageFlagBits::eTessellationControl;
+		case 2: return (ShaderStageBits)(u32)vk::ShaderStageFlagBits::eTessellationEvaluation;
+		case 3: return (ShaderStageBits)(u32)vk::ShaderStageFlagBits::eGeometry;
+		case 4: return ShaderStageBits::Fragment;
+		case 5: return ShaderStageBits::Compute;
+		default: return ShaderStageBits::None;
+		}
+	}
+
+	static ShaderAttributeType attributeType(const SpvModule& module, u32 type)
+	{
+		u32 component_count = 1;
+		if (module.opcode(type) == Spv::OpTypeVector)
+		{
+			component_count = module.operand(type, 3);
+			type = module.operand(type, 2);
+		}
+
+		if (module.opcode(type) != Spv::OpTypeFloat || module.operand(type, 2) != 32)
+			return ShaderAttributeType::None;
+
+		switch (component_count)
+		{
+		case 1: return ShaderAttributeType::Float;
+		case 2: return ShaderAttributeType::Vec2;
+		case 3: return ShaderAttributeType::Vec3;
+		case 4: return ShaderAttributeType::Vec4;
+		default: return ShaderAttributeType::None;
+		}
+	}
+
+	static ShaderUniformType uniformType(const SpvModule& module, u32 storage_class, u32 type)
+	{
+		switch (storage_class)
+		{
+		case Spv::StorageBuffer:
+			return ShaderUniformType::StorageBuffer;
+		case Spv::Uniform:
+			if (module.id(type).block)
+				return ShaderUniformType::UniformBuffer;
+			if (module.id(type).buffer_block)
+				return ShaderUniformType::StorageBuffer;
+			return ShaderUniformType::None;
+		case Spv::UniformConstant:
+			if (module.opcode(type) == Spv::OpTypeSampledImage)
+				return ShaderUniformType::Texture;
+			// OpTypeImage's sampled operand is 2 for images only read and written without a sampler
+			if (module.opcode(type) == Spv::OpTypeImage && module.operand(type, 7) == 2)
+				return ShaderUniformType::StorageImage;
+			return ShaderUniformType::None;
+		default:
+			return ShaderUniformType::None;
+		}
+	}
+
+	ShaderReflection ReflectShader(const u32* spv, u64 word_count, const std::string_view& entry_point)
+	{
+		ShaderReflection reflection;
+
+		SpvModule module(spv, word_count);
+		if (!module.parse(reflection.error))
+			return reflection;
+
+		// OpEntryPoint: model, function id, null terminated name, interface ids
+		u64 entry_word = 0;
+		u64 interface_word = 0;
+		for (u64 word : module.entry_points())
+		{
+			const char* name = (const char*)&spv[word + 3];
+			u64 name_words = strnlen(name, ((spv[word] >> 16) - 3) * sizeof(u32)) / sizeof(u32) + 1;
+
+			if (entry_point == name)
+			{
+				entry_word = word;
+				interface_word = word + 3 + name_words;
+				break;
+			}
+		}
+
+		if (!entry_word)
+		{
+			reflection.error = NA_FORMAT("Entry point {} not found", entry_point);
+			return reflection;
+		}
+
+		reflection.stage = executionModelStage(spv[entry_word + 1]);
+		u64 entry_end = entry_word + (spv[entry_word] >> 16);
+
+		u32 push_constant_begin = UINT32_MAX, push_constant_end = 0;
+
+		// before spir-v 1.4 the interface only lists inputs and outputs, so descriptors and push constants
+		// belong to the entry point if its call tree uses them
+		std::vector<bool> used = module.referenced_ids(spv[entry_word + 2]);
+
+		for (u32 variable = 0; variable < module.id_bound(); variable++)
+		{
+			const Spv::Id& id = module.id(variable);
+			if (id.opcode != Spv::OpVariable)
+				continue;
+
+			u32 storage_class = module.operand(variable, 3);
+			u32 type = module.operand(module.operand(variable, 1), 3); // pointee of the OpTypePointer
+
+			switch (storage_class)
+			{
+			case Spv::Input:
+			{
+				if (reflection.stage != ShaderStageBits::Vertex || id.builtin || id.location == UINT32_MAX)
+					break;
+
+				// before spir-v 1.4 only inputs and outputs are listed, so this is enough to tell entry points apart
+				if (std::find(&spv[interface_word], &spv[entry_end], variable) == &spv[entry_end])
+					break;
+
+				ShaderAttributeType attribute_type = attributeType(module, type);
+				if (attribute_type == ShaderAttributeType::None && reflection.valid())
+					reflection.error = NA_FORMAT("Unsupported vertex input type at location {}", id.location);
+
+				reflection.attributes.emplace_back(id.location, attribute_type);
+				break;
+			}
+			case Spv::Uniform:
+			case Spv::UniformConstant:
+			case Spv::StorageBuffer:
+			{
+				if (id.binding == UINT32_MAX || !used[variable])
+					break;
+
+				// the bindless texture table, an unsized array of combined image samplers
+				if (
+					id.set == BindlessTextures::k_Set && id.binding == 0 &&
+					module.opcode(type) == Spv::OpTypeRuntimeArray &&
+					module.opcode(module.operand(type, 2)) == Spv::OpTypeSampledImage
+				)
+				{
+					reflection.bindless_textures = true;
+					break;
+				}
+
+				if (id.set != 0 && reflection.valid())
+					reflection.error = NA_FORMAT("Descriptor set {} (binding {}) is not supported, only set 0 and the bindless texture table are", id.set, id.binding);
+
+				if (module.opcode(type) == Spv::OpTypeArray || module.opcode(type) == Spv::OpTypeRuntimeArray)
+				{
+					if (reflection.valid())
+						reflection.error = NA_FORMAT("Descriptor arrays are not supported (binding {})", id.binding);
+					break;
+				}
+
+				ShaderUniformType uniform_type = uniformType(module, storage_class, type);
+				if (uniform_type == ShaderUniformType::None && reflection.valid())
+					reflection.error = NA_FORMAT("Unsupported descriptor type at binding {}", id.binding);
+
+				if (id.set == 0)
+					reflection.uniforms.emplace_back(id.binding, uniform_type, reflection.stage);
+				break;
+			}
+			case Spv::PushConstant:
+			{
+				if (!used[variable])
+					break;
+
+				// the range starts at the block's lowest member offset, so stages can share a block
+				// whose members are laid out past the other stages' ranges
+				for (u32 i = 0; i < module.member_count(type); i++)
+					push_constant_begin = std::min(push_constant_begin, module.member(type, i).offset);
+				push_constant_end = std::max(push_constant_end, module.type_size(type));
+				break;
+			}
+			}
+		}
+
+		if (push_constant_end > push_constant_begin)
+			reflection.push_constants.emplace_back(reflection.stage, push_constant_end - push_constant_begin, push_constant_begin);
+
+		std::sort(reflection.attributes.begin(), reflection.attributes.end(),
+			[](const ShaderAttribute& a, const ShaderAttribute& b) { return a.location < b.location; });
+		std::sort(reflection.uniforms.begin(), reflection.uniforms.end(),
+			[](const ShaderUniform& a, const ShaderUniform& b) { return a.binding < b.binding; });
+
+		return reflection;
+	}
+
+	ShaderReflection MergeReflections(const ShaderReflection* const* reflections, u32 count)
+	{
+		ShaderReflection merged;
+
+		u32 push_constant_begin = UINT32_MAX, push_constant_end = 0;
+		ShaderStageBits push_constant_stages = ShaderStageBits::None;
+
+		for (u32 i = 0; i < count; i++)
+		{
+			const ShaderReflection& reflection = *reflections[i];
+			if (!reflection.valid() && merged.valid())
+				merged.error = reflection.error;
+
+			merged.stage = (ShaderStageBits)((u32)merged.stage | (u32)reflection.stage);
+			merged.bindless_textures |= reflection.bindless_textures;
+
+			if (reflection.stage == ShaderStageBits::Vertex)
+				merged.attributes = reflection.attributes;
+
+			for (const ShaderUniform& uniform : reflection.uniforms)
+			{
+				auto it = std::find_if(merged.uniforms.begin(), merged.uniforms.end(),
+					[&](const ShaderUniform& other) { return other.binding == uniform.binding; });
+
+				if (it == merged.uniforms.end())
+				{
+					merged.uniforms.emplace_back(uniform);
+					continue;
+				}
+
+				if (it->type != uniform.type && merged.valid())
+					merged.error = NA_FORMAT("Binding {} has different descriptor types in different stages", uniform.binding);
+				it->shader_stage = (ShaderStageBits)((u32)it->shader_stage | (u32)uniform.shader_stage);
+			}
+
+			for (const PushConstant& push_constant : reflection.push_constants)
+			{
+				push_constant_begin = std::min(push_constant_begin, push_constant.offset);
+				push_constant_end = std::max(push_constant_end, push_constant.offset + push_constant.size);
+				push_constant_stages = (ShaderStageBits)((u32)push_constant_stages | (u32)push_constant.shader_stage);
+			}
+		}
+
+		if (push_constant_end > push_constant_begin)
+			merged.push_constants.emplace_back(push_constant_stages, push_constant_end - push_constant_begin, push_constant_begin);
+
+		std::sort(merged.uniforms.begin(), merged.uniforms.end(),
+			[](const ShaderUniform& a, const ShaderUniform& b) { return a.binding < b.binding; });
+
+		return merged;
+	}
+} // namespace Na
@@ -0,0 +1,124 @@
+#include "Pch.hpp"
+#include "Natrium/Graphics/StagingRing.hpp"
+
+#include "Natrium/Graphics/VkContext.hpp"
+
+#include "Internal.hpp"
+
+#include <bit>
+
+namespace Na {
+	// copies out of the ring are recorded on the graphics queue as well as the transfer one
+	static vk::SharingMode sharingMode(void)
+	{
+		return VkContext::GetQueueFamilyIndices().dedicated_transfer() ? vk::SharingMode::eConcurrent : vk::SharingMode::eExclusive;
+	}
+
+	StagingRing::StagingRing(vk::DeviceSize capacity)
+	: m_Buffer(
+		capacity,
+		vk::BufferUsageFlagBits::eTransferSrc,
+		vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent,
+		sharingMode()
+	),
+	m_Capacity(capacity)
+	{
+		NA_ASSERT(std::has_single_bit(capacity), "Failed to create StagingRing: Capacity has to be a power of two!");
+	}
+
+	void StagingRing::destroy(void)
+	{
+		if (!m_Capacity)
+			return;
+
+		for (const Submission& submission : m_Submissions)
+			submission.token.wait();
+		m_Submissions.clear();
+
+		m_Buffer.destroy();
+		m_Capacity = 0;
+		m_Head = m_Tail = 0;
+	}
+
+	StagingRegion StagingRing::allocate(vk::DeviceSize size, vk::DeviceSize alignment)
+	{
+		NA_ASSERT(std::has_single_bit(alignment), "Failed to allocate staging region: Alignment has to be a power of two!");
+
+		if (size + alignment > m_Capacity)
+			this->_grow(size + alignment);
+
+		u64 position = (m_Head + alignment - 1) & ~(alignment - 1);
+
+		// regions never wrap around, the rest of the buffer is skipped instead
+		if (position % m_Capacity + size > m_Capacity)
+			position = (position / m_Capacity + 1) * m_Capacity;
+
+		while (position + size - m_Tail > m_Capacity)
+		{
+			// regions recorded into an open batch are only guarded once it's submitted
+			if (m_Submissions.empty())
+				Internal::FlushOpenBatch();
+
+			NA_ASSERT(!m_Submissions.empty(), "Failed to allocate staging region: Ring is full of unsubmitted uploads!");
+			this->_retire(true);
+		}
+
+		m_Head = position + size;
+
+		StagingRegion region;
+		region.buffer = m_Buffer.buffer;
+		region.offset = position % m_Capacity;
+		region.size = size;
+		region.data = m_Buffer.mapped() + region.offset;
+		return region;
+	}
+
+	void StagingRing::track(SubmissionToken submission)
+	{
+		this->_retire(false);
+
+		// nothing to guard
+		if (m_Submissions.empty() && m_Head == m_Tail)
+			return;
+
+		// without new regions the previous ones are shared, they may have been recorded into a batch that was
+		// flushed right before this submission and be read by both
+		m_Submissions.push_back(Submission{ submission, m_Head });
+	}
+
+	void StagingRing::_retire(bool wait)
+	{
+		if (wait && !m_Submissions.empty())
+			m_Submissions.front().token.wait();
+
+		// submissions can finish out of order, the tail only moves past the oldest ones
+		// and only once every submission sharing their regions is done
+		while (!m_Submissions.empty() && m_Submissions.front().token.complete())
+		{
+			u64 head = m_Submissions.front().head;
+			m_Submissions.pop_front();
+
+			if (m_Submissions.empty() || m_Submissions.front().head != head)
+				m_Tail = head;
+		}
+	}
+
+	void StagingRing::_grow(vk::DeviceSize min_capacity)
+	{
+		Internal::FlushOpenBatch();
+
+		while (!m_Submissions.empty())
+			this->_retire(true);
+
+		NA_ASSERT(m_Head == m_Tail, "Failed to grow StagingRing: Ring holds unsubmitted uploads!");
+
+		m_Capacity = std::bit_ceil(min_capacity);
+		m_Buffer = DeviceBuffer(
+			m_Capacity,
+			vk::BufferUsageFlagBits::eTransferSrc,
+			vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent,
+			sharingMode()
+		);
+		m_Head = m_Tail = 0;
+	}
+} // namespace Na
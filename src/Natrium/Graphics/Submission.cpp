@@ -0,0 +1,105 @@
+#include "Pch.hpp"
+#include "Natrium/Graphics/Submission.hpp"
+
+#include "Natrium/Graphics/VkContext.hpp"
+
+#include "Internal.hpp"
+
+namespace Na {
+	struct PendingSubmission {
+		u64 id;
+		vk::Fence fence;
+		std::function<void(void)> on_complete;
+	};
+
+	// VkContext is moved with memcpy, so the tracker lives here
+	static std::deque<PendingSubmission> s_PendingSubmissions;
+	static std::vector<vk::Fence> s_FreeFences;
+	static u64 s_NextSubmissionId = 1;
+
+	static std::deque<PendingSubmission>::iterator retireSubmission(std::deque<PendingSubmission>::iterator it)
+	{
+		if (it->on_complete)
+			it->on_complete();
+
+		(void)VkContext::GetLogicalDevice().resetFences(1, &it->fence);
+		s_FreeFences.push_back(it->fence);
+		return s_PendingSubmissions.erase(it);
+	}
+
+	static std::deque<PendingSubmission>::iterator findSubmission(u64 id)
+	{
+		return std::find_if(s_PendingSubmissions.begin(), s_PendingSubmissions.end(),
+			[id](const PendingSubmission& submission) { return submission.id == id; });
+	}
+
+	bool SubmissionToken::complete(void) const
+	{
+		auto it = findSubmission(this->id);
+		if (it == s_PendingSubmissions.end())
+			return true;
+
+		if (VkContext::GetLogicalDevice().getFenceStatus(it->fence) != vk::Result::eSuccess)
+			return false;
+
+		retireSubmission(it);
+		return true;
+	}
+
+	void SubmissionToken::wait(void) const
+	{
+		auto it = findSubmission(this->id);
+		if (it == s_PendingSubmissions.end())
+			return;
+
+		(void)VkContext::GetLogicalDevice().waitForFences(1, &it->fence, VK_TRUE, UINT64_MAX);
+		retireSubmission(it);
+	}
+
+	std::pair<SubmissionToken, vk::Fence> Internal::TrackSubmission(std::function<void(void)> on_complete)
+	{
+		Internal::RetireSubmissions();
+
+		vk::Fence fence;
+		if (s_FreeFences.empty())
+		{
+			fence = VkContext::GetLogicalDevice().createFence(vk::FenceCreateInfo());
+		} else
+		{
+			fence = s_FreeFences.back();
+			s_FreeFences.pop_back();
+		}
+
+		SubmissionToken token{ s_NextSubmissionId++ };
+		s_PendingSubmissions.push_back(PendingSubmission{ token.id, fence, std::move(on_complete) });
+		return { token, fence };
+	}
+
+	SubmissionToken Internal::LatestSubmission(void)
+	{
+		return SubmissionToken{ s_NextSubmissionId - 1 };
+	}
+
+	void Internal::RetireSubmissions(void)
+	{
+		vk::Device logical_device = VkContext::GetLogicalDevice();
+
+		for (auto it = s_PendingSubmissions.begin(); it != s_PendingSubmissions.end();)
+		{
+			if (logical_device.getFenceStatus(it->fence) == vk::Result::eSuccess)
+				it = retireSubmission(it);
+			else
+				it++;
+		}
+	}
+
+	void Internal::ShutdownSubmissions(void)
+	{
+		while (!s_PendingSubmissions.empty())
+			SubmissionToken{ s_PendingSubmissions.front().id }.wait();
+
+		for (vk::Fence fence : s_FreeFences)
+			VkContext::GetLogicalDevice().destroyFence(fence);
+		s_FreeFences.clear();
+	}
+} // namespace Na
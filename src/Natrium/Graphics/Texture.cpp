@@ -1,16 +1,114 @@
 #include "Pch.hpp"
 #include "Natrium/Graphics/Texture.hpp"
 
-#include "Natrium/Graphics/Buffers/DeviceBuffer.hpp"
+#include "Natrium/Graphics/StagingRing.hpp"
 #include "Natrium/Graphics/VkContext.hpp"
 #include "Natrium/Graphics/Pipeline.hpp"
+#include "Natrium/Graphics/MipChain.hpp"
+#include "Natrium/Core/Logger.hpp"
 #include "Internal.hpp"
 
 namespace Na {
+	///
+	/// vulkan has no 16 bit srgb formats, 16 bit srgb images are decoded to linear while staging instead
+	///
+	static vk::Format uncompressedFormat(u32 channels, u32 channel_size, bool srgb)
+	{
+		if (channel_size == 2)
+			switch (channels)
+			{
+			case 1: return vk::Format::eR16Unorm;
+			case 2: return vk::Format::eR16G16Unorm;
+			case 4: return vk::Format::eR16G16B16A16Unorm;
+			}
+		else
+			switch (channels)
+			{
+			case 1: return srgb ? vk::Format::eR8Srgb : vk::Format::eR8Unorm;
+			case 2: return srgb ? vk::Format::eR8G8Srgb : vk::Format::eR8G8Unorm;
+			case 4: return srgb ? vk::Format::eR8G8B8A8Srgb : vk::Format::eR8G8B8A8Unorm;
+			}
+
+		throw std::runtime_error(NA_FORMAT("Failed to create Texture: Unsupported channel count {}!", channels));
+	}
+
+	static bool isSampleable(vk::Format format)
+	{
+		return FindSupportedFormat({ format }, vk::ImageTiling::eOptimal, vk::FormatFeatureFlagBits::eSampledImage) != vk::Format::eUndefined;
+	}
+
+	static ArrayVector<u16> srgbToLinearTable(void)
+	{
+		ArrayVector<u16> table(UINT16_MAX + 1);
+		for (u32 i = 0; i <= UINT16_MAX; i++)
+		{
+			float c = i / (float)UINT16_MAX;
+			c = c <= 0.04045f ? c / 12.92f : powf((c + 0.055f) / 1.055f, 2.4f);
+			table[i] = (u16)(c * UINT16_MAX + 0.5f);
+		}
+		return table;
+	}
+
+	static vk::ComponentMapping channelSwizzle(u32 channels)
+	{
+		using Swizzle = vk::ComponentSwizzle;
+		switch (channels)
+		{
+		case 1: return { Swizzle::eR, Swizzle::eR, Swizzle::eR, Swizzle::eOne }; // grey
+		case 2: return { Swizzle::eR, Swizzle::eR, Swizzle::eR, Swizzle::eG }; // grey + alpha
+		default: return {};
+		}
+	}
+
+	///
+	/// copies an image into dst, narrowing 16 bit channels and expanding grey (+ alpha) to rgba if needed,
+	/// to_linear decodes the color channels of 16 bit destinations (see srgbToLinearTable)
+	///
+	static void convertTexels(const Image& img, Byte* dst, u32 dst_channels, u32 dst_channel_size, const u16* to_linear)
+	{
+		u32 channels = img.channels();
+		u32 channel_size = img.channel_size();
+		u64 texel_count = (u64)img.width() * img.height();
+
+		// grey + alpha or rgba
+		u32 dst_alpha = (dst_channels == 2 || dst_channels == 4) ? dst_channels - 1 : UINT32_MAX;
+
+		if (channels == dst_channels && channel_size == dst_channel_size && !to_linear)
+		{
+			memcpy(dst, img.data(), img.size());
+			return;
+		}
+
+		const Byte* src = (const Byte*)img.data();
+		for (u64 i = 0; i < texel_count; i++)
+		{
+			for (u32 c = 0; c < dst_channels; c++)
+			{
+				// grey is replicated into rgb, alpha comes from the last channel or is opaque
+				u32 src_c = c;
+				if (channels < dst_channels)
+					src_c = c < 3 ? 0 : (channels == 2 ? 1 : UINT32_MAX);
+
+				u16 value = UINT16_MAX;
+				if (src_c != UINT32_MAX)
+					value = channel_size == 2
+						? ((const u16*)src)[i * channels + src_c]
+						: (u16)(src[i * channels + src_c] * 257);
+
+				if (dst_channel_size == 2)
+					((u16*)dst)[i * dst_channels + c] = (to_linear && c != dst_alpha) ? to_linear[value] : value;
+				else
+					dst[i * dst_channels + c] = (u8)(value >> 8);
+			}
+		}
+	}
+
 	Texture::Texture(
 		const AssetHandle<Image>* imgs,
 		u32 count,
-		const RendererSettings& renderer_settings
+		const RendererSettings& renderer_settings,
+		BlockFormat compression,
+		ColorSpace color_space
 	)
 	{
 		NA_ASSERT(imgs, "Failed to create TextureArray: imgs is null!");
@@ -29,39 +127,228 @@ namespace Na {
 
 				if (imgs[i]->size() != first_img->size())
 					throw std::runtime_error("Failed to create TextureArray: Image at index {} has a different size!");
+
+				if (imgs[i]->channels() != first_img->channels() || imgs[i]->channel_size() != first_img->channel_size())
+					throw std::runtime_error(NA_FORMAT("Failed to create TextureArray: Image at index {} has a different texel format!", i));
 			}
 		}
 
-		vk::Device logical_device = VkContext::GetLogicalDevice();
+		u32 width = (u32)first_img->width();
+		u32 height = (u32)first_img->height();
 
-		DeviceBuffer buffer(
-			first_img->size() * count,
-			vk::BufferUsageFlagBits::eTransferSrc,
-			vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent
-		);
+		// two channel blocks are never color
+		if (compression == BlockFormat::BC5)
+			color_space = ColorSpace::Linear;
+		bool srgb = color_space == ColorSpace::Srgb;
+
+		if (compression != BlockFormat::None && !IsBlockFormatSupported(compression, srgb))
+		{
+			g_Logger.fmt(Warn, "Block format {} is not supported by the device, creating an uncompressed texture instead!", (u32)compression);
+			compression = BlockFormat::None;
+		}
+
+		// the block encoders only take rgba8
+		u32 channels = compression == BlockFormat::None ? first_img->channels() : 4;
+		u32 channel_size = compression == BlockFormat::None ? first_img->channel_size() : 1;
 
-		void* data = logical_device.mapMemory(buffer.memory, 0, first_img->size() * count);
-		for (u32 i = 0; i < count; i++)
-			memcpy((Byte*)data + i * first_img->size(), imgs[i]->data(), imgs[i]->size());
-		logical_device.unmapMemory(buffer.memory);
+		vk::Format format = compression == BlockFormat::None
+			? uncompressedFormat(channels, channel_size, srgb)
+			: BlockFormatToVk(compression, srgb);
+
+		// 16 bit formats are optional for sampling, the narrowed texels keep their encoding
+		if (channel_size == 2 && !isSampleable(format))
+		{
+			g_Logger.fmt(Warn, "Format {} is not supported by the device, narrowing the texture to 8 bits per channel!", (u32)format);
+			channel_size = 1;
+			format = uncompressedFormat(channels, channel_size, srgb);
+		}
+
+		// single and dual channel srgb formats are optional as well, rgba always works
+		if (channels < 4 && !isSampleable(format))
+		{
+			channels = 4;
+			format = uncompressedFormat(channels, channel_size, srgb);
+		}
+
+		ArrayVector<u16> to_linear;
+		if (srgb && channel_size == 2)
+			to_linear = srgbToLinearTable();
+
+		u32 texel_size = channels * channel_size;
+		u64 layer_size = (u64)width * height * texel_size;
 
 		m_Image = DeviceImage(
-			{ (u32)first_img->width(), (u32)first_img->height(), 1 }, // extent
+			{ width, height, 1 }, // extent
 			count, // layer count
 			vk::ImageAspectFlagBits::eColor,
-			vk::Format::eR8G8B8A8Srgb,
+			format,
 			vk::ImageTiling::eOptimal,
-			vk::ImageUsageFlagBits::eTransferDst | vk::ImageUsageFlagBits::eSampled,
+			vk::ImageUsageFlagBits::eTransferSrc | vk::ImageUsageFlagBits::eTransferDst | vk::ImageUsageFlagBits::eSampled,
 			vk::SharingMode::eExclusive,
 			vk::SampleCountFlagBits::e1,
-			vk::MemoryPropertyFlagBits::eDeviceLocal
+			vk::MemoryPropertyFlagBits::eDeviceLocal,
+			MipLevelCount(width, height)
 		);
 
+		// compressed formats and formats that can't be blitted get their whole chain built on the cpu
+		bool gpu_mipmaps = compression == BlockFormat::None && m_Image.supports_blit_mipmaps();
+
+		u64 buffer_size = 0;
+		if (gpu_mipmaps)
+			buffer_size = layer_size * count;
+		else if (compression == BlockFormat::None)
+			buffer_size = MipChainSize(width, height, m_Image.mip_levels(), count, texel_size);
+		else
+			for (u32 level = 0; level < m_Image.mip_levels(); level++)
+				buffer_size += CompressedSize(MipExtent(width, level), MipExtent(height, level), compression) * count;
+
+		// transitioned before staging, so the region is only read by the copy it's fenced with
 		m_Image.transition_layout(vk::ImageLayout::eUndefined, vk::ImageLayout::eTransferDstOptimal);
-		m_Image.copy_all_from_buffer(buffer.buffer);
-		m_Image.transition_layout(vk::ImageLayout::eTransferDstOptimal, vk::ImageLayout::eShaderReadOnlyOptimal);
 
-		buffer.destroy();
+		StagingRegion region = VkContext::GetStagingRing().allocate(buffer_size);
+		void* data = region.data;
+		if (gpu_mipmaps)
+		{
+			for (u32 i = 0; i < count; i++)
+				convertTexels(*imgs[i], (Byte*)data + i * layer_size, channels, channel_size, to_linear.ptr());
+		} else
+		{
+			// mapped memory is usually uncached, so the chain is built in host memory first
+			u64 chain_size = MipChainSize(width, height, m_Image.mip_levels(), count, texel_size);
+			Na::ArrayVector<Byte> chain(chain_size);
+			for (u32 i = 0; i < count; i++)
+				convertTexels(*imgs[i], chain.ptr() + i * layer_size, channels, channel_size, to_linear.ptr());
+
+			GenerateMipChain(
+				chain.ptr(),
+				width, height,
+				m_Image.mip_levels(),
+				count,
+				channels,
+				channel_size,
+				srgb && channel_size == 1 // 16 bit texels are linear by now
+			);
+
+			if (compression == BlockFormat::None)
+			{
+				memcpy(data, chain.ptr(), buffer_size);
+			} else
+			{
+				const Byte* src = chain.ptr();
+				Byte* dst = (Byte*)data;
+				for (u32 level = 0; level < m_Image.mip_levels(); level++)
+				{
+					u32 level_width = MipExtent(width, level);
+					u32 level_height = MipExtent(height, level);
+
+					for (u32 i = 0; i < count; i++)
+					{
+						CompressBlocks(src, level_width, level_height, compression, dst);
+
+						src += (u64)level_width * level_height * 4;
+						dst += CompressedSize(level_width, level_height, compression);
+					}
+				}
+			}
+		}
+		if (gpu_mipmaps)
+		{
+			m_Image.copy_from_buffer(region.buffer, 0, count, region.offset);
+			m_Image.generate_mipmaps();
+		} else
+		{
+			m_Image.copy_mips_from_buffer(region.buffer, texel_size, region.offset);
+			m_Image.transition_layout(vk::ImageLayout::eTransferDstOptimal, vk::ImageLayout::eShaderReadOnlyOptimal);
+		}
+
+		m_ImageView = m_Image.create_img_view(channelSwizzle(channels));
+
+		m_Sampler = Internal::CreateSampler(
+			vk::Filter::eLinear, // oversampling filter
+			vk::Filter::eLinear, // undersampling filter
+			renderer_settings.anisotropy_enabled,
+			renderer_settings.max_anisotropy
+		);
+	}
+
+	Texture::Texture(
+		AssetHandle<Ktx2Asset> ktx,
+		const RendererSettings& renderer_settings,
+		u32 skip_levels
+	)
+	{
+		NA_ASSERT(ktx && *ktx, "Failed to create Texture: Invalid KTX2 asset!");
+		NA_VERIFY(
+			FindSupportedFormat({ ktx->format() }, vk::ImageTiling::eOptimal, vk::FormatFeatureFlagBits::eSampledImage) != vk::Format::eUndefined,
+			"Failed to create Texture: KTX2 format {} is not supported by the device!",
+				(u32)ktx->format()
+		);
+
+		// never skip past the smallest level
+		skip_levels = std::min(skip_levels, ktx->level_count() - 1);
+
+		u32 width = MipExtent(ktx->width(), skip_levels);
+		u32 height = MipExtent(ktx->height(), skip_levels);
+		u32 level_count = ktx->level_count() - skip_levels;
+
+		bool generate_mips = ktx->wants_generated_mips() && FindSupportedFormat(
+			{ ktx->format() },
+			vk::ImageTiling::eOptimal,
+			vk::FormatFeatureFlagBits::eBlitSrc | vk::FormatFeatureFlagBits::eBlitDst | vk::FormatFeatureFlagBits::eSampledImageFilterLinear
+		) != vk::Format::eUndefined;
+
+		m_Image = DeviceImage(
+			{ width, height, 1 }, // extent
+			ktx->layer_count(),
+			vk::ImageAspectFlagBits::eColor,
+			ktx->format(),
+			vk::ImageTiling::eOptimal,
+			vk::ImageUsageFlagBits::eTransferSrc | vk::ImageUsageFlagBits::eTransferDst | vk::ImageUsageFlagBits::eSampled,
+			vk::SharingMode::eExclusive,
+			vk::SampleCountFlagBits::e1,
+			vk::MemoryPropertyFlagBits::eDeviceLocal,
+			generate_mips ? MipLevelCount(width, height) : level_count,
+			// the faces are plain array layers until a view says otherwise
+			ktx->is_cubemap() ? vk::ImageCreateFlagBits::eCubeCompatible : vk::ImageCreateFlags()
+		);
+
+		u64 buffer_size = 0;
+		for (u32 level = skip_levels; level < ktx->level_count(); level++)
+			buffer_size += ktx->level_size(level);
+
+		// without generated mips nothing else has to run on the graphics queue, so the copy
+		// goes out on the transfer queue and the texture can be drawn with right away
+		if (generate_mips)
+			m_Image.transition_layout(vk::ImageLayout::eUndefined, vk::ImageLayout::eTransferDstOptimal);
+
+		StagingRegion staging = VkContext::GetStagingRing().allocate(buffer_size);
+		Na::ArrayVector<vk::BufferImageCopy> regions(level_count);
+
+		// only the requested levels of the mapped file are ever touched
+		for (u64 offset = 0, i = 0; i < regions.size(); i++)
+		{
+			u32 level = skip_levels + (u32)i;
+			memcpy(staging.data + offset, ktx->level_data(level), ktx->level_size(level));
+
+			regions[i].bufferOffset = staging.offset + offset;
+			regions[i].imageSubresource = vk::ImageSubresourceLayers(
+				vk::ImageAspectFlagBits::eColor,
+				(u32)i, // mip level
+				0, // base layer
+				ktx->layer_count()
+			);
+			regions[i].imageExtent = vk::Extent3D(MipExtent(width, (u32)i), MipExtent(height, (u32)i), 1);
+
+			offset += ktx->level_size(level);
+		}
+		if (generate_mips)
+		{
+			m_Image.copy_regions_from_buffer(staging.buffer, regions.ptr(), (u32)regions.size());
+			m_Image.generate_mipmaps();
+		} else
+		{
+			(void)m_Image.copy_regions_from_buffer_async(staging.buffer, regions.ptr(), (u32)regions.size());
+		}
 
 		m_ImageView = m_Image.create_img_view();
 
@@ -78,12 +365,14 @@ namespace Na {
 		if (!m_Image)
 			return;
 
-		vk::Device logical_device = VkContext::GetLogicalDevice();
-
-		logical_device.destroySampler(m_Sampler);
+		// a pending async upload is covered as well, the image is destroyed after the views
+		VkContext::DeferDestruction([sampler = m_Sampler, image_view = m_ImageView](void)
+		{
+			vk::Device logical_device = VkContext::GetLogicalDevice();
+			logical_device.destroySampler(sampler);
+			logical_device.destroyImageView(image_view);
+		});
 		m_Sampler = nullptr;
-
-		logical_device.destroyImageView(m_ImageView);
 		m_ImageView = nullptr;
 
 		m_Image.destroy();
@@ -2,6 +2,9 @@
 #include "Natrium/Graphics/VkContext.hpp"
 
 #include "Natrium/Core/Logger.hpp"
+#include "Natrium/Graphics/StagingRing.hpp"
+
+#include "Internal.hpp"
 
 #define GLFW_INCLUDE_VULKAN
 #include <GLFW/glfw3.h>
@@ -110,16 +113,33 @@ namespace Na {
 		QueueFamilyIndices indices;
 		for (u32 i = 0; const auto& property : properties)
 		{
-			if (property.queueFlags & vk::QueueFlagBits::eGraphics)
+			if (!indices && property.queueFlags & vk::QueueFlagBits::eGraphics)
 				if (device.getSurfaceSupportKHR(i, surface))
 					indices.graphics = i;
 
-			if (indices)
-				break;
+			i++;
+		}
+
+		// transfer only families are backed by the copy engines, compute families without graphics come second
+		u32 transfer_score = 0;
+		for (u32 i = 0; const auto& property : properties)
+		{
+			u32 score = 0;
+			if ((property.queueFlags & vk::QueueFlagBits::eTransfer) && !(property.queueFlags & vk::QueueFlagBits::eGraphics))
+				score = (property.queueFlags & vk::QueueFlagBits::eCompute) ? 1 : 2;
+
+			if (score > transfer_score)
+			{
+				indices.transfer = i;
+				transfer_score = score;
+			}
 
 			i++;
 		}
 
+		if (!transfer_score)
+			indices.transfer = indices.graphics;
+
 		return indices;
 	}
 
@@ -187,8 +207,9 @@ namespace Na {
 		if (k_ValidationLayersEnabled && !validationLayersSupported())
 			throw std::runtime_error("Validation layers requested, but not supported!");
 
+		// 1.1 for vkGetPhysicalDeviceFeatures2, which descriptor indexing is queried with
 		vk::ApplicationInfo app_info;
-		app_info.apiVersion = VK_API_VERSION_1_0;
+		app_info.apiVersion = VK_API_VERSION_1_1;
 
 		vk::InstanceCreateInfo create_info;
 		create_info.pApplicationInfo = &app_info;
@@ -280,40 +301,204 @@ namespace Na {
 		return create_info;
 	}
 
-	static vk::Device createLogicalDevice(vk::PhysicalDevice physical_device, QueueFamilyIndices queue_indices, vk::Queue& queue)
+	static bool isDeviceExtensionSupported(vk::PhysicalDevice physical_device, const std::string_view& name)
+	{
+		auto available_extensions = physical_device.enumerateDeviceExtensionProperties();
+		return std::any_of(available_extensions.begin(), available_extensions.end(),
+			[&](const vk::ExtensionProperties& extension) { return std::string_view(extension.extensionName) == name; });
+	}
+
+	static bool descriptorIndexingSupported(vk::PhysicalDevice physical_device)
+	{
+		if (physical_device.getProperties().apiVersion < VK_API_VERSION_1_1)
+			return false;
+
+		if (!isDeviceExtensionSupported(physical_device, VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME))
+			return false;
+
+		vk::PhysicalDeviceDescriptorIndexingFeaturesEXT indexing_features;
+		vk::PhysicalDeviceFeatures2 features;
+		features.pNext = &indexing_features;
+		physical_device.getFeatures2(&features);
+
+		return indexing_features.shaderSampledImageArrayNonUniformIndexing
+			&& indexing_features.descriptorBindingSampledImageUpdateAfterBind
+			&& indexing_features.descriptorBindingUpdateUnusedWhilePending
+			&& indexing_features.descriptorBindingPartiallyBound
+			&& indexing_features.runtimeDescriptorArray;
+	}
+
+	// what the device was created with beyond the required features and extensions
+	struct OptionalDeviceFeatures {
+		bool bindless = false;
+		bool multi_draw_indirect = false;
+		bool draw_indirect_first_instance = false;
+		bool draw_indirect_count = false;
+	};
+
+	static vk::Device createLogicalDevice(
+		vk::PhysicalDevice physical_device,
+		QueueFamilyIndices queue_indices,
+		vk::Queue& queue,
+		vk::Queue& transfer_queue,
+		OptionalDeviceFeatures& optional_features
+	)
 	{
 		Na::ArrayList<vk::DeviceQueueCreateInfo> queue_create_infos;
 		queue_create_infos.emplace(createQueueCreateInfo(queue_indices.graphics));
+		if (queue_indices.dedicated_transfer())
+			queue_create_infos.emplace(createQueueCreateInfo(queue_indices.transfer));
 
 		vk::DeviceCreateInfo create_info;
 
 		create_info.queueCreateInfoCount = (u32)queue_create_infos.size();
 		create_info.pQueueCreateInfos = queue_create_infos.ptr();
 
+		vk::PhysicalDeviceFeatures supported_features = physical_device.getFeatures();
+
 		vk::PhysicalDeviceFeatures device_features{};
 		device_features.samplerAnisotropy = VK_TRUE;
 		device_features.sampleRateShading = VK_TRUE;
+		device_features.textureCompressionBC = supported_features.textureCompressionBC;
+
+		// indirect draws with more than one command
+		optional_features.multi_draw_indirect = supported_features.multiDrawIndirect;
+		device_features.multiDrawIndirect = optional_features.multi_draw_indirect;
+
+		// indirect commands with a first instance other than 0
+		optional_features.draw_indirect_first_instance = supported_features.drawIndirectFirstInstance;
+		device_features.drawIndirectFirstInstance = optional_features.draw_indirect_first_instance;
 		create_info.pEnabledFeatures = &device_features;
 
-		create_info.enabledExtensionCount = (u32)requiredDeviceExtensions.size();
-		create_info.ppEnabledExtensionNames = requiredDeviceExtensions.ptr();
+		Na::ArrayList<const char*> device_extensions(requiredDeviceExtensions);
+
+		optional_features.draw_indirect_count = isDeviceExtensionSupported(physical_device, VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME);
+		if (optional_features.draw_indirect_count)
+			device_extensions.emplace(VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME);
+
+		// optional, only what bindless textures need is turned on
+		vk::PhysicalDeviceDescriptorIndexingFeaturesEXT indexing_features;
+		optional_features.bindless = descriptorIndexingSupported(physical_device);
+		if (optional_features.bindless)
+		{
+			indexing_features.shaderSampledImageArrayNonUniformIndexing = VK_TRUE;
+			indexing_features.descriptorBindingSampledImageUpdateAfterBind = VK_TRUE;
+			indexing_features.descriptorBindingUpdateUnusedWhilePending = VK_TRUE;
+			indexing_features.descriptorBindingPartiallyBound = VK_TRUE;
+			indexing_features.runtimeDescriptorArray = VK_TRUE;
+			create_info.pNext = &indexing_features;
+
+			device_extensions.emplace(VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME);
+		}
+
+		create_info.enabledExtensionCount = (u32)device_extensions.size();
+		create_info.ppEnabledExtensionNames = device_extensions.ptr();
 
 		vk::Device device = physical_device.createDevice(create_info);
 		queue = device.getQueue(queue_indices.graphics, 0);
+		transfer_queue = device.getQueue(queue_indices.transfer, 0);
 
 		return device;
 	}
 
-	static vk::CommandPool createSingleTimeCmdPool(vk::Device device, QueueFamilyIndices indices)
+	static vk::CommandPool createSingleTimeCmdPool(vk::Device device, u32 queue_family)
 	{
 		vk::CommandPoolCreateInfo single_time_pool_info;
-		single_time_pool_info.queueFamilyIndex = indices.graphics;
+		single_time_pool_info.queueFamilyIndex = queue_family;
 		single_time_pool_info.flags = vk::CommandPoolCreateFlagBits::eTransient;
 
 		return device.createCommandPool(single_time_pool_info);
 	}
 
-	VkContext VkContext::Initialize(void)
+	static constexpr vk::DeviceSize k_DeviceMemoryBlockSize = 64ull * 1024 * 1024;
+	static constexpr vk::DeviceSize k_StagingRingSize = 32ull * 1024 * 1024;
+
+	// VkContext is moved with memcpy, so the path can't be a member
+	static std::filesystem::path s_PipelineCachePath;
+
+	struct DeferredDestruction {
+		u64 frame; // the first frame submitted after it was deferred
+		SubmissionToken submission; // the latest submission at that point
+		std::function<void(void)> destroy;
+	};
+
+	static std::deque<DeferredDestruction> s_DeferredDestructions;
+	static u64 s_NextFrameSerial = 1;
+
+	static void runDeferredDestructions(void)
+	{
+		// moved out first, the callbacks can defer more work
+		std::deque<DeferredDestruction> destructions = std::move(s_DeferredDestructions);
+		s_DeferredDestructions.clear();
+
+		for (DeferredDestruction& destruction : destructions)
+			destruction.destroy();
+	}
+
+	// wraps the driver's blob, which doesn't record the driver version itself
+	struct PipelineCacheHeader {
+		u32 magic;
+		u32 version;
+		u32 vendor_id;
+		u32 device_id;
+		u32 driver_version;
+		u32 reserved; // keeps the struct free of padding, so it can be memcmp'd
+		u8 uuid[VK_UUID_SIZE];
+		u64 data_size;
+	};
+	static_assert(sizeof(PipelineCacheHeader) == 48);
+	static constexpr u32 k_PipelineCacheMagic = 0x4350414e; // "NAPC"
+	static constexpr u32 k_PipelineCacheVersion = 1;
+
+	static PipelineCacheHeader pipelineCacheHeader(vk::PhysicalDevice physical_device, u64 data_size)
+	{
+		vk::PhysicalDeviceProperties properties = physical_device.getProperties();
+
+		PipelineCacheHeader header{};
+		header.magic = k_PipelineCacheMagic;
+		header.version = k_PipelineCacheVersion;
+		header.vendor_id = properties.vendorID;
+		header.device_id = properties.deviceID;
+		header.driver_version = properties.driverVersion;
+		memcpy(header.uuid, properties.pipelineCacheUUID.data(), VK_UUID_SIZE);
+		header.data_size = data_size;
+		return header;
+	}
+
+	static vk::PipelineCache createPipelineCache(vk::Device device, vk::PhysicalDevice physical_device, const std::filesystem::path& path)
+	{
+		std::vector<char> data;
+
+		std::ifstream file(path, std::ios::ate | std::ios::binary);
+		if (file && (u64)file.tellg() >= sizeof(PipelineCacheHeader))
+		{
+			u64 file_size = (u64)file.tellg();
+			file.seekg(0);
+
+			PipelineCacheHeader header;
+			file.read((char*)&header, sizeof(header));
+
+			// a driver update or a different gpu invalidates everything in the cache
+			PipelineCacheHeader expected = pipelineCacheHeader(physical_device, file_size - sizeof(header));
+			if (!memcmp(&header, &expected, sizeof(header)))
+			{
+				data.resize(header.data_size);
+				file.read(data.data(), data.size());
+				g_Logger.fmt(Info, "Loaded pipeline cache ({} bytes)", data.size());
+			} else
+			{
+				g_Logger(Warn, "Pipeline cache was created by a different device or driver, starting with an empty one!");
+			}
+		}
+
+		vk::PipelineCacheCreateInfo create_info;
+		create_info.initialDataSize = data.size();
+		create_info.pInitialData = data.data();
+
+		return device.createPipelineCache(create_info);
+	}
+
+	VkContext VkContext::Initialize(const std::filesystem::path& pipeline_cache_path)
 	{
 		VkContext context;
 		s_Context = &context;
@@ -330,8 +515,34 @@ namespace Na {
 		auto queue_indices = QueueFamilyIndices::Get(context.m_PhysicalDevice, temp_surface);
 
 		context.m_MSAASamples = getMaxSampleCount(context.m_PhysicalDevice);
-		context.m_LogicalDevice = createLogicalDevice(context.m_PhysicalDevice, queue_indices, context.m_GraphicsQueue);
-		context.m_SingleTimeCmdPool = createSingleTimeCmdPool(context.m_LogicalDevice, queue_indices);
+		context.m_DeviceApiVersion = context.m_PhysicalDevice.getProperties().apiVersion;
+		context.m_QueueIndices = queue_indices;
+		OptionalDeviceFeatures optional_features;
+		context.m_LogicalDevice = createLogicalDevice(
+			context.m_PhysicalDevice,
+			queue_indices,
+			context.m_GraphicsQueue, context.m_TransferQueue,
+			optional_features
+		);
+		context.m_BindlessSupported = optional_features.bindless;
+		context.m_MultiDrawIndirectSupported = optional_features.multi_draw_indirect;
+		context.m_DrawIndirectFirstInstanceSupported = optional_features.draw_indirect_first_instance;
+		if (optional_features.draw_indirect_count)
+		{
+			context.m_CmdDrawIndexedIndirectCount = (PFN_vkCmdDrawIndexedIndirectCountKHR)vkGetDeviceProcAddr(
+				context.m_LogicalDevice,
+				"vkCmdDrawIndexedIndirectCountKHR"
+			);
+		}
+		context.m_SingleTimeCmdPool = createSingleTimeCmdPool(context.m_LogicalDevice, queue_indices.graphics);
+		if (queue_indices.dedicated_transfer())
+			context.m_TransferCmdPool = createSingleTimeCmdPool(context.m_LogicalDevice, queue_indices.transfer);
+
+		s_PipelineCachePath = pipeline_cache_path;
+		context.m_PipelineCache = createPipelineCache(context.m_LogicalDevice, context.m_PhysicalDevice, pipeline_cache_path);
+
+		context.m_Allocator = new DeviceAllocator(k_DeviceMemoryBlockSize);
+		context.m_StagingRing = new StagingRing(k_StagingRingSize);
 
 		vkDestroySurfaceKHR(context.m_Instance, temp_surface, nullptr);
 		glfwDestroyWindow(temp_window);
@@ -341,9 +552,33 @@ namespace Na {
 
 	void VkContext::Shutdown(void)
 	{
+		Internal::ShutdownPipelineCompiler();
+
+		if (s_Context->m_PipelineCache)
+		{
+			VkContext::SavePipelineCache();
+			s_Context->m_LogicalDevice.destroyPipelineCache(s_Context->m_PipelineCache);
+		}
+		s_PipelineCachePath.clear();
+
+		s_Context->m_LogicalDevice.waitIdle();
+		Internal::ShutdownBindlessTextures();
+
+		// the ring's buffer is deferred as well, the allocator has to outlive both
+		delete std::exchange(s_Context->m_StagingRing, nullptr);
+		while (!s_DeferredDestructions.empty())
+			runDeferredDestructions();
+		delete std::exchange(s_Context->m_Allocator, nullptr);
+
+		// frees the command buffers still held by finished uploads, so it goes before the pools
+		Internal::ShutdownSubmissions();
+
 		if (s_Context->m_SingleTimeCmdPool)
 			s_Context->m_LogicalDevice.destroyCommandPool(s_Context->m_SingleTimeCmdPool);
 
+		if (s_Context->m_TransferCmdPool)
+			s_Context->m_LogicalDevice.destroyCommandPool(s_Context->m_TransferCmdPool);
+
 		if (s_Context->m_LogicalDevice)
 			s_Context->m_LogicalDevice.destroy();
 
@@ -356,11 +591,72 @@ namespace Na {
 		s_Context = nullptr;
 	}
 
-	vk::CommandBuffer VkContext::BeginSingleTimeCommands(void)
+	void VkContext::SavePipelineCache(void)
+	{
+		if (s_PipelineCachePath.empty() || !s_Context->m_PipelineCache)
+			return;
+
+		std::vector<u8> data = s_Context->m_LogicalDevice.getPipelineCacheData(s_Context->m_PipelineCache);
+		PipelineCacheHeader header = pipelineCacheHeader(s_Context->m_PhysicalDevice, data.size());
+
+		// written under a temporary name first so a crash never leaves a truncated cache behind
+		std::filesystem::path temp_path = s_PipelineCachePath;
+		temp_path += ".tmp";
+
+		std::ofstream file(temp_path, std::ios::binary);
+		if (!file)
+		{
+			g_Logger.fmt(Warn, "Failed to save pipeline cache to {}", s_PipelineCachePath.string());
+			return;
+		}
+
+		file.write((const char*)&header, sizeof(header));
+		file.write((const char*)data.data(), data.size());
+		file.close();
+
+		std::error_code error;
+		std::filesystem::rename(temp_path, s_PipelineCachePath, error);
+		if (error)
+			g_Logger.fmt(Warn, "Failed to save pipeline cache to {}: {}", s_PipelineCachePath.string(), error.message());
+	}
+
+	void VkContext::WaitForRemainingDeviceTasks(void)
+	{
+		s_Context->m_LogicalDevice.waitIdle();
+
+		while (!s_DeferredDestructions.empty())
+			runDeferredDestructions();
+	}
+
+	void VkContext::DeferDestruction(std::function<void(void)> destroy)
+	{
+		s_DeferredDestructions.push_back(DeferredDestruction{ s_NextFrameSerial, Internal::LatestSubmission(), std::move(destroy) });
+	}
+
+	u64 Internal::AdvanceFrameSerial(void)
+	{
+		return s_NextFrameSerial++;
+	}
+
+	void Internal::RetireDeferredDestructions(u64 completed_frame)
+	{
+		// every fence is signaled on the graphics queue, so later frames and submissions
+		// completing means the earlier ones have as well
+		while (!s_DeferredDestructions.empty()
+			&& s_DeferredDestructions.front().frame <= completed_frame
+			&& s_DeferredDestructions.front().submission.complete())
+		{
+			std::function<void(void)> destroy = std::move(s_DeferredDestructions.front().destroy);
+			s_DeferredDestructions.pop_front();
+			destroy();
+		}
+	}
+
+	static vk::CommandBuffer beginOneTimeCommands(vk::CommandPool cmd_pool)
 	{
 		vk::CommandBufferAllocateInfo alloc_info;
 		alloc_info.level = vk::CommandBufferLevel::ePrimary;
-		alloc_info.commandPool = s_Context->m_SingleTimeCmdPool;
+		alloc_info.commandPool = cmd_pool;
 		alloc_info.commandBufferCount = 1;
 
 		vk::CommandBuffer cmd_buffer;
@@ -374,18 +670,204 @@ namespace Na {
 		return cmd_buffer;
 	}
 
+	vk::CommandBuffer VkContext::BeginSingleTimeCommands(void)
+	{
+		if (vk::CommandBuffer batch_cmd_buffer = Internal::OpenBatchCmdBuffer())
+			return batch_cmd_buffer;
+
+		return beginOneTimeCommands(s_Context->m_SingleTimeCmdPool);
+	}
+
 	void VkContext::EndSingleTimeCommands(vk::CommandBuffer cmd_buffer)
 	{
+		if (cmd_buffer == Internal::OpenBatchCmdBuffer())
+			return;
+
+		// only waits on its own fence, frames in flight keep running
+		VkContext::SubmitSingleTimeCommands(cmd_buffer).wait();
+	}
+
+	SubmissionToken VkContext::SubmitSingleTimeCommands(vk::CommandBuffer cmd_buffer)
+	{
+		// nothing waits for uploads anymore, so later submissions on the queue have to see the copies' writes
+		vk::MemoryBarrier upload_barrier(vk::AccessFlagBits::eTransferWrite, vk::AccessFlagBits::eMemoryRead);
+		cmd_buffer.pipelineBarrier(
+			vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eAllCommands, {},
+			1, &upload_barrier,
+			0, nullptr,
+			0, nullptr
+		);
 		cmd_buffer.end();
 
 		vk::SubmitInfo submit_info;
 		submit_info.commandBufferCount = 1;
 		submit_info.pCommandBuffers = &cmd_buffer;
 
-		(void)VkContext::GetGraphicsQueue().submit(1, &submit_info, nullptr);
-		VkContext::GetGraphicsQueue().waitIdle();
+		vk::CommandPool single_time_pool = s_Context->m_SingleTimeCmdPool;
+
+		// the token tells the staging ring when the regions this read from can be reused
+		auto [token, fence] = Internal::TrackSubmission([=](void)
+		{
+			VkContext::GetLogicalDevice().freeCommandBuffers(single_time_pool, 1, &cmd_buffer);
+		});
+		(void)VkContext::GetGraphicsQueue().submit(1, &submit_info, fence);
+		VkContext::GetStagingRing().track(token);
+
+		return token;
+	}
+
+	vk::CommandBuffer VkContext::BeginTransferCommands(void)
+	{
+		return beginOneTimeCommands(s_Context->m_QueueIndices.dedicated_transfer() ? s_Context->m_TransferCmdPool : s_Context->m_SingleTimeCmdPool);
+	}
+
+	// the stages that can perform the given accesses, so the graphics queue only waits for a transfer where it's used
+	static vk::PipelineStageFlags accessStages(vk::AccessFlags access)
+	{
+		constexpr vk::PipelineStageFlags shader_stages = vk::PipelineStageFlagBits::eVertexShader
+			| vk::PipelineStageFlagBits::eFragmentShader
+			| vk::PipelineStageFlagBits::eComputeShader;
+
+		vk::PipelineStageFlags stages;
+		if (access & vk::AccessFlagBits::eIndirectCommandRead)
+			stages |= vk::PipelineStageFlagBits::eDrawIndirect;
+		if (access & (vk::AccessFlagBits::eIndexRead | vk::AccessFlagBits::eVertexAttributeRead))
+			stages |= vk::PipelineStageFlagBits::eVertexInput;
+		if (access & (vk::AccessFlagBits::eUniformRead | vk::AccessFlagBits::eShaderRead | vk::AccessFlagBits::eShaderWrite))
+			stages |= shader_stages;
+		if (access & (vk::AccessFlagBits::eTransferRead | vk::AccessFlagBits::eTransferWrite))
+			stages |= vk::PipelineStageFlagBits::eTransfer;
+		// generic reads can come from any of the above
+		if (access & vk::AccessFlagBits::eMemoryRead)
+		{
+			stages |= vk::PipelineStageFlagBits::eDrawIndirect | vk::PipelineStageFlagBits::eVertexInput
+				| shader_stages | vk::PipelineStageFlagBits::eTransfer;
+		}
+		return stages;
+	}
+
+	SubmissionToken VkContext::EndTransferCommands(
+		vk::CommandBuffer cmd_buffer,
+		const vk::BufferMemoryBarrier* buffer_barriers,
+		u32 buffer_barrier_count,
+		const vk::ImageMemoryBarrier* image_barriers,
+		u32 image_barrier_count
+	)
+	{
+		// the staging ring claims every region up to its head for the next tracked submission, so regions recorded
+		// into an open batch are submitted first, the ones before ours end up guarded by both submissions
+		Internal::FlushOpenBatch();
 
-		VkContext::GetLogicalDevice().freeCommandBuffers(s_Context->m_SingleTimeCmdPool, 1, &cmd_buffer);
+		vk::Device logical_device = VkContext::GetLogicalDevice();
+		QueueFamilyIndices indices = s_Context->m_QueueIndices;
+		vk::CommandPool single_time_pool = s_Context->m_SingleTimeCmdPool;
+
+		Na::ArrayVector<vk::BufferMemoryBarrier> buffer_releases(buffer_barriers, buffer_barrier_count);
+		Na::ArrayVector<vk::ImageMemoryBarrier> image_releases(image_barriers, image_barrier_count);
+
+		if (!indices.dedicated_transfer())
+		{
+			for (vk::BufferMemoryBarrier& barrier : buffer_releases)
+				barrier.srcQueueFamilyIndex = barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			for (vk::ImageMemoryBarrier& barrier : image_releases)
+				barrier.srcQueueFamilyIndex = barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+
+			cmd_buffer.pipelineBarrier(
+				vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eAllCommands, {},
+				0, nullptr,
+				(u32)buffer_releases.size(), buffer_releases.ptr(),
+				(u32)image_releases.size(), image_releases.ptr()
+			);
+			cmd_buffer.end();
+
+			auto [token, fence] = Internal::TrackSubmission([=](void)
+			{
+				VkContext::GetLogicalDevice().freeCommandBuffers(single_time_pool, 1, &cmd_buffer);
+			});
+
+			vk::SubmitInfo submit_info;
+			submit_info.commandBufferCount = 1;
+			submit_info.pCommandBuffers = &cmd_buffer;
+			(void)VkContext::GetGraphicsQueue().submit(1, &submit_info, fence);
+
+			VkContext::GetStagingRing().track(token);
+			return token;
+		}
+
+		// the releasing queue ignores the dst access and the acquiring one the src access
+		Na::ArrayVector<vk::BufferMemoryBarrier> buffer_acquires(buffer_barriers, buffer_barrier_count);
+		Na::ArrayVector<vk::ImageMemoryBarrier> image_acquires(image_barriers, image_barrier_count);
+		for (u64 i = 0; i < buffer_releases.size(); i++)
+		{
+			buffer_releases[i].dstAccessMask = {};
+			buffer_acquires[i].srcAccessMask = {};
+			buffer_releases[i].srcQueueFamilyIndex = buffer_acquires[i].srcQueueFamilyIndex = indices.transfer;
+			buffer_releases[i].dstQueueFamilyIndex = buffer_acquires[i].dstQueueFamilyIndex = indices.graphics;
+		}
+		vk::PipelineStageFlags acquire_stages;
+		for (const vk::BufferMemoryBarrier& barrier : buffer_acquires)
+			acquire_stages |= accessStages(barrier.dstAccessMask);
+		for (const vk::ImageMemoryBarrier& barrier : image_acquires)
+			acquire_stages |= accessStages(barrier.dstAccessMask);
+		NA_ASSERT(acquire_stages, "Failed to end transfer commands: Barriers have no dst access!");
+
+		for (u64 i = 0; i < image_releases.size(); i++)
+		{
+			image_releases[i].dstAccessMask = {};
+			image_acquires[i].srcAccessMask = {};
+			image_releases[i].srcQueueFamilyIndex = image_acquires[i].srcQueueFamilyIndex = indices.transfer;
+			image_releases[i].dstQueueFamilyIndex = image_acquires[i].dstQueueFamilyIndex = indices.graphics;
+		}
+
+		cmd_buffer.pipelineBarrier(
+			vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eBottomOfPipe, {},
+			0, nullptr,
+			(u32)buffer_releases.size(), buffer_releases.ptr(),
+			(u32)image_releases.size(), image_releases.ptr()
+		);
+		cmd_buffer.end();
+
+		// never the open batch's command buffer, this one is submitted and freed right away
+		vk::CommandBuffer acquire_cmd_buffer = beginOneTimeCommands(single_time_pool);
+		// src stage matches the semaphore wait so the acquire can't run ahead of the release, later submissions
+		// only stall at the stages that use the data instead of waiting for the transfer as a whole
+		acquire_cmd_buffer.pipelineBarrier(
+			acquire_stages, acquire_stages, {},
+			0, nullptr,
+			(u32)buffer_acquires.size(), buffer_acquires.ptr(),
+			(u32)image_acquires.size(), image_acquires.ptr()
+		);
+		acquire_cmd_buffer.end();
+
+		vk::Semaphore transfer_done = logical_device.createSemaphore(vk::SemaphoreCreateInfo());
+		vk::CommandPool transfer_pool = s_Context->m_TransferCmdPool;
+
+		vk::SubmitInfo transfer_submit_info;
+		transfer_submit_info.commandBufferCount = 1;
+		transfer_submit_info.pCommandBuffers = &cmd_buffer;
+		transfer_submit_info.signalSemaphoreCount = 1;
+		transfer_submit_info.pSignalSemaphores = &transfer_done;
+		(void)VkContext::GetTransferQueue().submit(1, &transfer_submit_info, nullptr);
+
+		// the acquire waits on the transfer, so its fence covers both halves
+		auto [token, fence] = Internal::TrackSubmission([=](void)
+		{
+			vk::Device logical_device = VkContext::GetLogicalDevice();
+			logical_device.freeCommandBuffers(transfer_pool, 1, &cmd_buffer);
+			logical_device.freeCommandBuffers(single_time_pool, 1, &acquire_cmd_buffer);
+			logical_device.destroySemaphore(transfer_done);
+		});
+
+		vk::SubmitInfo acquire_submit_info;
+		acquire_submit_info.waitSemaphoreCount = 1;
+		acquire_submit_info.pWaitSemaphores = &transfer_done;
+		acquire_submit_info.pWaitDstStageMask = &acquire_stages;
+		acquire_submit_info.commandBufferCount = 1;
+		acquire_submit_info.pCommandBuffers = &acquire_cmd_buffer;
+		(void)VkContext::GetGraphicsQueue().submit(1, &acquire_submit_info, fence);
+
+		VkContext::GetStagingRing().track(token);
+		return token;
 	}
 
 	VkContext::VkContext(VkContext&& other)
@@ -20,7 +20,7 @@ namespace Na {
 		descriptor_write.dstArrayElement = 0;
 
 		descriptor_write.descriptorType = type;
-		descriptor_write.descriptorCount = 1;
+		descriptor_write.descriptorCount = count;
 
 		descriptor_write.pBufferInfo = buffer_info;
 		descriptor_write.pImageInfo = image_info;
@@ -32,6 +32,14 @@ namespace Na {
 		);
 	}
 
+	void Internal::WriteToDescriptorSets(const vk::WriteDescriptorSet* writes, u32 write_count)
+	{
+		VkContext::GetLogicalDevice().updateDescriptorSets(
+			write_count, writes,
+			0, nullptr // descriptor copy
+		);
+	}
+
 	vk::Sampler Internal::CreateSampler(
 		vk::Filter oversampling_filter,
 		vk::Filter undersampling_filter,
@@ -61,7 +69,7 @@ namespace Na {
 		create_info.mipmapMode = vk::SamplerMipmapMode::eLinear;
 		create_info.mipLodBias = 0.0f;
 		create_info.minLod = 0.0f;
-		create_info.maxLod = 0.0f;
+		create_info.maxLod = VK_LOD_CLAMP_NONE;
 
 		return VkContext::GetLogicalDevice().createSampler(create_info);
 	}
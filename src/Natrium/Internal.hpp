@@ -1,6 +1,8 @@
 #if !defined(NA_RENDERER_INTERNAL_HPP)
 #define NA_RENDERER_INTERNAL_HPP
 
+#include "Natrium/Graphics/Submission.hpp"
+
 namespace Na::Internal {
 	void WriteToDescriptorSet(
 		vk::DescriptorSet set,
@@ -12,12 +14,94 @@ namespace Na::Internal {
 		vk::BufferView* texel_buffer_view = nullptr
 	);
 
+	/// 
+	/// every write in one updateDescriptorSets call
+	/// 
+	void WriteToDescriptorSets(const vk::WriteDescriptorSet* writes, u32 write_count);
+
 	vk::Sampler CreateSampler(
 		vk::Filter oversampling_filter,
 		vk::Filter undersampling_filter,
 		bool anisotropy_enabled,
 		float max_anisotropy
 	);
+
+	/// 
+	/// identical layouts are shared between pipelines, every acquire has to be matched by a release
+	/// 
+	vk::DescriptorSetLayout AcquireDescriptorSetLayout(const vk::DescriptorSetLayoutBinding* bindings, u32 binding_count);
+	void ReleaseDescriptorSetLayout(vk::DescriptorSetLayout layout);
+
+	vk::PipelineLayout AcquirePipelineLayout(
+		const vk::DescriptorSetLayout* set_layouts,
+		u32 set_layout_count,
+		const vk::PushConstantRange* push_constant_ranges,
+		u32 push_constant_range_count
+	);
+	void ReleasePipelineLayout(vk::PipelineLayout layout);
+
+	/// 
+	/// a copy of a module's spir-v (size in bytes), pipelines are keyed by it instead of the reusable handle
+	/// 
+	void RegisterShaderModule(vk::ShaderModule module, const void* code, u64 size);
+	void UnregisterShaderModule(vk::ShaderModule module);
+
+	/// 
+	/// pipelines created from identical state (shaders, specialization, vertex input, fixed function state,
+	/// layout and render pass) share one vk::Pipeline
+	/// 
+	vk::Pipeline AcquireGraphicsPipeline(const vk::GraphicsPipelineCreateInfo& create_info);
+	void ReleaseGraphicsPipeline(vk::Pipeline pipeline);
+
+	/// 
+	/// same for compute pipelines, keyed by the shader stage and layout
+	/// 
+	vk::Pipeline AcquireComputePipeline(const vk::ComputePipelineCreateInfo& create_info);
+	void ReleaseComputePipeline(vk::Pipeline pipeline);
+
+	/// 
+	/// joins the background pipeline compile workers, builds that are still queued are dropped
+	/// 
+	void ShutdownPipelineCompiler(void);
+
+	/// 
+	/// destroys the bindless texture table if it was ever used, the device has to be idle
+	/// 
+	void ShutdownBindlessTextures(void);
+
+	/// 
+	/// hands out a fence to submit with, on_complete runs on the thread that notices the fence signaled
+	/// (a later TrackSubmission, RetireSubmissions or the token itself)
+	/// 
+	std::pair<SubmissionToken, vk::Fence> TrackSubmission(std::function<void(void)> on_complete = {});
+	void RetireSubmissions(void);
+
+	/// 
+	/// token of the most recent TrackSubmission, completes once everything tracked so far has
+	/// 
+	SubmissionToken LatestSubmission(void);
+
+	/// 
+	/// waits for every tracked submission and destroys the fences
+	/// 
+	void ShutdownSubmissions(void);
+
+	/// 
+	/// the command buffer of the open CommandBatch, null if there is none
+	/// 
+	vk::CommandBuffer OpenBatchCmdBuffer(void);
+
+	/// 
+	/// submits the open CommandBatch's commands so far, false if there is none
+	/// 
+	bool FlushOpenBatch(void);
+
+	/// 
+	/// numbers the submitted frame, deferred destructions are retired by frame number
+	/// once its fence has been waited on
+	/// 
+	u64 AdvanceFrameSerial(void);
+	void RetireDeferredDestructions(u64 completed_frame);
 } // namespace Na::Internal
 
 #endif // NA_RENDERER_INTERNAL_HPP
\ No newline at end of file